@@ -0,0 +1,63 @@
+#version 420 core
+out vec4 FragColor;
+
+in vec3 TexCoordLayer; // atlas-remapped uv + array layer
+flat in vec4 Tint;     // material base colour
+in vec3 WorldPos;
+in vec3 Normal;
+flat in float Roughness;
+
+// Must match ClusteredLights::ClustersX/Y/Z
+const int ClustersX = 16;
+const int ClustersY = 9;
+const int ClustersZ = 24;
+const float Ambient = 0.08;
+
+uniform sampler2DArray diffuseArray;
+uniform samplerBuffer lightData;     // per light: position + radius, colour
+uniform usamplerBuffer clusterGrid;  // per cluster: offset, count
+uniform usamplerBuffer lightIndices; // light ids, grouped by cluster
+
+uniform mat4 view;
+uniform vec3 viewPos;
+uniform vec2 tileScale; // clusters per pixel
+uniform float sliceScale;
+uniform float sliceBias;
+
+void main()
+{
+    vec4 albedo = texture(diffuseArray, TexCoordLayer) * Tint;
+
+    // Same slicing as ClusteredLights::Assign
+    float depth = -(view * vec4(WorldPos, 1.0)).z;
+    ivec2 tile = min(ivec2(gl_FragCoord.xy * tileScale), ivec2(ClustersX - 1, ClustersY - 1));
+    int slice = clamp(int(floor(log(depth) * sliceScale + sliceBias)), 0, ClustersZ - 1);
+    uvec2 cluster = texelFetch(clusterGrid, (slice * ClustersY + tile.y) * ClustersX + tile.x).xy;
+
+    vec3 N = normalize(Normal);
+    vec3 V = normalize(viewPos - WorldPos);
+    float shininess = exp2(10.0 * (1.0 - Roughness));
+
+    vec3 color = albedo.rgb * Ambient;
+    for (uint i = 0u; i < cluster.y; i++) {
+        int light = int(texelFetch(lightIndices, int(cluster.x + i)).x);
+        vec4 positionRadius = texelFetch(lightData, light * 2);
+        vec3 toLight = positionRadius.xyz - WorldPos;
+        float distance2 = dot(toLight, toLight);
+        float radius2 = positionRadius.w * positionRadius.w;
+        if (distance2 >= radius2)
+            continue;
+
+        vec3 L = toLight * inversesqrt(max(distance2, 1e-8));
+        float NdotL = max(dot(N, L), 0.0);
+        // Smooth window so the light reaches exactly zero at its radius
+        float falloff = 1.0 - distance2 / radius2;
+        falloff *= falloff;
+        float specular = pow(max(dot(N, normalize(L + V)), 0.0), shininess) * 0.25;
+
+        vec3 lightColor = texelFetch(lightData, light * 2 + 1).rgb;
+        color += lightColor * falloff * NdotL * (albedo.rgb + specular);
+    }
+
+    FragColor = vec4(color, albedo.a);
+}
@@ -0,0 +1,6 @@
+#version 420 core
+
+// Depth pre-pass: no colour output, so the fragment stage does no work
+void main()
+{
+}
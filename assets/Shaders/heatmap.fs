@@ -0,0 +1,9 @@
+#version 420 core
+out vec4 FragColor;
+
+uniform vec4 color; // band colour, see OverdrawMeter::HeatColor
+
+void main()
+{
+    FragColor = color;
+}
@@ -0,0 +1,33 @@
+#version 420 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in mat4 aModel;   // per instance, locations 3-6
+layout (location = 7) in uint aMaterial; // per instance
+
+#include "surface.glsl"
+
+#include "materials.glsl"
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform samplerBuffer textureSlots; // per slot: uv rect, layer
+
+#include "vertexwork.glsl"
+
+void main()
+{
+    MaterialRecord material = materials[aMaterial];
+    int slot = int(material.diffuseSlot);
+    vec4 rect = texelFetch(textureSlots, slot * 2);
+    float layer = texelFetch(textureSlots, slot * 2 + 1).x;
+
+    vec4 world = aModel * vec4(aPos, 1.0);
+    world = VertexWork(world, aNormal, aPos, view);
+    gl_Position = projection * view * world;
+    WorldPos = world.xyz;
+    Normal = mat3(aModel) * aNormal;
+    TexCoordLayer = vec3(rect.xy + aTexCoord * rect.zw, layer);
+    Tint = material.baseColor;
+    Roughness = material.roughness;
+}
@@ -0,0 +1,34 @@
+#version 420 core
+// Sends each triangle to the layer of the view its instance was culled for
+layout (triangles) in;
+layout (triangle_strip, max_vertices = 3) out;
+
+in Pulled {
+    vec3 TexCoordLayer;
+    flat vec4 Tint;
+    vec3 WorldPos;
+    vec3 Normal;
+    flat float Roughness;
+    flat int View;
+} inVertex[];
+
+#include "surface.glsl"
+
+// Must match MultiViewSettings::MaxViews
+uniform mat4 viewProjections[6];
+
+void main()
+{
+    int view = inVertex[0].View;
+    for (int i = 0; i < 3; i++) {
+        gl_Layer = view;
+        gl_Position = viewProjections[view] * vec4(inVertex[i].WorldPos, 1.0);
+        TexCoordLayer = inVertex[i].TexCoordLayer;
+        Tint = inVertex[i].Tint;
+        WorldPos = inVertex[i].WorldPos;
+        Normal = inVertex[i].Normal;
+        Roughness = inVertex[i].Roughness;
+        EmitVertex();
+    }
+    EndPrimitive();
+}
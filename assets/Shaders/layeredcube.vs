@@ -0,0 +1,47 @@
+#version 420 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in uint aInstance; // per instance: object << 3 | view
+
+// Passed to layeredcube.gs, which projects into the view's layer
+out Pulled {
+    vec3 TexCoordLayer;
+    flat vec4 Tint;
+    vec3 WorldPos;
+    vec3 Normal;
+    flat float Roughness;
+    flat int View;
+} outVertex;
+
+#include "materials.glsl"
+
+uniform mat4 view; // first view; only the vertex work reads it
+uniform samplerBuffer textureSlots;       // per slot: uv rect, layer
+uniform samplerBuffer instanceMatrices;   // per object: four model matrix columns
+uniform usamplerBuffer instanceMaterials; // per object: material index
+
+#include "vertexwork.glsl"
+
+void main()
+{
+    int object = int(aInstance >> 3);
+    int column = object * 4;
+    mat4 aModel = mat4(texelFetch(instanceMatrices, column),
+                       texelFetch(instanceMatrices, column + 1),
+                       texelFetch(instanceMatrices, column + 2),
+                       texelFetch(instanceMatrices, column + 3));
+    MaterialRecord material = materials[texelFetch(instanceMaterials, object).x];
+    int slot = int(material.diffuseSlot);
+    vec4 rect = texelFetch(textureSlots, slot * 2);
+    float layer = texelFetch(textureSlots, slot * 2 + 1).x;
+
+    vec4 world = aModel * vec4(aPos, 1.0);
+    world = VertexWork(world, aNormal, aPos, view);
+    outVertex.WorldPos = world.xyz;
+    outVertex.Normal = mat3(aModel) * aNormal;
+    outVertex.TexCoordLayer = vec3(rect.xy + aTexCoord * rect.zw, layer);
+    outVertex.Tint = material.baseColor;
+    outVertex.Roughness = material.roughness;
+    outVertex.View = int(aInstance & 7u);
+}
@@ -0,0 +1,12 @@
+// Material table shared by every strategy; included, not compiled alone
+struct MaterialRecord {
+    vec4 baseColor;
+    float roughness;
+    float metallic;
+    uint diffuseSlot;
+    uint flags;
+};
+// Must match MaterialTable::MaxMaterials and BindingPoint
+layout (std140, binding = 0) uniform Materials {
+    MaterialRecord materials[512];
+};
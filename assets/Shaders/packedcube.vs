@@ -0,0 +1,59 @@
+#version 420 core
+// Like pulledcube.vs, but each object is one 16-byte RGBA32UI texel:
+//   x: position.x | position.y << 16, unorm16 over the bounds
+//   y: position.z unorm16 | material index << 16
+//   z: rotation quaternion, four snorm8
+//   w: log2 scale, three 8-bit steps of 1/16 from -8, plus 8 spare bits
+// Must match PackedRenderer::PackInstance
+
+#include "surface.glsl"
+
+#include "materials.glsl"
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform samplerBuffer textureSlots;    // per slot: uv rect, layer
+uniform samplerBuffer cubeVertices;    // per vertex: position + normal.x, normal.yz + uv
+uniform usamplerBuffer packedInstances;
+uniform vec3 boundsMin;                // position range of the packed objects
+uniform vec3 boundsExtent;
+
+#include "vertexwork.glsl"
+
+void main()
+{
+    vec4 v0 = texelFetch(cubeVertices, gl_VertexID * 2);
+    vec4 v1 = texelFetch(cubeVertices, gl_VertexID * 2 + 1);
+    vec3 aPos = v0.xyz;
+    vec3 aNormal = vec3(v0.w, v1.xy);
+    vec2 aTexCoord = v1.zw;
+
+    uvec4 instance = texelFetch(packedInstances, gl_InstanceID);
+    vec2 xy = unpackUnorm2x16(instance.x);
+    vec3 position = boundsMin + vec3(xy, float(instance.y & 0xffffu) / 65535.0) * boundsExtent;
+    uint materialIndex = instance.y >> 16;
+    vec4 q = unpackSnorm4x8(instance.z);
+    q /= length(q);
+    vec3 scale = exp2(vec3(uvec3(instance.w, instance.w >> 8, instance.w >> 16) & 0xffu) / 16.0 - 8.0);
+
+    // Rotate, then scale, as ComposeTransform does
+    mat3 rotation = mat3(
+        1.0 - 2.0 * (q.y * q.y + q.z * q.z), 2.0 * (q.x * q.y + q.w * q.z), 2.0 * (q.x * q.z - q.w * q.y),
+        2.0 * (q.x * q.y - q.w * q.z), 1.0 - 2.0 * (q.x * q.x + q.z * q.z), 2.0 * (q.y * q.z + q.w * q.x),
+        2.0 * (q.x * q.z + q.w * q.y), 2.0 * (q.y * q.z - q.w * q.x), 1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+    mat3 basis = mat3(rotation[0] * scale.x, rotation[1] * scale.y, rotation[2] * scale.z);
+
+    MaterialRecord material = materials[materialIndex];
+    int slot = int(material.diffuseSlot);
+    vec4 rect = texelFetch(textureSlots, slot * 2);
+    float layer = texelFetch(textureSlots, slot * 2 + 1).x;
+
+    vec4 world = vec4(basis * aPos + position, 1.0);
+    world = VertexWork(world, aNormal, aPos, view);
+    gl_Position = projection * view * world;
+    WorldPos = world.xyz;
+    Normal = basis * aNormal;
+    TexCoordLayer = vec3(rect.xy + aTexCoord * rect.zw, layer);
+    Tint = material.baseColor;
+    Roughness = material.roughness;
+}
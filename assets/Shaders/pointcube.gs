@@ -0,0 +1,63 @@
+#version 420 core
+// Expands one point into the faces of a unit cube that face the camera, at
+// most three of the six, each a four-vertex strip
+layout (points) in;
+layout (triangle_strip, max_vertices = 12) out;
+
+in mat4 vModel[];
+flat in uint vMaterial[];
+
+#include "surface.glsl"
+
+#include "materials.glsl"
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 cameraPosition;
+uniform samplerBuffer textureSlots; // per slot: uv rect, layer
+
+#include "vertexwork.glsl"
+
+// Per face: outward normal, then the u and v axes with cross(u, v) = normal
+const vec3 Faces[18] = vec3[](
+    vec3( 1, 0, 0), vec3(0, 1, 0), vec3(0, 0, 1),
+    vec3(-1, 0, 0), vec3(0, 0, 1), vec3(0, 1, 0),
+    vec3( 0, 1, 0), vec3(0, 0, 1), vec3(1, 0, 0),
+    vec3( 0,-1, 0), vec3(1, 0, 0), vec3(0, 0, 1),
+    vec3( 0, 0, 1), vec3(1, 0, 0), vec3(0, 1, 0),
+    vec3( 0, 0,-1), vec3(0, 1, 0), vec3(1, 0, 0));
+
+void main()
+{
+    mat4 model = vModel[0];
+    mat3 basis = mat3(model);
+    MaterialRecord material = materials[vMaterial[0]];
+    int slot = int(material.diffuseSlot);
+    vec4 rect = texelFetch(textureSlots, slot * 2);
+    float layer = texelFetch(textureSlots, slot * 2 + 1).x;
+    mat4 viewProjection = projection * view;
+
+    for (int f = 0; f < 6; f++) {
+        vec3 n = Faces[f * 3], u = Faces[f * 3 + 1], v = Faces[f * 3 + 2];
+        // World-space face normal that stays correct under non-uniform scale
+        vec3 worldNormal = cross(basis * u, basis * v);
+        vec3 center = (model * vec4(0.5 * n, 1.0)).xyz;
+        if (dot(worldNormal, cameraPosition - center) <= 0.0)
+            continue;
+
+        for (int corner = 0; corner < 4; corner++) {
+            vec2 st = vec2(corner & 1, corner >> 1);
+            vec3 aPos = 0.5 * n + (st.x - 0.5) * u + (st.y - 0.5) * v;
+            vec4 world = model * vec4(aPos, 1.0);
+            world = VertexWork(world, n, aPos, view);
+            gl_Position = viewProjection * world;
+            WorldPos = world.xyz;
+            Normal = basis * n;
+            TexCoordLayer = vec3(rect.xy + st * rect.zw, layer);
+            Tint = material.baseColor;
+            Roughness = material.roughness;
+            EmitVertex();
+        }
+        EndPrimitive();
+    }
+}
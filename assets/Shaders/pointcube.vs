@@ -0,0 +1,14 @@
+#version 420 core
+// One point per object; pointcube.gs expands it into the cube
+layout (location = 0) in mat4 aModel;   // locations 0-3
+layout (location = 4) in uint aMaterial;
+
+out mat4 vModel;
+flat out uint vMaterial;
+
+void main()
+{
+    vModel = aModel;
+    vMaterial = aMaterial;
+    gl_Position = aModel[3];
+}
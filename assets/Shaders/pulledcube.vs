@@ -0,0 +1,46 @@
+#version 420 core
+// No vertex attributes: the cube vertex comes from gl_VertexID and the
+// object from gl_InstanceID, both fetched from buffer textures
+
+#include "surface.glsl"
+
+#include "materials.glsl"
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform samplerBuffer textureSlots;       // per slot: uv rect, layer
+uniform samplerBuffer cubeVertices;       // per vertex: position + normal.x, normal.yz + uv
+uniform samplerBuffer instanceMatrices;   // per object: four model matrix columns
+uniform usamplerBuffer instanceMaterials; // per object: material index
+
+#include "vertexwork.glsl"
+
+void main()
+{
+    vec4 v0 = texelFetch(cubeVertices, gl_VertexID * 2);
+    vec4 v1 = texelFetch(cubeVertices, gl_VertexID * 2 + 1);
+    vec3 aPos = v0.xyz;
+    vec3 aNormal = vec3(v0.w, v1.xy);
+    vec2 aTexCoord = v1.zw;
+
+    int column = gl_InstanceID * 4;
+    mat4 aModel = mat4(texelFetch(instanceMatrices, column),
+                       texelFetch(instanceMatrices, column + 1),
+                       texelFetch(instanceMatrices, column + 2),
+                       texelFetch(instanceMatrices, column + 3));
+    uint aMaterial = texelFetch(instanceMaterials, gl_InstanceID).x;
+
+    MaterialRecord material = materials[aMaterial];
+    int slot = int(material.diffuseSlot);
+    vec4 rect = texelFetch(textureSlots, slot * 2);
+    float layer = texelFetch(textureSlots, slot * 2 + 1).x;
+
+    vec4 world = aModel * vec4(aPos, 1.0);
+    world = VertexWork(world, aNormal, aPos, view);
+    gl_Position = projection * view * world;
+    WorldPos = world.xyz;
+    Normal = mat3(aModel) * aNormal;
+    TexCoordLayer = vec3(rect.xy + aTexCoord * rect.zw, layer);
+    Tint = material.baseColor;
+    Roughness = material.roughness;
+}
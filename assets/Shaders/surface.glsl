@@ -0,0 +1,10 @@
+// Outputs of the stage that feeds texarray.fs, clustered.fs and depthonly.fs
+
+// The depth pre-pass and the GL_EQUAL shading pass must produce identical depth
+invariant gl_Position;
+
+out vec3 TexCoordLayer;
+flat out vec4 Tint;
+out vec3 WorldPos;         // read by clustered.fs only
+out vec3 Normal;
+flat out float Roughness;
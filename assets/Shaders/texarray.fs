@@ -0,0 +1,12 @@
+#version 420 core
+out vec4 FragColor;
+
+in vec3 TexCoordLayer; // atlas-remapped uv + array layer
+flat in vec4 Tint;     // material base colour
+
+uniform sampler2DArray diffuseArray;
+
+void main()
+{
+    FragColor = texture(diffuseArray, TexCoordLayer) * Tint;
+}
@@ -0,0 +1,13 @@
+// Synthetic vertex load for the bottleneck classifier
+uniform int vertexWork; // extra ALU passes per vertex, 0 normally
+
+// The branch never runs, but the compiler cannot prove it, so the loop stays
+vec4 VertexWork(vec4 world, vec3 normal, vec3 position, mat4 viewMatrix)
+{
+    vec3 work = normal;
+    for (int i = 0; i < vertexWork; i++)
+        work = normalize(mat3(viewMatrix) * work + position);
+    if (work.x > 2.0)
+        world.x += 1.0;
+    return world;
+}
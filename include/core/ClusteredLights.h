@@ -0,0 +1,116 @@
+#ifndef CLUSTERED_LIGHTS_H
+#define CLUSTERED_LIGHTS_H
+
+#include "tools/GpuResources.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Shader;
+struct RenderCounters;
+
+// Point lights for clustered forward shading. The view frustum is split into
+// ClustersX x ClustersY screen tiles and ClustersZ exponential depth slices;
+// every frame Assign() bins each light into the clusters its sphere can reach
+// and Upload() sends a per-cluster (offset, count) grid plus one flat light
+// index list. The fragment shader finds its cluster from gl_FragCoord and
+// view depth and loops over that cluster's lights only. Only Upload(), Bind()
+// and Release() touch GL, so generation and binning can run off the render
+// thread.
+//
+// GL 4.2 has no compute shaders or storage buffers, so binning runs on the
+// CPU (SSE2 bounds, slices spread over the job system) and the shader reads
+// everything through texture buffers.
+class ClusteredLights {
+public:
+  ~ClusteredLights() { Release(); }
+
+  static constexpr int ClustersX = 16;
+  static constexpr int ClustersY = 9;
+  static constexpr int ClustersZ = 24;
+  static constexpr size_t ClusterCount = size_t(ClustersX) * ClustersY * ClustersZ;
+  // Indices are uint16 on the GPU
+  static constexpr size_t MaxLights = 16384;
+  // Index list cap; clusters past it are truncated (see lastOverflow)
+  static constexpr size_t MaxIndices = size_t(1) << 21;
+
+  // Texture units read by the lit shaders, after the material units 0 and 1
+  static constexpr GLint LightDataUnit = 2;
+  static constexpr GLint ClusterGridUnit = 3;
+  static constexpr GLint LightIndexUnit = 4;
+
+  // Scatters count lights inside the box with random colours and radii of
+  // roughly radiusScale times the mean light spacing; the next Upload()
+  // sends them
+  void Generate(size_t count, const glm::vec3 &boundsMin,
+                const glm::vec3 &boundsMax, float radiusScale, uint64_t seed);
+  void Release();
+
+  // Bins lights for this camera; projection parameters must match the ones
+  // the strategies draw with
+  void Assign(const glm::mat4 &view, float fovY, float aspect, float zNear,
+              float zFar);
+  void Upload();
+
+  // Binds the three texture buffers and the cluster uniforms to the given,
+  // already bound, shader, counting them in stats if set
+  void Bind(const Shader &shader, int viewportWidth, int viewportHeight,
+            RenderCounters *stats = nullptr) const;
+
+  size_t Count() const { return count; }
+  size_t GpuBytes() const;
+
+  // Cluster range of one light; zBegin > zEnd when it is culled
+  struct LightBounds {
+    uint8_t xBegin, xEnd, yBegin, yEnd, zBegin, zEnd;
+  };
+
+  double lastAssignMs = 0.0;
+  double lastUploadMs = 0.0;
+  size_t lastUploadBytes = 0;
+  size_t lastVisible = 0;      // lights touching at least one cluster
+  size_t lastIndexCount = 0;   // light references across all clusters
+  uint32_t lastMaxPerCluster = 0;
+  size_t lastOverflow = 0;     // references dropped at MaxIndices
+
+private:
+  void ComputeBounds(const glm::mat4 &view, float p00, float p11, float zNear,
+                     float zFar);
+  // Creates the buffers on first use and uploads the light texels
+  void CreateBuffers();
+
+  size_t count = 0;
+  // SoA for the SIMD bounds pass, which also leaves the view-space centres
+  std::vector<float> posX, posY, posZ, radius;
+  std::vector<float> viewX, viewY, viewDepth;
+  std::vector<LightBounds> bounds;
+  std::vector<glm::vec4> texels; // uploaded by the next Upload()
+  bool texelsDirty = false;
+
+  float sliceScale = 0.0f; // slice = log(depth) * sliceScale + sliceBias
+  float sliceBias = 0.0f;
+  float sliceNear[ClustersZ + 1] = {}; // view depth where each slice starts
+  glm::vec3 viewPos = glm::vec3(0.0f);
+
+  // Per depth slice: cluster (offset, count) pairs relative to the slice and
+  // its light indices; slices are binned in parallel then concatenated
+  std::vector<std::vector<uint16_t>> sliceIndices =
+      std::vector<std::vector<uint16_t>>(ClustersZ);
+  std::vector<size_t> sliceBase = std::vector<size_t>(ClustersZ);
+  std::vector<uint32_t> grid = std::vector<uint32_t>(ClusterCount * 2);
+  std::vector<uint16_t> indices;
+
+  GlBuffer lightBuffer;
+  GlTexture lightTexture;
+  GlBuffer gridBuffer;
+  GlTexture gridTexture;
+  GlBuffer indexBuffer;
+  GlTexture indexTexture;
+  size_t indexCapacity = 0;
+};
+
+#endif // CLUSTERED_LIGHTS_H
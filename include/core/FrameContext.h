@@ -0,0 +1,78 @@
+#ifndef FRAME_CONTEXT_H
+#define FRAME_CONTEXT_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+class Camera;
+class FrameArenas;
+
+// Per-frame counters every strategy adds to while it submits, so strategies
+// compare on the same numbers. The engine adds the scene store's uploads
+// and times the Render() calls.
+struct RenderCounters {
+  uint64_t drawCalls = 0;
+  uint64_t instances = 0;
+  uint64_t triangles = 0;
+  uint64_t vertices = 0; // vertex shader invocations asked for (indices if indexed)
+  // Triangles of everything drawn before culling below the object level;
+  // left at 0 by strategies that submit whole objects
+  uint64_t sceneTriangles = 0;
+  // Program, vertex array, buffer and framebuffer binds plus uniform updates
+  uint64_t stateChanges = 0;
+  uint64_t textureBinds = 0;
+  uint64_t uploadBytes = 0; // buffer and texture data sent to the GPU
+  double submitMs = 0.0;    // CPU time inside Render()
+
+  void Reset() { *this = RenderCounters{}; }
+};
+
+// Everything a strategy needs to draw one frame, computed once per frame by
+// the engine. Strategies read matrices from here instead of rebuilding them
+// from the camera.
+struct FrameContext {
+  static constexpr float NearPlane = 0.1f;
+  static constexpr float FarPlane = 100.0f;
+
+  glm::mat4 view = glm::mat4(1.0f);
+  glm::mat4 projection = glm::mat4(1.0f);
+  glm::mat4 viewProjection = glm::mat4(1.0f);
+  // Inward-facing and normalised: dot(xyz, p) + w >= 0 inside. Left, right,
+  // bottom, top, near, far.
+  glm::vec4 frustumPlanes[6] = {};
+  glm::vec3 cameraPosition = glm::vec3(0.0f);
+
+  float fovY = 0.0f; // radians
+  float aspect = 1.0f;
+  float zNear = NearPlane;
+  float zFar = FarPlane;
+  int viewportWidth = 1;
+  int viewportHeight = 1;
+
+  float time = 0.0f;
+  float deltaTime = 0.0f;
+  uint64_t frameIndex = 0;
+  size_t objectCount = 0; // objects to draw this frame
+
+  FrameArenas *arenas = nullptr;
+  RenderCounters *stats = nullptr;
+
+  // Matrices, planes and viewport for the camera; the aspect ratio comes
+  // from the viewport. The per-frame fields are left for the caller.
+  static FrameContext FromCamera(const Camera &camera, int viewportWidth,
+                                 int viewportHeight);
+  // Same for any view matrix, e.g. a cubemap face around the camera
+  static FrameContext FromView(const glm::mat4 &view, const glm::vec3 &position,
+                               float fovY, int viewportWidth, int viewportHeight);
+
+  bool SphereVisible(const glm::vec3 &center, float radius) const {
+    for (const glm::vec4 &plane : frustumPlanes)
+      if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+        return false;
+    return true;
+  }
+};
+
+#endif // FRAME_CONTEXT_H
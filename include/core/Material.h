@@ -4,8 +4,10 @@
 #include "core/Camera.h"
 #include "core/Shader.h"
 #include <glad/glad.h>
+#include <cstdint>
 #include <map>
 #include <string>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
@@ -15,6 +17,17 @@ struct TextureInfo {
   int unit = 0;
 };
 
+// Fixed-layout material as it sits in the GPU material table (std140, 32
+// bytes). Must match MaterialRecord in Shaders/materials.glsl.
+struct MaterialRecord {
+  glm::vec4 baseColor;  // rgb tint, a = opacity
+  float roughness;
+  float metallic;
+  uint32_t diffuseSlot; // TextureBatcher slot
+  uint32_t flags;
+};
+static_assert(sizeof(MaterialRecord) == 32, "MaterialRecord must stay std140");
+
 class Material {
 public:
   Shader *shader = nullptr;
@@ -24,26 +37,67 @@ public:
   std::map<std::string, int> intUniforms;
   std::map<std::string, std::variant<int, float, glm::vec3>> uniforms;
 
+  // Parameters baked into the material table
+  glm::vec4 baseColor = glm::vec4(1.0f);
+  float roughness = 0.5f;
+  float metallic = 0.0f;
+  uint32_t diffuseSlot = 0;
+
+  MaterialRecord Bake() const {
+    return {baseColor, roughness, metallic, diffuseSlot, 0u};
+  }
+
+  // Per-draw path for standalone objects. Uniform locations are resolved once
+  // per program (and again if textures or uniforms are added), so each call
+  // only binds textures and sets uniforms by location.
   void apply() {
     if (!shader)
       return;
 
     shader->use();
+    if (cachedProgram != shader->ID ||
+        textureLocations.size() != textures.size() ||
+        uniformLocations.size() != uniforms.size())
+      resolveLocations();
 
     // Bind all textures
-    for (auto &tex : textures) {
-      glActiveTexture(GL_TEXTURE0 + tex.unit);
-      glBindTexture(GL_TEXTURE_2D, tex.id);
-      shader->setUniform(("texture_" + tex.type).c_str(), tex.unit);
+    for (size_t i = 0; i < textures.size(); i++) {
+      glActiveTexture(GL_TEXTURE0 + textures[i].unit);
+      glBindTexture(GL_TEXTURE_2D, textures[i].id);
+      glUniform1i(textureLocations[i], textures[i].unit);
     }
 
+    size_t i = 0;
+    for (auto &[name, val] : uniforms) {
+      GLint location = uniformLocations[i++];
+      std::visit(
+          [location](auto &&v) {
+            using T = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<T, int>)
+              glUniform1i(location, v);
+            else if constexpr (std::is_same_v<T, float>)
+              glUniform1f(location, v);
+            else
+              glUniform3fv(location, 1, &v[0]);
+          },
+          val);
+    }
+  }
 
-for (auto &[name, val] : uniforms) {
-    std::visit([&](auto&& v) {
-        shader->setUniform(name, v);
-    }, val);
-}
+private:
+  GLuint cachedProgram = 0;
+  std::vector<GLint> textureLocations;
+  std::vector<GLint> uniformLocations;
 
+  void resolveLocations() {
+    cachedProgram = shader->ID;
+    textureLocations.clear();
+    for (auto &tex : textures)
+      textureLocations.push_back(
+          glGetUniformLocation(shader->ID, ("texture_" + tex.type).c_str()));
+    uniformLocations.clear();
+    for (auto &[name, val] : uniforms)
+      uniformLocations.push_back(glGetUniformLocation(shader->ID, name.c_str()));
   }
 };
 
@@ -0,0 +1,42 @@
+#ifndef MATERIAL_TABLE_H
+#define MATERIAL_TABLE_H
+
+#include "core/Material.h"
+#include "tools/GpuResources.h"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// All scene materials baked into one uniform buffer at load time. Draws and
+// instances carry only a material index; shaders read the record from the
+// Materials block, so switching materials costs nothing on the CPU and one
+// draw can mix any number of them.
+class MaterialTable {
+public:
+  ~MaterialTable() { Release(); }
+
+  // 16 KB is the smallest GL_MAX_UNIFORM_BLOCK_SIZE the spec allows; shaders
+  // size their array with the same constant.
+  static constexpr size_t MaxMaterials = 16384 / sizeof(MaterialRecord);
+  // Uniform block binding point used by every material-aware shader
+  static constexpr GLuint BindingPoint = 0;
+
+  // Bakes and uploads; anything past MaxMaterials is dropped with a warning
+  bool Build(const std::vector<Material> &materials);
+  void Release();
+
+  void Bind() const;
+
+  size_t Count() const { return records.size(); }
+  size_t GpuBytes() const { return records.size() * sizeof(MaterialRecord); }
+  const MaterialRecord &Record(uint32_t index) const { return records[index]; }
+
+private:
+  std::vector<MaterialRecord> records;
+  GlBuffer buffer;
+};
+
+#endif // MATERIAL_TABLE_H
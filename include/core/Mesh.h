@@ -0,0 +1,64 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Same layout as the shared cube: position, normal, texcoord
+struct MeshVertex {
+  glm::vec3 position;
+  glm::vec3 normal;
+  glm::vec2 texCoord;
+};
+
+// A run of whole triangles in Mesh::indices touching at most
+// Mesh::MaxMeshletVertices distinct vertices, so a cluster draws as one
+// index range
+struct Meshlet {
+  uint32_t firstIndex = 0;
+  uint32_t triangleCount = 0;
+  uint32_t vertexCount = 0;
+};
+
+// Per-meshlet culling data in mesh space, one array per component so
+// culling can test four clusters at once. The normal cone follows
+// meshoptimizer: a cluster faces away from a camera at c when
+// dot(center - c, axis) >= cutoff * |center - c| + radius; cutoff is 1 for
+// clusters whose normals spread too far to ever be culled.
+struct MeshletBounds {
+  std::vector<float> centerX, centerY, centerZ, radius;
+  std::vector<float> axisX, axisY, axisZ, cutoff;
+
+  size_t Size() const { return radius.size(); }
+};
+
+// Indexed triangle mesh, split into meshlets once at import
+class Mesh {
+public:
+  static constexpr uint32_t MaxMeshletVertices = 64;
+  static constexpr uint32_t MaxMeshletTriangles = 124;
+
+  std::vector<MeshVertex> vertices;
+  std::vector<uint32_t> indices; // counter-clockwise triangles
+  std::vector<Meshlet> meshlets;
+  MeshletBounds meshletBounds;
+  glm::vec3 center = glm::vec3(0.0f); // bounding sphere of the whole mesh
+  float radius = 0.0f;
+
+  // Procedural stand-in until a model importer exists: a UV sphere of
+  // radius 0.5 with a bumpy surface, so clusters face many directions.
+  // Comes with its meshlets built.
+  static Mesh Sphere(int rings, int segments, float bumpiness = 0.05f);
+
+  // Greedy clustering in index order, then a bounding sphere and normal cone
+  // per cluster. Consecutive triangles of a well-ordered mesh share
+  // vertices, so clusters come out compact without reordering.
+  void BuildMeshlets();
+
+  size_t TriangleCount() const { return indices.size() / 3; }
+};
+
+#endif // MESH_H
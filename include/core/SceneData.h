@@ -0,0 +1,56 @@
+#ifndef SCENE_DATA_H
+#define SCENE_DATA_H
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct ObjectBounds {
+  glm::vec3 min;
+  glm::vec3 max;
+};
+
+// Structure-of-arrays scene description shared by the generators, scene files
+// and render strategies. Arrays are always sized up front; readyCount tells
+// readers how many leading objects are valid while a loader is still filling
+// in the rest.
+struct SceneData {
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec4> rotations; // quaternion (x, y, z, w)
+  std::vector<glm::vec3> scales;
+  std::vector<uint32_t> meshIds;
+  std::vector<uint32_t> materialIds;
+  std::vector<ObjectBounds> bounds;
+
+  uint64_t seed = 0;
+  std::atomic<size_t> readyCount{0};
+
+  size_t Size() const { return positions.size(); }
+  size_t ReadyCount() const {
+    return readyCount.load(std::memory_order_acquire);
+  }
+
+  void Resize(size_t count);
+  void Clear();
+};
+
+// Builds translate * rotate(quaternion) * scale without going through glm::quat
+inline glm::mat4 ComposeTransform(const glm::vec3 &position,
+                                  const glm::vec4 &rotation,
+                                  const glm::vec3 &scale) {
+  float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+  float xx = x * x, yy = y * y, zz = z * z;
+  float xy = x * y, xz = x * z, yz = y * z;
+  float wx = w * x, wy = w * y, wz = w * z;
+
+  return glm::mat4(
+      glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * scale.x,
+      glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * scale.y,
+      glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * scale.z,
+      glm::vec4(position, 1.0f));
+}
+
+#endif // SCENE_DATA_H
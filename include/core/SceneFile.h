@@ -0,0 +1,97 @@
+#ifndef SCENE_FILE_H
+#define SCENE_FILE_H
+
+#include "core/SceneData.h"
+#include "tools/filemanager.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// Binary scene format (.rbscene), little-endian:
+//
+//   Header
+//   ChunkEntry[chunkCount]
+//   chunk 0: positions | rotations | scales | meshIds | materialIds | bounds
+//   chunk 1: ...
+//
+// Each chunk stores its objects as SoA sections and starts on a page boundary,
+// so a chunk can be paged in and copied without touching its neighbours.
+namespace SceneFile {
+
+constexpr uint32_t Magic = 0x43534252; // "RBSC"
+constexpr uint32_t Version = 1;
+constexpr uint32_t DefaultChunkSize = 16384; // objects per chunk
+
+enum Section : uint32_t {
+  Positions,
+  Rotations,
+  Scales,
+  MeshIds,
+  MaterialIds,
+  Bounds,
+  SectionCount
+};
+
+struct Header {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t objectCount;
+  uint64_t seed;
+  uint32_t chunkSize;
+  uint32_t chunkCount;
+  uint32_t sectionCount;
+  uint32_t sectionStrides[SectionCount]; // bytes per object, for validation
+  uint64_t chunkTableOffset;
+};
+
+struct ChunkEntry {
+  uint64_t firstObject;
+  uint32_t objectCount;
+  uint32_t reserved;
+  uint64_t sectionOffsets[SectionCount]; // absolute file offsets
+};
+
+bool Save(const std::string &path, const SceneData &scene,
+          uint32_t chunkSize = DefaultChunkSize);
+
+// Blocking load of the whole file.
+bool Load(const std::string &path, SceneData &scene);
+
+} // namespace SceneFile
+
+// Streams a scene file into a SceneData on a worker thread. The target is
+// sized before the first chunk is copied and readyCount is advanced after
+// every chunk, so rendering can start while later chunks are still on disk.
+class SceneStreamer {
+public:
+  SceneStreamer() = default;
+  ~SceneStreamer();
+
+  SceneStreamer(const SceneStreamer &) = delete;
+  SceneStreamer &operator=(const SceneStreamer &) = delete;
+
+  bool Start(const std::string &path, SceneData &scene);
+  void Stop();
+
+  bool IsStreaming() const { return running.load(std::memory_order_acquire); }
+  float Progress() const;
+  double ElapsedMs() const { return elapsedMs.load(std::memory_order_acquire); }
+
+private:
+  void Run();
+
+  AssetData file;
+  SceneData *target = nullptr;
+  const SceneFile::Header *header = nullptr;
+  const SceneFile::ChunkEntry *chunks = nullptr;
+
+  std::thread worker;
+  std::atomic<bool> running{false};
+  std::atomic<bool> cancel{false};
+  std::atomic<uint32_t> chunksLoaded{0};
+  std::atomic<double> elapsedMs{0.0};
+};
+
+#endif // SCENE_FILE_H
@@ -0,0 +1,53 @@
+#ifndef SCENE_GENERATOR_H
+#define SCENE_GENERATOR_H
+
+#include "core/SceneData.h"
+
+#include <cstddef>
+#include <cstdint>
+
+enum class SceneDistribution {
+  UniformBox,  // uniform in [-extent, extent]^3
+  Clustered,   // gaussian blobs around random cluster centres
+  Grid,        // regular lattice filling the box
+  CityBlock,   // ground-level towers on a street grid
+  SphereShell, // thin shell around the origin
+  Count
+};
+
+const char *SceneDistributionName(SceneDistribution distribution);
+
+struct SceneGeneratorSettings {
+  SceneDistribution distribution = SceneDistribution::UniformBox;
+  size_t objectCount = 50000;
+  uint64_t seed = 42;
+  float extent = 10.0f;
+  int clusterCount = 32;
+  float clusterRadius = 1.5f;
+  uint32_t materialCount = 256;
+  int threadCount = 0; // 0 = hardware concurrency
+};
+
+// Counter-based RNG (Widynski's "Squares"): every value is a pure function of
+// (key, counter), so object i gets the same attributes no matter which thread
+// generates it or in which order.
+struct SquaresRng {
+  uint64_t key;
+
+  explicit SquaresRng(uint64_t seed);
+
+  uint32_t Next(uint64_t counter) const;
+  // Uniform float in [0, 1)
+  float Uniform(uint64_t counter) const;
+};
+
+// Fills scene with settings.objectCount objects. Arrays are sized once and
+// filled in parallel blocks; the output is identical for any thread count.
+// Returns the generation time in milliseconds.
+double GenerateScene(SceneData &scene, const SceneGeneratorSettings &settings);
+
+// Order-dependent hash over all SoA arrays, used to check that two runs (or
+// two thread counts) produced exactly the same scene.
+uint64_t HashSceneData(const SceneData &scene);
+
+#endif // SCENE_GENERATOR_H
@@ -0,0 +1,233 @@
+#ifndef SCENE_STORE_H
+#define SCENE_STORE_H
+
+#include "core/ClusteredLights.h"
+#include "core/FrameContext.h"
+#include "core/MaterialTable.h"
+#include "core/SceneData.h"
+#include "core/Shader.h"
+#include "core/TransformHierarchy.h"
+#include "tools/GpuResources.h"
+#include "tools/TextureBatcher.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Engine-owned scene shared by every render strategy. Holds the CPU SoA data
+// plus a GPU mirror (per-object model matrices and material indices, the cube
+// geometry, the material table, the batched texture array and compiled
+// shaders) that outlives
+// strategy switches, so switching strategies never regenerates or re-uploads
+// the scene.
+class SceneStore {
+public:
+  // GPU buffer a strategy derives from the scene (e.g. merged batch geometry).
+  // The store owns it; the strategy rebuilds it when version falls behind.
+  struct DerivedBuffer {
+    GlBuffer buffer;
+    uint64_t version = 0;
+    size_t objectCount = 0;
+    size_t bytes = 0;
+  };
+
+  void Init();
+  void Shutdown();
+
+  // Rebuilds the texture array with count textures; material i samples
+  // texture i % count
+  void SetTextureCount(int count);
+  int TextureCount() const { return textureCount; }
+  // Rebuilds the material table; objects use materialId % count
+  void SetMaterialCount(int count);
+  int MaterialCount() const { return materialCount; }
+
+  SceneData &Data() { return data; }
+  const SceneData &Data() const { return data; }
+
+  // Call whenever the CPU data is replaced (generate, load, stream start).
+  void Invalidate() { version++; }
+  uint64_t Version() const { return version; }
+
+  // Once per frame, before rendering: composes the model matrices of
+  // objects that became ready since the last call, animates and updates the
+  // hierarchy (when enabled and the scene is fully resident), bins the lights
+  // and sorts the draw order for frame. CPU only, so it can run on the main
+  // thread while the render thread draws the previous frame.
+  void Update(const FrameContext &frame);
+  // On the GL thread after each Update and before drawing: sends what Update
+  // changed, i.e. new objects, the world matrices the hierarchy touched, the
+  // sorted copy and the light clusters. Returns the bytes sent.
+  size_t Upload();
+
+  // Bumped whenever any model matrix changes; derived buffers baked from the
+  // matrices compare against this rather than Version()
+  uint64_t TransformVersion() const { return transformVersion; }
+  // Also bumped when object material indices change; for buffers that bake
+  // both the matrix and the material of each object
+  uint64_t InstanceVersion() const { return transformVersion + materialVersion; }
+
+  // Parents objects under pivot levels (see TransformHierarchy::Build);
+  // changing the shape rebuilds it on the next Update
+  void SetHierarchy(bool enabled, int fanout, int pivotLevels);
+  bool HierarchyEnabled() const { return hierarchyEnabled; }
+  const TransformHierarchy &Hierarchy() const { return hierarchy; }
+  float hierarchyMovingFraction = 0.1f;
+
+  size_t GpuCount() const { return gpuCount; }
+  // sorted returns the copy kept in DrawOrder() order
+  GLuint InstanceBuffer(bool sorted = false) const {
+    return sorted ? sortedInstanceBuffer : instanceBuffer;
+  }
+  GLuint MaterialBuffer(bool sorted = false) const {
+    return sorted ? sortedMaterialBuffer : materialBuffer;
+  }
+  const std::vector<glm::mat4> &ModelMatrices() const { return modelMatrices; }
+  GLuint CubeVertexBuffer() const { return cubeBuffer; }
+  // The cube vertices as a buffer texture for vertex pulling: two RGBA32F
+  // texels per vertex, (position, normal.x) then (normal.yz, uv)
+  GLuint CubeVertexTexture() const { return cubeTexture; }
+  const TextureBatcher &Textures() const { return textures; }
+  const MaterialTable &Materials() const { return materials; }
+  uint32_t ObjectMaterial(size_t index) const { return objectMaterials[index]; }
+
+  // Attribute setup helpers for the currently bound VAO. Instance attributes
+  // take five locations: the model matrix, then the material index. sorted
+  // reads the copy kept in DrawOrder() order instead.
+  void BindCubeAttributes() const;
+  void BindInstanceAttributes(GLuint firstLocation, bool sorted = false) const;
+
+  // Front-to-back submission. While enabled, Update sorts the
+  // frame.objectCount drawn objects by view depth and keeps a sorted copy of
+  // the instance data on the GPU; strategies then draw DrawOrder() in order.
+  void SetFrontToBack(bool enabled) { frontToBack = enabled; }
+  bool FrontToBack() const { return frontToBack; }
+  const std::vector<uint32_t> &DrawOrder() const { return drawOrder; }
+  // Bumped whenever DrawOrder() changes
+  uint64_t DrawOrderVersion() const { return drawOrderVersion; }
+  double lastSortMs = 0.0;
+
+  // Binds the texture array to unit 0 (diffuseArray), the slot table to unit
+  // 1 (textureSlots) and the material table to its uniform block binding, for
+  // the given, already bound, shader. The Bind* calls count what they bind
+  // in stats if set.
+  void BindMaterials(const Shader &shader, RenderCounters *stats = nullptr) const;
+
+  // Clustered forward lighting. Lights are scattered over the bounds of the
+  // resident scene and regenerated when the scene, count or radius changes;
+  // Update bins them with the frame's camera.
+  void SetLighting(bool enabled, int lightCount);
+  bool LightingEnabled() const { return lightingEnabled; }
+  int LightCount() const { return lightCount; }
+  float lightRadiusScale = 1.5f;
+
+  // Binds the cluster data for clustered.fs to the given, already bound,
+  // shader (BindMaterials is still needed)
+  void BindLighting(const Shader &shader, RenderCounters *stats = nullptr) const;
+  const ClusteredLights &Lights() const { return lights; }
+
+  // The programs a strategy draws with, all built on one vertex shader and,
+  // if given, one geometry shader
+  struct Programs {
+    Shader *unlit = nullptr;  // texarray.fs
+    Shader *lit = nullptr;    // clustered.fs
+    Shader *depth = nullptr;  // depthonly.fs, for the depth pre-pass
+  };
+  Programs GetPrograms(const std::string &vertexName,
+                       const std::string &geometryName = "");
+  // Binds whichever of the programs the current pass and lighting call for,
+  // with the materials and lights it reads; strategies set their matrices
+  // on the returned shader afterwards
+  Shader &UseProgram(const Programs &programs, RenderCounters *stats = nullptr) const;
+  // Set around a depth pre-pass
+  void SetDepthOnly(bool enabled) { depthOnly = enabled; }
+  // Set around views the light clusters were not assigned for, which then
+  // draw unlit rather than shaded with another view's clusters
+  void SetUnlit(bool enabled) { unlit = enabled; }
+  // Extra ALU passes per vertex in the cube vertex shaders (0 = none), the
+  // vertex load knob of the bottleneck classifier
+  void SetVertexWork(int passes) { vertexWork = passes; }
+
+  // Compiled once per set of paths and kept for the lifetime of the store
+  Shader &GetShader(const std::string &vertexName,
+                    const std::string &fragmentName,
+                    const std::string &geometryName = "");
+  DerivedBuffer &GetDerived(const std::string &name);
+
+  size_t GpuBytes() const;
+  size_t lastUploadBytes = 0;
+  double lastUpdateMs = 0.0;
+
+private:
+  void UpdateLights(const FrameContext &frame);
+  void UpdateDrawOrder(const FrameContext &frame);
+
+  SceneData data;
+  uint64_t version = 1;
+
+  uint64_t gpuVersion = 0;
+  uint64_t transformVersion = 0;
+  uint64_t materialVersion = 0;
+  size_t gpuCount = 0;
+  size_t gpuCapacity = 0;
+  std::vector<glm::mat4> modelMatrices;
+  std::vector<uint32_t> objectMaterials;
+
+  // What Update changed and Upload still has to send
+  bool reallocatePending = false;
+  size_t streamBegin = 0;
+  size_t streamEnd = 0;
+  bool hierarchyPending = false;
+  bool sortedPending = false;
+  bool materialsPending = false;
+  bool lightsPending = false;
+
+  GlBuffer instanceBuffer;
+  GlBuffer materialBuffer;
+  GlBuffer cubeBuffer;
+  GlTexture cubeTexture;
+
+  TransformHierarchy hierarchy;
+  bool hierarchyEnabled = false;
+  int hierarchyFanout = 16;
+  int hierarchyLevels = 3;
+  uint64_t hierarchyVersion = 0;
+
+  TextureBatcher textures;
+  int textureCount = 256;
+  MaterialTable materials;
+  int materialCount = 256;
+
+  ClusteredLights lights;
+  bool lightingEnabled = false;
+  int lightCount = 4096;
+  uint64_t lightsVersion = 0;
+  float lightsRadiusScale = 0.0f;
+  int viewportWidth = 1;
+  int viewportHeight = 1;
+
+  bool depthOnly = false;
+  bool unlit = false;
+  int vertexWork = 0;
+
+  bool frontToBack = false;
+  std::vector<uint32_t> drawOrder;
+  std::vector<uint64_t> sortItems[2]; // depth key << 32 | object index
+  uint64_t drawOrderVersion = 1;
+  uint64_t sortedTransformVersion = 0;
+  uint64_t sortedOrderVersion = 0;
+  std::vector<glm::mat4> sortedMatrices;
+  std::vector<uint32_t> sortedMaterials;
+  GlBuffer sortedInstanceBuffer;
+  GlBuffer sortedMaterialBuffer;
+
+  std::map<std::string, Shader> shaders;
+  std::map<std::string, DerivedBuffer> derived;
+};
+
+#endif // SCENE_STORE_H
@@ -1,13 +1,15 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include "tools/filemanager.h"
+
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
-#include <fstream>
+#include <algorithm>
 #include <iostream>
-#include <sstream>
 #include <string>
+#include <string_view>
 
 class Shader {
 public:
@@ -27,13 +29,21 @@ public:
     // --------------------------------------------------------
     // Generic template uniform setter (specialized below)
     // --------------------------------------------------------
+    // Takes const char* so literal names never build a std::string per call
     template <typename T>
-    void setUniform(const std::string& name, const T& value) const;
+    void setUniform(const char* name, const T& value) const;
+
+    template <typename T>
+    void setUniform(const std::string& name, const T& value) const {
+        setUniform<T>(name.c_str(), value);
+    }
 
 private:
     void CheckShaderCompilation(GLuint shader, const std::string& type);
     void CheckProgramLinking(GLuint program);
     void checkCompileErrors(GLuint shader, std::string type);
+    bool expandIncludes(const char* path, const AssetData& source, std::string& out);
+    GLuint compileStage(GLenum type, std::string_view source, const std::string& typeName);
 };
 
 // ------------------------------------------------------------
@@ -93,109 +103,95 @@ inline void Shader::checkCompileErrors(GLuint shader, std::string type) {
     }
 }
 
-// Load simple vertex + fragment shaders
-inline void Shader::LoadShaders(const char* vertexPath, const char* fragmentPath) {
-    std::string vertexCode, fragmentCode;
-    std::ifstream vShaderFile, fShaderFile;
-
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-    try {
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        vShaderFile.close();
-        fShaderFile.close();
-        vertexCode   = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
-    } catch (std::ifstream::failure& e) {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
-    }
-
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
-
-    unsigned int vertex, fragment;
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX");
-
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
+// Replaces each `#include "file"` line with that file, opened through the VFS
+// next to the including stage. Snippets do not nest. out stays empty when
+// there is nothing to splice, so such stages compile straight from the asset.
+inline bool Shader::expandIncludes(const char* path, const AssetData& source,
+                                   std::string& out) {
+    std::string_view text = source.Text();
+    if (text.find("#include") == std::string_view::npos)
+        return true;
+
+    fs::path directory = fs::path(path).parent_path();
+    int line = 1;
+    for (size_t begin = 0; begin < text.size(); line++) {
+        size_t end = std::min(text.find('\n', begin), text.size());
+        std::string_view current = text.substr(begin, end - begin);
+        begin = end + 1;
+
+        size_t open = current.find('"');
+        size_t close = current.rfind('"');
+        if (current.rfind("#include", 0) != 0 || open == close) {
+            out.append(current);
+            out += '\n';
+            continue;
+        }
 
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
-    checkCompileErrors(ID, "PROGRAM");
+        std::string name(current.substr(open + 1, close - open - 1));
+        AssetData snippet;
+        if (!VirtualFileSystem::shared().open((directory / name).generic_string(), snippet)) {
+            std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND::" << name << " in " << path
+                      << std::endl;
+            return false;
+        }
+        out.append(snippet.Text());
+        if (!out.empty() && out.back() != '\n')
+            out += '\n';
+        // Errors after the snippet report the including file's line numbers
+        out += "#line " + std::to_string(line + 1) + "\n";
+    }
+    return true;
+}
 
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+// Compiles one stage from a view of its source; the length is passed, so the
+// source needs no terminator
+inline GLuint Shader::compileStage(GLenum type, std::string_view source,
+                                   const std::string& typeName) {
+    const char* code = source.data();
+    GLint length = static_cast<GLint>(source.size());
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &code, &length);
+    glCompileShader(shader);
+    checkCompileErrors(shader, typeName);
+    return shader;
+}
 
-    std::cout << "SUCCESS::SHADER::PROGRAM::SHADERS_SUCCESSFULLY_LOADED \n"
-              << "SUCCESS::PATH::VERTEX::" << vertexPath
-              << "\nSUCCESS::FRAGMENT::" << fragmentPath << std::endl;
+// Load simple vertex + fragment shaders. Paths go through the VFS, so they
+// are relative to the asset root or inside the mounted archive.
+inline void Shader::LoadShaders(const char* vertexPath, const char* fragmentPath) {
+    LoadAdvShaders(vertexPath, fragmentPath, nullptr);
 }
 
 // Load vertex + fragment + geometry shader
 inline void Shader::LoadAdvShaders(const char* vertexPath, const char* fragmentPath,
                                    const char* geopath) {
-    std::string vertexCode, fragmentCode, geoCode;
-    std::ifstream vShaderFile, fShaderFile, gShaderFile;
-
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    gShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-    try {
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        if (geopath) gShaderFile.open(geopath);
-
-        std::stringstream vShaderStream, fShaderStream, gShaderStream;
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        if (geopath) gShaderStream << gShaderFile.rdbuf();
-
-        vShaderFile.close();
-        fShaderFile.close();
-        if (geopath) gShaderFile.close();
-
-        vertexCode   = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
-        geoCode      = gShaderStream.str();
-    } catch (std::ifstream::failure& e) {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+    const VirtualFileSystem& vfs = VirtualFileSystem::shared();
+    AssetData vertexSource, fragmentSource, geoSource;
+    if (!vfs.open(vertexPath, vertexSource) || !vfs.open(fragmentPath, fragmentSource) ||
+        (geopath && !vfs.open(geopath, geoSource))) {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+        ID = 0;
+        return;
     }
 
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
-
-    unsigned int vertex, fragment, geo;
-
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX");
-
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
-
-    if (geopath) {
-        const char* gShaderCode = geoCode.c_str();
-        geo = glCreateShader(GL_GEOMETRY_SHADER);
-        glShaderSource(geo, 1, &gShaderCode, NULL);
-        glCompileShader(geo);
-        checkCompileErrors(geo, "GEOMETRY");
+    // Shared snippets (materials.glsl, surface.glsl, ...) are spliced in here
+    std::string vertexCode, fragmentCode, geoCode;
+    if (!expandIncludes(vertexPath, vertexSource, vertexCode) ||
+        !expandIncludes(fragmentPath, fragmentSource, fragmentCode) ||
+        (geopath && !expandIncludes(geopath, geoSource, geoCode))) {
+        ID = 0;
+        return;
     }
+    auto code = [](const AssetData& source, const std::string& expanded) {
+        return expanded.empty() ? source.Text() : std::string_view(expanded);
+    };
+
+    unsigned int vertex, fragment, geo = 0;
+    vertex = compileStage(GL_VERTEX_SHADER, code(vertexSource, vertexCode), "VERTEX");
+    fragment = compileStage(GL_FRAGMENT_SHADER, code(fragmentSource, fragmentCode),
+                            "FRAGMENT");
+    if (geopath)
+        geo = compileStage(GL_GEOMETRY_SHADER, code(geoSource, geoCode), "GEOMETRY");
 
     ID = glCreateProgram();
     glAttachShader(ID, vertex);
@@ -219,50 +215,50 @@ inline void Shader::LoadAdvShaders(const char* vertexPath, const char* fragmentP
 
 // int specialization
 template <>
-inline void Shader::setUniform<int>(const std::string& name, const int& value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+inline void Shader::setUniform<int>(const char* name, const int& value) const {
+    glUniform1i(glGetUniformLocation(ID, name), value);
 }
 
 // float specialization
 template <>
-inline void Shader::setUniform<float>(const std::string& name, const float& value) const {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+inline void Shader::setUniform<float>(const char* name, const float& value) const {
+    glUniform1f(glGetUniformLocation(ID, name), value);
 }
 
 // vec2 specialization
 template <>
-inline void Shader::setUniform<glm::vec2>(const std::string& name, const glm::vec2& value) const {
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+inline void Shader::setUniform<glm::vec2>(const char* name, const glm::vec2& value) const {
+    glUniform2fv(glGetUniformLocation(ID, name), 1, &value[0]);
 }
 
 // vec3 specialization
 template <>
-inline void Shader::setUniform<glm::vec3>(const std::string& name, const glm::vec3& value) const {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+inline void Shader::setUniform<glm::vec3>(const char* name, const glm::vec3& value) const {
+    glUniform3fv(glGetUniformLocation(ID, name), 1, &value[0]);
 }
 
 // vec4 specialization
 template <>
-inline void Shader::setUniform<glm::vec4>(const std::string& name, const glm::vec4& value) const {
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+inline void Shader::setUniform<glm::vec4>(const char* name, const glm::vec4& value) const {
+    glUniform4fv(glGetUniformLocation(ID, name), 1, &value[0]);
 }
 
 // mat2 specialization
 template <>
-inline void Shader::setUniform<glm::mat2>(const std::string& name, const glm::mat2& mat) const {
-    glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+inline void Shader::setUniform<glm::mat2>(const char* name, const glm::mat2& mat) const {
+    glUniformMatrix2fv(glGetUniformLocation(ID, name), 1, GL_FALSE, &mat[0][0]);
 }
 
 // mat3 specialization
 template <>
-inline void Shader::setUniform<glm::mat3>(const std::string& name, const glm::mat3& mat) const {
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+inline void Shader::setUniform<glm::mat3>(const char* name, const glm::mat3& mat) const {
+    glUniformMatrix3fv(glGetUniformLocation(ID, name), 1, GL_FALSE, &mat[0][0]);
 }
 
 // mat4 specialization
 template <>
-inline void Shader::setUniform<glm::mat4>(const std::string& name, const glm::mat4& mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+inline void Shader::setUniform<glm::mat4>(const char* name, const glm::mat4& mat) const {
+    glUniformMatrix4fv(glGetUniformLocation(ID, name), 1, GL_FALSE, &mat[0][0]);
 }
 
 #endif
@@ -0,0 +1,78 @@
+#ifndef TRANSFORM_HIERARCHY_H
+#define TRANSFORM_HIERARCHY_H
+
+#include "core/SceneData.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Parent/child transforms stored as SoA arrays sorted by depth, so every
+// parent sits before its children and each depth level is a contiguous range.
+// Setting a local transform marks the node dirty; Update() walks the levels in
+// order, recomputes only dirty nodes and the descendants of recomputed nodes,
+// and splits each level across the job system.
+//
+// The scene's objects are the leaves (last level, in object order). Their
+// world matrices are written straight into the caller's model matrix array;
+// pivots above them keep their own.
+class TransformHierarchy {
+public:
+  static constexpr int32_t NoParent = -1;
+
+  struct LeafRange {
+    size_t begin;
+    size_t end;
+  };
+
+  // Groups count objects under pivotLevels levels of pivots, fanout children
+  // per pivot, following object order. Pivots sit at their children's centroid
+  // with identity rotation and unit scale, so at rest the world transforms are
+  // exactly the scene's own.
+  void Build(const SceneData &scene, size_t count, int fanout, int pivotLevels);
+  void Clear();
+
+  bool Empty() const { return parent.empty(); }
+  size_t NodeCount() const { return parent.size(); }
+  size_t LeafCount() const { return parent.size() - leafBegin; }
+  size_t LevelCount() const { return levelStart.empty() ? 0 : levelStart.size() - 1; }
+
+  void SetLocal(uint32_t node, const glm::vec3 &position,
+                const glm::vec4 &rotation, const glm::vec3 &scale);
+  void MarkDirty(uint32_t node) { dirty[node] = 1; }
+
+  // Spins a deterministic fraction of the lowest pivot level around Y, which
+  // dirties only those pivots' subtrees.
+  void Animate(float time, float movingFraction);
+
+  // Recomputes dirty subtrees. Leaf world matrices go to objectWorld[leaf];
+  // returns the number of nodes recomputed.
+  size_t Update(glm::mat4 *objectWorld);
+
+  // Leaf index ranges written by the last Update(), in ascending order, for
+  // partial buffer uploads
+  const std::vector<LeafRange> &DirtyLeafRanges() const { return dirtyRanges; }
+
+  size_t lastUpdated = 0;
+  double lastUpdateMs = 0.0;
+
+private:
+  std::vector<int32_t> parent;
+  std::vector<uint32_t> levelStart; // level l spans [levelStart[l], levelStart[l+1])
+  std::vector<glm::vec3> localPosition;
+  std::vector<glm::vec4> localRotation;
+  std::vector<glm::vec3> localScale;
+  std::vector<glm::mat4> world; // pivots only
+  std::vector<uint8_t> dirty;
+  // Frame stamp of each node's last recompute; a child is stale when its
+  // parent's stamp matches the current frame
+  std::vector<uint32_t> updatedStamp;
+  uint32_t stamp = 0;
+  size_t leafBegin = 0;
+
+  std::vector<LeafRange> dirtyRanges;
+};
+
+#endif // TRANSFORM_HIERARCHY_H
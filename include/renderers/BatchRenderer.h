@@ -1,10 +1,15 @@
 #pragma once
 
 #include "IRenderStrategy.h"
+#include "core/SceneStore.h"
+#include "tools/GpuResources.h"
+
+#include <cstddef>
 
 class Shader;
-class Mesh;
 
+// All objects pre-transformed into one world-space vertex buffer, each vertex
+// tagged with its material index, drawn with a single call
 class BatchRenderer : public IRenderStrategy
 {
 public:
@@ -12,14 +17,22 @@ public:
     ~BatchRenderer() override = default;
 
     void Init() override;
-    void Render(int objectCount, Camera& camera, GLFWwindow *window) override;
+    void Render(const FrameContext &frame) override;
     void Cleanup() override;
 
     const char* GetName() const override { return "Batch"; }
 
+    // position, normal, uv, material index
+    static constexpr int BatchVertexStride = 9;
+    // Merged geometry is 1296 bytes per object, so the batch is capped
+    static constexpr size_t MaxBatchedObjects = 262144;
+
 private:
-    Shader* shader;
-    Mesh* mesh;
+    // Both write straight into the mapped buffer and add their uploads to
+    // stats if set
+    void RebuildBatch(size_t count, RenderCounters *stats);
+    size_t RebuildOrder(size_t count, RenderCounters *stats);
 
-    unsigned int drawCalls = 0;
+    SceneStore::Programs programs;
+    GlVertexArray VAO;
 };
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "IRenderStrategy.h"
+#include "core/SceneStore.h"
+#include "tools/GpuResources.h"
+
+class Shader;
+
+// One point per object, expanded into its camera-facing cube faces by a
+// geometry shader. The points read the scene store's instance buffer as
+// per-vertex attributes.
+class GeometryRenderer : public IRenderStrategy {
+public:
+  GeometryRenderer() = default;
+  ~GeometryRenderer() override = default;
+
+  void Init() override;
+  void Render(const FrameContext &frame) override;
+  void Cleanup() override;
+
+  const char *GetName() const override { return "Geometry"; }
+
+private:
+  SceneStore::Programs programs;
+  GlVertexArray VAO;
+  GlVertexArray sortedVAO; // points in SceneStore::DrawOrder()
+};
@@ -1,18 +1,23 @@
 #pragma once
 
-//#include <GLFW/glfw3.h>
-struct GLFWwindow;
+#include "core/FrameContext.h"
 
-class Camera;
-class GLFWwindow;
+class SceneStore;
 
 class IRenderStrategy {
 public:
   virtual void Init() = 0;
-  virtual void Render(int objectCount, Camera& camera, GLFWwindow *window) = 0;
+  // Draws frame.objectCount objects with the frame's matrices and adds what
+  // it submitted to frame.stats
+  virtual void Render(const FrameContext &frame) = 0;
   virtual void Cleanup() = 0;
   virtual const char *GetName() const = 0;
 
+  // Engine-owned scene and GPU mirror; set before Init() and outlives the
+  // strategy, so nothing scene-sized is created or uploaded per strategy
+  void SetScene(SceneStore *sceneStore) { scene = sceneStore; }
+
   virtual ~IRenderStrategy() = default;
-private:
+protected:
+  SceneStore *scene = nullptr;
 };
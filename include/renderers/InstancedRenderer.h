@@ -1,12 +1,13 @@
 #pragma once
 
 #include "IRenderStrategy.h"
+#include "core/SceneStore.h"
+#include "tools/GpuResources.h"
 
 class Shader;
-class Mesh;
-class Camera;
-class GLFWwindow; 
 
+// One instanced draw; per-object model matrices come from the scene store's
+// instance buffer
 class InstancedRenderer : public IRenderStrategy
 {
 public:
@@ -14,14 +15,13 @@ public:
     ~InstancedRenderer() override = default;
 
     void Init() override;
-    void Render(int objectCount, Camera& camera, GLFWwindow *window) override;
+    void Render(const FrameContext &frame) override;
     void Cleanup() override;
 
-    const char* GetName() const override { return "Instance"; }
+    const char* GetName() const override { return "Instanced"; }
 
 private:
-    Shader* shader;
-    Mesh* mesh;
-
-    unsigned int drawCalls = 0;
+    SceneStore::Programs programs;
+    GlVertexArray VAO;
+    GlVertexArray sortedVAO; // instances in SceneStore::DrawOrder()
 };
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "core/FrameContext.h"
+#include "core/SceneStore.h"
+#include "tools/GpuResources.h"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+
+class Shader;
+
+// Draws the scene for up to MultiViewSettings::MaxViews views in one
+// submission into a layered target (MultiViewTarget::BeginLayered). Every
+// object is culled against every view on the job system; the survivors
+// become (object, view) instances of a single instanced draw, and the
+// geometry shader sends each triangle to its view's layer through gl_Layer.
+// Not an IRenderStrategy: it takes all the views at once.
+class LayeredRenderer {
+public:
+  void SetScene(SceneStore *sceneStore) { scene = sceneStore; }
+  void Init();
+  void Cleanup();
+
+  // views[0] supplies the shared per-frame fields
+  void Render(const FrameContext *views, int viewCount, RenderCounters *stats);
+
+  // After SceneStore's and ClusteredLights' units
+  static constexpr GLint MatrixUnit = 6;
+  static constexpr GLint MaterialUnit = 7;
+
+private:
+  SceneStore *scene = nullptr;
+  SceneStore::Programs programs;
+  GlVertexArray VAO;
+  GlBuffer instanceBuffer;
+  GlTexture matrixTexture;
+  GlTexture materialTexture;
+
+  std::vector<std::vector<uint32_t>> blockInstances; // one list per culling block
+  std::vector<uint32_t> instances;
+};
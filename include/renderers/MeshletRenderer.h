@@ -0,0 +1,54 @@
+#pragma once
+
+#include "IRenderStrategy.h"
+#include "core/Mesh.h"
+#include "core/SceneStore.h"
+#include "tools/GpuResources.h"
+
+#include <glad/glad.h>
+
+#include <vector>
+
+class Shader;
+
+// Draws every object as a detailed mesh split into meshlets. Each frame the
+// clusters of visible objects are culled on the CPU against the frustum
+// and their normal cones, four at a time, and the survivors go out as one
+// multi-draw indirect call (GL 4.3) or a loop of base-instance draws (GL
+// 4.2). The base instance selects the object's model matrix and material
+// from the scene store's instance buffer.
+class MeshletRenderer : public IRenderStrategy {
+public:
+  MeshletRenderer() = default;
+  ~MeshletRenderer() override = default;
+
+  void Init() override;
+  void Render(const FrameContext &frame) override;
+  void Cleanup() override;
+
+  const char *GetName() const override { return "Meshlet"; }
+
+private:
+  struct DrawCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+  };
+
+  // Appends the surviving clusters of the object to out
+  void CullObject(const FrameContext &frame, const glm::mat4 &model,
+                    uint32_t object, std::vector<DrawCommand> &out) const;
+
+  Mesh mesh;
+  SceneStore::Programs programs;
+  GlVertexArray VAO;
+  GlBuffer vertexBuffer;
+  GlBuffer indexBuffer;
+  GlBuffer indirectBuffer;
+  bool multiDrawIndirect = false;
+
+  std::vector<std::vector<DrawCommand>> blockCommands; // one list per culling block
+  std::vector<DrawCommand> commands;
+};
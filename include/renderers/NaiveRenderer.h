@@ -1,24 +1,24 @@
 #pragma once
 
 #include "IRenderStrategy.h"
+#include "core/SceneStore.h"
+#include "tools/GpuResources.h"
 
 class Shader;
-class Mesh;
 
+// One model uniform and one draw call per object
 class NaiveRenderer : public IRenderStrategy {
 public:
   NaiveRenderer() = default;
   ~NaiveRenderer() override = default;
 
   void Init() override;
-  void Render(int objectCount, Camera& camera, GLFWwindow *window) override;
+  void Render(const FrameContext &frame) override;
   void Cleanup() override;
 
   const char *GetName() const override { return "Naive"; }
 
 private:
-  Shader *shader;
-  Mesh *mesh;
-
-  unsigned int drawCalls = 0;
+  SceneStore::Programs programs;
+  GlVertexArray VAO;
 };
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "IRenderStrategy.h"
+#include "core/SceneStore.h"
+#include "tools/GpuResources.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+class LinearArena;
+class Shader;
+
+// Vertex pulling like PullingRenderer, but from a derived buffer holding
+// each object in 16 bytes instead of 68: quantised position, rotation
+// quaternion, log scale and material (see packedcube.vs). Packing
+// decomposes the world matrix, so shear from non-uniformly scaled parents
+// is lost.
+class PackedRenderer : public IRenderStrategy {
+public:
+  PackedRenderer() = default;
+  ~PackedRenderer() override = default;
+
+  void Init() override;
+  void Render(const FrameContext &frame) override;
+  void Cleanup() override;
+
+  const char *GetName() const override { return "Packed"; }
+
+  struct PackedInstance {
+    uint32_t x, y, z, w;
+  };
+  static PackedInstance PackInstance(const glm::mat4 &model, uint32_t material,
+                                     const glm::vec3 &boundsMin,
+                                     const glm::vec3 &inverseExtent);
+
+  static constexpr GLint CubeUnit = 5;
+  static constexpr GLint InstanceUnit = 6;
+
+private:
+  // Packs count objects, in DrawOrder() order if sorted
+  void Repack(size_t count, bool sorted, LinearArena &arena, RenderCounters *stats);
+
+  SceneStore::Programs programs;
+  GlVertexArray VAO; // core profile needs one bound, even empty
+  GlTexture instanceTexture;
+  glm::vec3 boundsMin = glm::vec3(0.0f);
+  glm::vec3 boundsExtent = glm::vec3(0.0f);
+  uint64_t packedOrder = ~uint64_t(0); // DrawOrderVersion() packed, 0 if unsorted
+};
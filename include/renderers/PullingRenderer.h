@@ -0,0 +1,35 @@
+#pragma once
+
+#include "IRenderStrategy.h"
+#include "core/SceneStore.h"
+#include "tools/GpuResources.h"
+
+class Shader;
+
+// Instanced draw with no vertex attributes at all: the vertex shader pulls
+// the cube vertex by gl_VertexID and the model matrix and material by
+// gl_InstanceID from buffer textures over the scene store's buffers
+class PullingRenderer : public IRenderStrategy {
+public:
+  PullingRenderer() = default;
+  ~PullingRenderer() override = default;
+
+  void Init() override;
+  void Render(const FrameContext &frame) override;
+  void Cleanup() override;
+
+  const char *GetName() const override { return "Pulling"; }
+
+  // Texture units after the ones SceneStore and ClusteredLights use
+  static constexpr GLint CubeUnit = 5;
+  static constexpr GLint MatrixUnit = 6;
+  static constexpr GLint MaterialUnit = 7;
+
+private:
+  SceneStore::Programs programs;
+  GlVertexArray VAO; // core profile needs one bound, even empty
+  // Views of the scene store's instance and material buffers; [1] is the
+  // copy in SceneStore::DrawOrder()
+  GlTexture matrixTexture[2];
+  GlTexture materialTexture[2];
+};
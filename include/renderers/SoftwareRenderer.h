@@ -0,0 +1,99 @@
+#pragma once
+
+#include "IRenderStrategy.h"
+#include "tools/GpuResources.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class FrameArenas;
+struct TextureImage;
+
+// CPU reference rasterizer. Objects are transformed, clipped against the near
+// plane and binned into screen tiles in parallel; tiles are then rasterized
+// in parallel with edge functions four pixels at a time, a float depth buffer
+// (GL_LESS) and nearest-texel sampling of each material's diffuse texture.
+// The colour buffer is uploaded and blitted into the default framebuffer.
+// Every tile replays its triangles in scene order, so the image does not
+// depend on the thread count.
+class SoftwareRenderer : public IRenderStrategy
+{
+public:
+    SoftwareRenderer() = default;
+    ~SoftwareRenderer() override = default;
+
+    void Init() override;
+    void Render(const FrameContext &frame) override;
+    void Cleanup() override;
+
+    const char* GetName() const override { return "Software"; }
+
+    static constexpr int TileSize = 64;
+    // Vertices snap to 1/SubpixelSteps of a pixel before setup
+    static constexpr float SubpixelSteps = 16.0f;
+
+    // Last frame, packed RGBA8 with rows bottom-up; Stride() pixels per row
+    const std::vector<uint32_t>& ColorBuffer() const { return color; }
+    int Width() const { return width; }
+    int Height() const { return height; }
+    int Stride() const { return stride; }
+
+    size_t lastTriangles = 0; // binned after clipping
+    double lastSetupMs = 0.0;
+    double lastRasterMs = 0.0;
+
+private:
+    struct Triangle {
+        // Edge i is opposite vertex i: E(x, y) = a * x + b * y + c, positive
+        // inside
+        float edgeA[3], edgeB[3], edgeC[3];
+        uint32_t ownedEdges; // bit i: pixels exactly on edge i belong here
+        int minX, minY, maxX, maxY;
+        float invArea;
+        // Vertex 0 value plus deltas to vertices 1 and 2
+        float z[3];    // window depth, linear in screen space
+        float invW[3];
+        float uOverW[3];
+        float vOverW[3];
+        glm::vec4 tint;
+        const unsigned char* texels;
+        int texWidth, texHeight;
+        uint32_t id; // object * 12 + triangle, the scene order
+    };
+
+    // Written by one thread during setup, read by every tile afterwards
+    struct ThreadBins {
+        std::vector<Triangle> triangles;
+        std::vector<std::vector<uint32_t>> tiles; // triangle indices per tile
+    };
+
+    struct ClipVertex {
+        glm::vec4 position;
+        glm::vec2 uv;
+    };
+
+    void Resize(int newWidth, int newHeight);
+    void SetupObject(size_t object, const FrameContext& frame,
+                     ThreadBins& bins);
+    void SetupTriangle(const ClipVertex* v, uint32_t id, const glm::vec4& tint,
+                       const TextureImage& image, ThreadBins& bins);
+    void RasterTile(int tile, FrameArenas& arenas);
+    void RasterTriangle(const Triangle& tri, int x0, int y0, int x1, int y1);
+
+    int width = 0;
+    int height = 0;
+    int stride = 0; // padded to whole tiles
+    int paddedHeight = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+
+    std::vector<uint32_t> color;
+    std::vector<float> depth;
+    std::vector<ThreadBins> threadBins;
+
+    GlTexture colorTexture;
+    GlFramebuffer readFramebuffer;
+};
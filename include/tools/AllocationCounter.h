@@ -0,0 +1,18 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Counts every heap allocation made through the global operator new (the
+// replacement lives in AllocationCounter.cpp). FrameStats samples the counter
+// around each frame to report allocations per frame. malloc calls made by C
+// libraries (ImGui, drivers, stb) are not seen.
+namespace AllocationCounter {
+
+uint64_t Count();
+uint64_t Bytes();
+
+} // namespace AllocationCounter
+
+#endif // ALLOCATION_COUNTER_H
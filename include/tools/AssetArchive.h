@@ -0,0 +1,93 @@
+#ifndef ASSET_ARCHIVE_H
+#define ASSET_ARCHIVE_H
+
+#include "tools/MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Packed asset archive (.rbpak), little-endian:
+//
+//   Header
+//   Entry[entryCount], sorted by pathHash
+//   path strings, not terminated
+//   blobs, each starting on a BlobAlignment boundary
+//
+// Paths are relative to the asset root with '/' separators, e.g.
+// "Shaders/naivecube.vs". Blobs are stored as is or, when that saves enough,
+// LZ4 block compressed; stored blobs can be used straight from the mapping.
+namespace AssetArchive {
+
+constexpr uint32_t Magic = 0x4B504252; // "RBPK"
+constexpr uint32_t Version = 1;
+constexpr uint64_t BlobAlignment = 64;
+// Largest blob the reader will decompress
+constexpr uint64_t MaxEntrySize = uint64_t(1) << 30;
+// LZ4 cannot expand a block by more than this
+constexpr uint64_t MaxExpansion = 255;
+
+enum EntryFlags : uint32_t {
+  Compressed = 1u << 0,
+};
+
+struct Header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t entryCount;
+  uint32_t reserved;
+  uint64_t entryTableOffset;
+  uint64_t stringsOffset;
+  uint64_t stringsSize;
+};
+
+struct Entry {
+  uint64_t pathHash;   // HashPath of the path
+  uint64_t offset;     // absolute file offset of the blob
+  uint64_t storedSize; // bytes in the file
+  uint64_t size;       // bytes after decompression
+  uint32_t pathOffset; // into the string block
+  uint32_t pathLength;
+  uint32_t flags;
+  uint32_t reserved;
+};
+
+// FNV-1a, 64 bit
+uint64_t HashPath(std::string_view path);
+
+// Packs every regular file under root. With compress, blobs that shrink by at
+// least an eighth are stored LZ4 compressed.
+bool Build(const std::string &path, const std::string &root, bool compress = true);
+
+// LZ4 block format without the frame. Compress replaces out; Decompress
+// fails unless the input fills exactly dstSize bytes.
+void Lz4Compress(const uint8_t *src, size_t size, std::vector<uint8_t> &out);
+bool Lz4Decompress(const uint8_t *src, size_t srcSize, uint8_t *dst,
+                   size_t dstSize);
+
+} // namespace AssetArchive
+
+// A mapped archive. Open() maps the file and validates the index once;
+// lookups binary search the hashes and compare the path only on a hit.
+class ArchiveReader {
+public:
+  bool Open(const std::string &path);
+  void Close();
+
+  const AssetArchive::Entry *Find(std::string_view path) const;
+  std::string_view Path(const AssetArchive::Entry &entry) const;
+
+  const MappedFile &File() const { return file; }
+  size_t Count() const { return header ? header->entryCount : 0; }
+  bool IsOpen() const { return header != nullptr; }
+
+private:
+  MappedFile file;
+  const AssetArchive::Header *header = nullptr;
+  const AssetArchive::Entry *entries = nullptr;
+  const char *strings = nullptr;
+};
+
+#endif // ASSET_ARCHIVE_H
@@ -0,0 +1,104 @@
+#ifndef AUTO_STRATEGY_H
+#define AUTO_STRATEGY_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+struct AutoStrategySettings {
+  // A switch needs the best prediction this fraction below the current one
+  float hysteresis = 0.15f;
+  int minDwellFrames = 120; // frames on a strategy before it may switch again
+  // Predictions are compared again when the object count moves this
+  // fraction away from the count of the last comparison, or after
+  // reviewFrames regardless
+  float workloadChange = 0.2f;
+  int reviewFrames = 240;
+  int warmupFrames = 10;  // skipped after every switch; GPU times lag
+  int exploreFrames = 30; // measured per strategy before the first choice
+  float decay = 0.98f;    // weight kept by older samples in the cost models
+};
+
+// Per-strategy cost against the object count, cost = a + b * count, fitted by
+// exponentially weighted least squares. With too little spread in the
+// counts seen the fit falls back to cost proportional to count.
+class StrategyCostModel {
+public:
+  void Add(double count, double costMs, double decay);
+  bool Empty() const { return weight <= 0.0; }
+  double Predict(double count) const;
+  // Whether a count this close to one already measured has been seen
+  bool Covers(double count, double tolerance) const;
+  double MinCount() const { return minCount; }
+  double MaxCount() const { return maxCount; }
+
+private:
+  double weight = 0.0;
+  double sumN = 0.0, sumC = 0.0, sumNN = 0.0, sumNC = 0.0;
+  double minCount = 0.0, maxCount = 0.0;
+};
+
+struct AutoDecision {
+  uint64_t frame = 0;
+  int objectCount = 0;
+  int from = -1; // strategy indices
+  int to = -1;
+  const char *reason = ""; // "explore", "choose" or "cheaper"
+  double measuredMs = 0.0; // current strategy's recent cost
+  std::vector<double> predictedMs; // per candidate, < 0 if not measured yet
+};
+
+// The "Auto" renderer choice. Measures each candidate strategy briefly,
+// then keeps a cost model per strategy from the frames it draws (the slower
+// of its CPU submit time and scene GPU time, by object count) and moves to
+// the strategy predicted cheapest for the current count. Switches need the
+// hysteresis margin and the dwell time; a count far from anything a model
+// has seen measures the candidates again instead of trusting it. Every
+// switch is logged with the predictions behind it. Candidates should draw
+// the same geometry, or cost per object compares different workloads.
+// Driven once per frame from the main loop like CapacitySearch, which
+// applies Strategy() to the next frame.
+class AutoStrategy {
+public:
+  // candidates are indices into names; current is the strategy in use and
+  // objectCount the count it draws
+  void Start(const AutoStrategySettings &settings, const std::vector<int> &candidates,
+             const char *const *names, int current, int objectCount);
+  void Stop() { running = false; }
+
+  // Feeds a frame the render thread finished with strategy at objectCount
+  void Update(uint64_t frame, int strategy, int objectCount, double cpuMs,
+              double gpuMs);
+
+  bool Running() const { return running; }
+  int Strategy() const { return strategy; }
+  bool Exploring() const { return !pending.empty(); }
+
+  const std::vector<AutoDecision> &Decisions() const { return decisions; }
+  void DrawImGui() const;
+  void WriteJson(std::ostream &os) const;
+
+private:
+  void SwitchTo(int next, uint64_t frame, int objectCount, const char *reason);
+  int CandidateSlot(int strategyIndex) const;
+  int Cheapest(int objectCount) const;
+
+  AutoStrategySettings settings;
+  std::vector<int> candidates;
+  std::vector<std::string> names; // every strategy, by index
+  std::vector<StrategyCostModel> models; // per candidate
+  bool running = false;
+
+  int strategy = 0;
+  int skip = 0;      // warm-up frames left
+  int dwell = 0;     // frames measured on the current strategy
+  int sinceReview = 0;
+  std::vector<int> pending; // strategies still to measure, current first
+  int reviewCount = 0;
+  double recentMs = 0.0; // smoothed cost of the current strategy
+
+  std::vector<AutoDecision> decisions;
+};
+
+#endif // AUTO_STRATEGY_H
@@ -0,0 +1,104 @@
+#ifndef BOTTLENECK_CLASSIFIER_H
+#define BOTTLENECK_CLASSIFIER_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+enum class Bottleneck { Unknown, Submission, Vertex, Fragment };
+const char *BottleneckName(Bottleneck bottleneck);
+
+struct BottleneckSettings {
+  float lowScale = 0.5f;        // render scale of the fragment probe
+  int vertexWork = 16;          // extra ALU passes per vertex in the vertex probe
+  float countFraction = 0.5f;   // object count of the submission probe
+  int warmupFrames = 30;        // skipped after every probe change
+  int switchWarmupFrames = 120; // skipped after a strategy change
+  int measureFrames = 90;
+  // Smallest score that names a GPU stage; below it the label is Unknown
+  float threshold = 0.2f;
+};
+
+// Medians over a probe's measured frames, ms
+struct BottleneckSample {
+  float frameMs = 0.0f;
+  float cpuMs = 0.0f; // render thread time inside the strategy's Render calls
+  float gpuMs = 0.0f; // scene pass on the GPU
+};
+
+struct BottleneckResult {
+  enum Probe { Baseline, Resolution, VertexLoad, Objects, ProbeCount };
+
+  std::string strategy;
+  int objectCount = 0;
+  int width = 0; // window size at full scale
+  int height = 0;
+  BottleneckSample probes[ProbeCount];
+
+  // 0..1. Submission is CPU over GPU time; fragment is the share of GPU time
+  // that followed the pixel count; vertex is the GPU time added by the
+  // vertex probe relative to the baseline.
+  float submission = 0.0f;
+  float fragment = 0.0f;
+  float vertex = 0.0f;
+  Bottleneck label = Bottleneck::Unknown;
+};
+
+// Labels a configuration as submission-, vertex- or fragment-bound by
+// perturbing one load at a time and watching CPU and GPU time respond:
+// the scene is drawn at a lower render scale (fewer fragments, same
+// vertices and draws), with extra vertex shader work (more vertex load,
+// same fragments and draws) and with fewer objects (less submission). A
+// stage that is not the bottleneck absorbs changes to its load. Driven once
+// per frame from the main loop like CapacitySearch, which applies
+// Strategy(), Count(), RenderScale() and VertexWork() to the next frame.
+class BottleneckClassifier {
+public:
+  // strategies are indices into names; each is analysed at objectCount
+  void Start(const BottleneckSettings &settings, const std::vector<int> &strategies,
+             const char *const *names, int objectCount, int width, int height);
+  void Stop();
+
+  // Feeds the frame that just finished
+  void Update(float frameMs, float cpuMs, float gpuMs);
+
+  bool Running() const { return running; }
+  int Strategy() const { return strategies.empty() ? 0 : strategies[current]; }
+  int Count() const;
+  float RenderScale() const;
+  int VertexWork() const;
+  const char *Phase() const;
+  // Fraction of probes finished
+  float Progress() const;
+
+  // Most recent finished result for a strategy, nullptr if none
+  const BottleneckResult *Latest(const char *strategy) const;
+  const std::vector<BottleneckResult> &Results() const { return results; }
+
+  void DrawImGui() const;
+  void WriteJson(std::ostream &os) const;
+
+private:
+  void BeginProbe(int probe, int warmup);
+  void FinishProbe();
+  void Classify(BottleneckResult &result) const;
+
+  BottleneckSettings settings;
+  std::vector<int> strategies;
+  std::vector<std::string> names;
+  int objectCount = 1;
+  int width = 0;
+  int height = 0;
+  bool running = false;
+
+  size_t current = 0;
+  int probe = 0;
+  int skip = 0; // warm-up frames left
+  std::vector<float> frameSamples;
+  std::vector<float> cpuSamples;
+  std::vector<float> gpuSamples;
+
+  std::vector<BottleneckResult> results;
+};
+
+#endif // BOTTLENECK_CLASSIFIER_H
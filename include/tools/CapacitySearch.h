@@ -0,0 +1,99 @@
+#ifndef CAPACITY_SEARCH_H
+#define CAPACITY_SEARCH_H
+
+#include "tools/FrameStats.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+struct CapacitySettings {
+  float budgetMs = 16.6f;
+  int percentile = 95; // 50, 95 or 99 of the frame time must fit the budget
+  int startCount = 256;
+  int warmupFrames = 30;        // skipped after every count change
+  int switchWarmupFrames = 120; // skipped after a strategy change
+  int measureFrames = 120;
+  // A step is stable when the two halves of its frames agree on the
+  // percentile within this fraction; unstable steps are measured again
+  float stabilityTolerance = 0.1f;
+  int maxRetries = 3;
+  // The binary search stops once the bracket is this fraction of the count
+  float precision = 0.02f;
+};
+
+struct CapacityPoint {
+  int count = 0;
+  Percentiles frame; // frame time over the measured frames, ms
+  bool withinBudget = false;
+  bool stable = false;
+};
+
+struct CapacityResult {
+  std::string strategy;
+  int capacity = 0;    // largest count within budget, 0 if none was
+  bool hitMax = false; // the scene ran out of objects first
+  std::vector<CapacityPoint> curve; // sorted by count
+};
+
+// Finds the largest object count each strategy can draw within a frame
+// budget. Per strategy it doubles the count until a step misses the budget,
+// then binary searches between the last hit and that miss. Every step warms
+// up, measures a window of frames and repeats itself while the window is
+// unstable. Driven once per frame from the main loop, which applies Count()
+// and Strategy() to the next frame.
+class CapacitySearch {
+public:
+  // strategies are indices into names; maxCount is the scene size
+  void Start(const CapacitySettings &settings, const std::vector<int> &strategies,
+             const char *const *names, int maxCount);
+  void Stop();
+
+  // Feeds the duration of the frame that just finished
+  void Update(float frameMs);
+
+  bool Running() const { return running; }
+  int Count() const { return count; }
+  int Strategy() const { return strategies.empty() ? 0 : strategies[current]; }
+  const char *Phase() const;
+  // Fraction of strategies finished
+  float Progress() const;
+
+  const std::vector<CapacityResult> &Results() const { return results; }
+  const CapacitySettings &Settings() const { return settings; }
+
+  void DrawImGui() const;
+  void WriteJson(std::ostream &os) const;
+  bool Export(const std::string &path) const;
+
+private:
+  enum class State { Idle, Ramp, Bisect };
+
+  void BeginStrategy();
+  void BeginStep(int stepCount, int warmup);
+  void FinishStep();
+  void FinishStrategy();
+  float Measure(const Percentiles &p) const;
+
+  CapacitySettings settings;
+  std::vector<int> strategies;
+  std::vector<std::string> names;
+  int maxCount = 1;
+  bool running = false;
+
+  State state = State::Idle;
+  size_t current = 0;
+  int count = 1;
+  int low = 0;  // largest count within budget so far
+  int high = 0; // smallest count over budget so far
+  int skip = 0; // warm-up frames left
+  int retries = 0;
+  std::vector<float> samples;
+  std::vector<float> scratch;
+  mutable std::vector<float> plotValues; // reused by DrawImGui each frame
+
+  std::vector<CapacityResult> results;
+};
+
+#endif // CAPACITY_SEARCH_H
@@ -7,7 +7,7 @@ struct GLFWwindow; // forward declaration
 
 class EngineConfig {
 public:
-    // Asset directories
+    // Asset directories, as VirtualFileSystem paths
     static std::string TextureDirectory;
     static std::string ShaderDirectory;
     static std::string CubemapDirectory;
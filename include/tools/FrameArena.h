@@ -0,0 +1,103 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for data that lives for one frame (staging, visible lists,
+// command packets). Allocation is a pointer bump and Reset() frees everything
+// at once. If a frame needs more than the block holds, the extra comes from
+// overflow blocks and the next Reset() grows the main block to the high-water
+// mark, so a steady-state frame never touches the heap.
+class LinearArena {
+public:
+  explicit LinearArena(size_t initialCapacity = 1 << 20);
+
+  LinearArena(const LinearArena &) = delete;
+  LinearArena &operator=(const LinearArena &) = delete;
+
+  void *Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+  // Uninitialised storage; only for trivially destructible types since
+  // nothing is ever destroyed
+  template <typename T> T *AllocateArray(size_t count) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "arena memory is released without running destructors");
+    return static_cast<T *>(Allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void Reset();
+
+  size_t Used() const { return offset + overflowBytes; }
+  size_t Capacity() const { return capacity; }
+  size_t HighWater() const { return highWater; }
+
+private:
+  std::unique_ptr<std::byte[]> block;
+  size_t capacity = 0;
+  size_t offset = 0;
+
+  std::vector<std::unique_ptr<std::byte[]>> overflow;
+  size_t overflowBytes = 0;
+  size_t highWater = 0;
+};
+
+// Fixed-capacity array in arena memory; push_back never reallocates.
+template <typename T> class ArenaVector {
+public:
+  ArenaVector() = default;
+  ArenaVector(LinearArena &arena, size_t capacity)
+      : items(arena.AllocateArray<T>(capacity)), capacity(capacity) {}
+
+  void push_back(const T &value) {
+    assert(count < capacity && "ArenaVector capacity exceeded");
+    items[count++] = value;
+  }
+  void clear() { count = 0; }
+
+  T &operator[](size_t i) { return items[i]; }
+  const T &operator[](size_t i) const { return items[i]; }
+  T &back() { return items[count - 1]; }
+  T *begin() { return items; }
+  T *end() { return items + count; }
+  const T *begin() const { return items; }
+  const T *end() const { return items + count; }
+  T *data() { return items; }
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+private:
+  T *items = nullptr;
+  size_t count = 0;
+  size_t capacity = 0;
+};
+
+// One arena per job system thread, reset together at the start of a frame.
+// Workers allocate from Local() without locking.
+class FrameArenas {
+public:
+  explicit FrameArenas(int threadCount);
+
+  LinearArena &Local();
+  LinearArena &Thread(int index) { return *arenas[index]; }
+  int ThreadCount() const { return static_cast<int>(arenas.size()); }
+
+  // Call from the frame loop when no jobs are running
+  void Reset();
+
+  size_t Used() const;
+  size_t Capacity() const;
+
+  // Sized for JobSystem::Shared()
+  static FrameArenas &Shared();
+
+private:
+  std::vector<std::unique_ptr<LinearArena>> arenas;
+};
+
+#endif // FRAME_ARENA_H
@@ -0,0 +1,73 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include "tools/GpuResources.h"
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Timestamps of one frame on its way from input to screen, in steady_clock
+// nanoseconds (the profiler's clock). Zero until the stage is reached.
+struct FrameTimeline {
+  uint64_t frame = 0;
+  const char *renderer = ""; // strategy that drew it, a literal
+  uint64_t inputNs = 0;       // input sampled on the main thread
+  uint64_t submitBeginNs = 0; // first GL call of the frame
+  uint64_t submitEndNs = 0;   // last GL call before the swap
+  uint64_t swapNs = 0;        // glfwSwapBuffers returned
+  uint64_t gpuDoneNs = 0;     // GPU passed the swap
+};
+
+// Bounds how far the CPU runs ahead of the GPU. Every presented frame gets a
+// fence and a GL_TIMESTAMP query right after the swap; Throttle() blocks on
+// the oldest fence until fewer than the requested number of frames are
+// unfinished. The query tells when the GPU really got past the swap, so
+// finished timelines carry a precise gpuDoneNs. Render thread only.
+class FramePacer {
+public:
+  static constexpr int MaxFramesInFlight = 4;
+
+  ~FramePacer() { Shutdown(); }
+
+  void Init();
+  // Waits for every fenced frame, then frees the fences and queries
+  void Shutdown();
+
+  // Before the frame's first GL call. limit <= 0 leaves queuing to the
+  // driver. Finished frames go to done; returns the nanoseconds spent waiting.
+  uint64_t Throttle(int limit, std::vector<FrameTimeline> &done);
+  // After the swap
+  void Fence(const FrameTimeline &timeline);
+  // Blocks until the GPU has finished everything fenced
+  uint64_t Drain(std::vector<FrameTimeline> &done);
+  // Collects finished frames without waiting
+  void Poll(std::vector<FrameTimeline> &done);
+
+  size_t InFlight() const { return count; }
+  bool IsInitialized() const { return !slots.empty(); }
+
+  // GPU to CPU clock offset, as GpuTimer::Calibrate
+  void Calibrate();
+
+private:
+  struct Slot {
+    GlQuery query;
+    GLsync fence = nullptr;
+    FrameTimeline timeline;
+  };
+
+  // Fences beyond MaxFramesInFlight only exist with the limit off
+  static constexpr size_t RingSize = 8;
+
+  // Retires the oldest slot; false if it is still running and wait is false
+  bool Retire(bool wait, std::vector<FrameTimeline> &done);
+
+  std::vector<Slot> slots;
+  size_t oldest = 0;
+  size_t count = 0;
+  int64_t gpuToCpuNs = 0;
+};
+
+#endif // FRAME_PACER_H
@@ -0,0 +1,113 @@
+#ifndef FRAME_READBACK_H
+#define FRAME_READBACK_H
+
+#include "tools/GpuResources.h"
+
+#include <glad/glad.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// What to do with a captured frame once it reaches the worker. The hash is
+// always computed.
+struct ReadbackRequest {
+  std::string label;      // shown in results, e.g. the strategy name
+  std::string savePath;   // write a PNG here if set
+  std::string goldenPath; // compare against this PNG if set
+  int tolerance = 0;      // per channel difference still counted as equal
+};
+
+struct ReadbackResult {
+  uint64_t frame = 0;
+  std::string label;
+  int width = 0;
+  int height = 0;
+  uint64_t hash = 0; // FNV-1a over the top-down RGBA rows
+  bool saved = false;
+  bool compared = false;
+  bool matched = false;
+  size_t differingPixels = 0;
+  int maxDelta = 0;
+  double latencyFrames = 0.0; // frames between capture and mapping
+};
+
+// Gets rendered frames out of the GPU without stalling it. Capture() copies
+// the back buffer into one of a ring of pixel pack buffers and fences it;
+// Poll() maps only buffers whose fence has already signalled, copies the
+// pixels into a recycled CPU buffer and hands them to a worker thread that
+// hashes, saves or diffs them against a golden image. The render thread never
+// waits on the GPU or on file I/O.
+class FrameReadback {
+public:
+  FrameReadback() = default;
+  ~FrameReadback();
+
+  FrameReadback(const FrameReadback &) = delete;
+  FrameReadback &operator=(const FrameReadback &) = delete;
+
+  static constexpr int RingSize = 4;
+
+  void Init();
+  // Drains outstanding captures, then stops the worker
+  void Shutdown();
+
+  // Reads the currently bound read framebuffer (call before UI drawing).
+  // Returns false, dropping the capture, if every ring slot is in flight.
+  bool Capture(uint64_t frame, int width, int height,
+               const ReadbackRequest &request);
+
+  // Once per frame
+  void Poll(uint64_t frame);
+
+  // Finished results, oldest first
+  bool PopResult(ReadbackResult &out);
+
+  size_t InFlight() const;
+  size_t Queued() const;
+  size_t Dropped() const { return dropped; }
+
+private:
+  struct Slot {
+    GlBuffer buffer;
+    GLsync fence = nullptr;
+    size_t capacity = 0;
+    uint64_t frame = 0;
+    int width = 0;
+    int height = 0;
+    ReadbackRequest request;
+  };
+
+  struct Job {
+    std::vector<unsigned char> pixels;
+    uint64_t frame = 0;
+    int width = 0;
+    int height = 0;
+    double latencyFrames = 0.0;
+    ReadbackRequest request;
+  };
+
+  void Run();
+  void Process(Job &job, ReadbackResult &result);
+  void Submit(Slot &slot, uint64_t frame);
+
+  std::vector<Slot> slots;
+  size_t dropped = 0;
+
+  std::thread worker;
+  mutable std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable idle;
+  std::deque<Job> jobs;
+  std::vector<std::vector<unsigned char>> spare; // recycled pixel buffers
+  std::deque<ReadbackResult> results;
+  bool busy = false;
+  bool stopping = false;
+};
+
+#endif // FRAME_READBACK_H
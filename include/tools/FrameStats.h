@@ -0,0 +1,149 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// One entry per presented frame. All times are in milliseconds.
+struct FrameSample {
+  uint64_t frameIndex = 0;
+  float frameMs = 0.0f;   // present-to-present interval
+  float cpuMs = 0.0f;     // frame start until submission is done
+  float gpuMs = -1.0f;    // GPU timer result, negative until resolved
+  float presentMs = 0.0f; // time spent inside glfwSwapBuffers
+  uint32_t allocations = 0; // heap allocations through operator new
+  const char *event = nullptr; // optional annotation, must be a literal
+};
+
+// Single-writer ring of frame samples. Every slot carries a sequence counter
+// (seqlock) so the UI, exporters or other threads can copy samples without
+// ever blocking the frame loop that writes them.
+class FrameSampleRing {
+public:
+  static constexpr size_t Capacity = 4096;
+
+  void Push(const FrameSample &sample);
+  // Patches the GPU time of a frame that is still in the ring.
+  bool SetGpuTime(uint64_t frameIndex, float gpuMs);
+  bool Read(uint64_t frameIndex, FrameSample &out) const;
+  // Copies up to maxCount of the newest samples, oldest first.
+  size_t Snapshot(FrameSample *out, size_t maxCount) const;
+  uint64_t Count() const { return head.load(std::memory_order_acquire); }
+
+private:
+  struct Slot {
+    std::atomic<uint32_t> seq{0};
+    FrameSample sample;
+  };
+
+  void Write(Slot &slot, const FrameSample &sample);
+
+  std::array<Slot, Capacity> slots;
+  std::atomic<uint64_t> head{0};
+};
+
+enum class HitchReason { Cpu, Gpu, Present, Event, Count };
+
+const char *HitchReasonName(HitchReason reason);
+
+struct Percentiles {
+  float p50 = 0.0f;
+  float p95 = 0.0f;
+  float p99 = 0.0f;
+  float max = 0.0f;
+};
+
+// Nearest-rank percentiles. Reorders values in place.
+Percentiles ComputePercentiles(std::vector<float> &values);
+// {"p50": .., "p95": .., "p99": .., "max": ..}
+void WritePercentiles(std::ostream &os, const Percentiles &p);
+
+struct FrameStatsSummary {
+  size_t sampleCount = 0;
+  float meanMs = 0.0f;
+  Percentiles frame;
+  Percentiles cpu;
+  Percentiles gpu;
+  Percentiles present;
+  uint32_t allocationsMax = 0;
+  float allocationsMean = 0.0f;
+};
+
+struct HitchRecord {
+  uint64_t frameIndex = 0;
+  float frameMs = 0.0f;
+  float medianMs = 0.0f;
+  HitchReason reason = HitchReason::Cpu;
+  const char *event = nullptr;
+};
+
+// Collects per-frame CPU/GPU/present times, keeps rolling percentiles over a
+// window of recent frames and flags hitches (frames slower than
+// hitchMultiplier x median) together with the component that caused them.
+class FrameStats {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  FrameStats();
+
+  void BeginFrame();
+  void EndSubmit();
+  void EndFrame();
+
+  void SetGpuTime(uint64_t frameIndex, float gpuMs);
+  // Tags the current frame (e.g. "renderer switch"). Pass a string literal.
+  void Annotate(const char *event);
+
+  uint64_t FrameIndex() const { return frameIndex; }
+  const FrameStatsSummary &Summary() const { return summary; }
+  const FrameSampleRing &Samples() const { return ring; }
+
+  void ResetHitches();
+  void DrawImGui();
+  void WriteJson(std::ostream &os) const;
+  bool ExportCsv(const std::string &path) const;
+
+  int windowSize = 600;
+  float hitchMultiplier = 2.0f;
+  bool gpuTimingEnabled = true;
+
+  // Steady state = this many frames without an annotated event. When
+  // asserting, any heap allocation in a steady-state frame is reported and
+  // trips an assert in debug builds.
+  bool assertZeroAllocations = false;
+  int steadyStateFrames = 120;
+  uint64_t steadyAllocationFrames = 0;
+
+private:
+  void UpdateSummary();
+  void EvaluateHitches();
+  void ClassifyHitch(const FrameSample &sample);
+
+  FrameSampleRing ring;
+  FrameStatsSummary summary;
+
+  uint64_t frameIndex = 0;
+  uint64_t lastEvaluated = 0;
+  Clock::time_point frameStart;
+  Clock::time_point lastFrameEnd;
+  Clock::time_point submitEnd;
+  const char *pendingEvent = nullptr;
+  uint64_t frameStartAllocations = 0;
+  uint64_t framesSinceEvent = 0;
+
+  std::vector<FrameSample> window;
+  std::vector<float> scratch;
+
+  static constexpr size_t MaxHitchRecords = 64;
+  std::vector<HitchRecord> hitches;
+  uint64_t hitchCount = 0;
+  std::array<uint64_t, static_cast<size_t>(HitchReason::Count)> reasonCounts{};
+  std::vector<std::pair<const char *, uint64_t>> eventCounts;
+};
+
+#endif // FRAME_STATS_H
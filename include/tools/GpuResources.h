@@ -0,0 +1,138 @@
+#ifndef GPU_RESOURCES_H
+#define GPU_RESOURCES_H
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <source_location>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+enum class GpuResourceType {
+  Buffer,
+  Texture,
+  VertexArray,
+  Query,
+  Program,
+  Framebuffer,
+  Count
+};
+
+const char *GpuResourceTypeName(GpuResourceType type);
+
+struct GpuResourceRecord {
+  GpuResourceType type = GpuResourceType::Buffer;
+  GLuint id = 0;
+  size_t bytes = 0;
+  const char *owner = nullptr; // subsystem tag, must outlive the resource
+  const char *file = nullptr;
+  uint32_t line = 0;
+  uint64_t serial = 0; // creation order
+};
+
+// Central registry of every live GL object: who owns it, how big it is and
+// where it was created. Drives the per-subsystem memory breakdown and the
+// leak reports at shutdown and on strategy switches. Owners are compared by
+// string contents, so any literal tag works.
+class GpuResourceTracker {
+public:
+  struct OwnerUsage {
+    const char *owner = nullptr;
+    std::array<size_t, static_cast<size_t>(GpuResourceType::Count)> counts{};
+    size_t bytes = 0;
+  };
+
+  static GpuResourceTracker &Get();
+
+  void Track(GpuResourceType type, GLuint id, const char *owner,
+             const std::source_location &site);
+  void Untrack(GpuResourceType type, GLuint id);
+  void SetBytes(GpuResourceType type, GLuint id, size_t bytes);
+
+  size_t LiveCount() const;
+  size_t TotalBytes() const;
+  // Refills out, largest owner first
+  void Breakdown(std::vector<OwnerUsage> &out) const;
+
+  // Lists resources still alive for owner (every owner if nullptr) and
+  // returns how many there were
+  size_t ReportLeaks(const char *owner, std::ostream &os) const;
+
+  void DrawImGui();
+
+private:
+  static uint64_t Key(GpuResourceType type, GLuint id) {
+    return (static_cast<uint64_t>(type) << 32) | id;
+  }
+
+  mutable std::mutex mutex;
+  std::unordered_map<uint64_t, GpuResourceRecord> live;
+  uint64_t nextSerial = 0;
+
+  std::vector<OwnerUsage> breakdown; // reused by DrawImGui
+};
+
+// glGen*/glDelete* for each resource type
+GLuint CreateGpuResource(GpuResourceType type);
+void DestroyGpuResource(GpuResourceType type, GLuint id);
+
+// Owning, move-only GL object name. Create() generates and registers the
+// object, the destructor (or Reset) deletes and unregisters it. Converts to
+// GLuint so it drops into existing gl* calls.
+template <GpuResourceType Type> class GlHandle {
+public:
+  GlHandle() = default;
+  ~GlHandle() { Reset(); }
+
+  GlHandle(const GlHandle &) = delete;
+  GlHandle &operator=(const GlHandle &) = delete;
+  GlHandle(GlHandle &&other) noexcept : id(std::exchange(other.id, 0)) {}
+  GlHandle &operator=(GlHandle &&other) noexcept {
+    if (this != &other) {
+      Reset();
+      id = std::exchange(other.id, 0);
+    }
+    return *this;
+  }
+
+  void Create(const char *owner,
+              std::source_location site = std::source_location::current()) {
+    Reset();
+    id = CreateGpuResource(Type);
+    GpuResourceTracker::Get().Track(Type, id, owner, site);
+  }
+
+  void Reset() {
+    if (!id)
+      return;
+    GpuResourceTracker::Get().Untrack(Type, id);
+    DestroyGpuResource(Type, id);
+    id = 0;
+  }
+
+  // Reported size; call after (re)allocating storage
+  void SetBytes(size_t bytes) {
+    if (id)
+      GpuResourceTracker::Get().SetBytes(Type, id, bytes);
+  }
+
+  GLuint Get() const { return id; }
+  operator GLuint() const { return id; }
+  explicit operator bool() const { return id != 0; }
+
+private:
+  GLuint id = 0;
+};
+
+using GlBuffer = GlHandle<GpuResourceType::Buffer>;
+using GlTexture = GlHandle<GpuResourceType::Texture>;
+using GlVertexArray = GlHandle<GpuResourceType::VertexArray>;
+using GlQuery = GlHandle<GpuResourceType::Query>;
+using GlFramebuffer = GlHandle<GpuResourceType::Framebuffer>;
+
+#endif // GPU_RESOURCES_H
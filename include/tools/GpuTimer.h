@@ -0,0 +1,53 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include "tools/GpuResources.h"
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Measures GPU time between Begin() and End() with a pair of GL_TIMESTAMP
+// queries per frame. Results are read back a few frames later so the CPU never
+// waits on the GPU; Poll() hands out every frame whose queries have landed.
+class GpuTimer {
+public:
+  void Init(int latency = 4);
+  void Shutdown();
+
+  void Begin(uint64_t frameIndex);
+  void End();
+
+  // Returns true and fills frameIndex/ms for the oldest resolved frame.
+  // Call until it returns false.
+  bool Poll(uint64_t &frameIndex, float &ms);
+
+  // GPU span of the frame last returned by Poll, converted to steady_clock
+  // nanoseconds (the profiler's clock)
+  uint64_t LastStartNs() const { return lastStartNs; }
+  uint64_t LastEndNs() const { return lastEndNs; }
+
+  // Re-measures the GPU to CPU clock offset; the two clocks drift, so call it
+  // now and then (Init calls it once)
+  void Calibrate();
+
+  bool IsInitialized() const { return !slots.empty(); }
+
+private:
+  struct Slot {
+    GlQuery queries[2];
+    uint64_t frameIndex = 0;
+    bool pending = false;
+  };
+
+  std::vector<Slot> slots;
+  size_t writeSlot = 0;
+  size_t readSlot = 0;
+
+  int64_t gpuToCpuNs = 0;
+  uint64_t lastStartNs = 0;
+  uint64_t lastEndNs = 0;
+};
+
+#endif // GPU_TIMER_H
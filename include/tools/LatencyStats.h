@@ -0,0 +1,51 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include "tools/FramePacer.h"
+#include "tools/FrameStats.h"
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+// Latency distributions of one strategy, all in milliseconds
+struct LatencySummary {
+  const char *renderer = "";
+  size_t sampleCount = 0;
+  float fps = 0.0f;    // presents per second over the window
+  Percentiles queue;   // input sampled -> first GL call
+  Percentiles submit;  // first GL call -> swap returned
+  Percentiles present; // input sampled -> swap returned
+  Percentiles gpu;     // input sampled -> GPU past the swap
+};
+
+// Finished frame timelines, kept per strategy over a window of recent frames
+// so latency can be compared next to throughput. Main thread only.
+class LatencyStats {
+public:
+  void Add(const FrameTimeline &timeline);
+  // Recomputes the summaries of strategies that got new frames
+  void Update();
+  void Reset() { series.clear(); }
+
+  void DrawImGui() const;
+  void WriteJson(std::ostream &os) const;
+
+  size_t windowSize = 600;
+
+private:
+  struct Series {
+    const char *renderer = "";
+    std::vector<FrameTimeline> frames; // ring of windowSize
+    size_t next = 0;
+    bool dirty = false;
+    LatencySummary summary;
+  };
+
+  void Summarize(Series &s);
+
+  std::vector<Series> series;
+  std::vector<float> scratch;
+};
+
+#endif // LATENCY_STATS_H
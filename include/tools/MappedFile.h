@@ -0,0 +1,36 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file. Pages are faulted in lazily by the
+// OS, Prefetch() only hints that a range will be needed soon.
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool Open(const std::string &path);
+  void Close();
+
+  void Prefetch(size_t offset, size_t length) const;
+
+  const uint8_t *Data() const { return data; }
+  size_t Size() const { return size; }
+  bool IsOpen() const { return data != nullptr; }
+
+private:
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+#ifdef _WIN32
+  void *fileHandle = nullptr;
+  void *mappingHandle = nullptr;
+#endif
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,84 @@
+#ifndef MULTI_VIEW_H
+#define MULTI_VIEW_H
+
+#include "core/FrameContext.h"
+#include "tools/GpuResources.h"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <iosfwd>
+
+// How the scene is drawn when several views are wanted at once
+enum class MultiViewMode {
+  Off,
+  Repeat,  // the active strategy's Render once per view, layer by layer
+  Layered, // LayeredRenderer: every view in one submission
+  Count
+};
+const char *MultiViewModeName(MultiViewMode mode);
+
+struct MultiViewSettings {
+  static constexpr int MaxViews = 6;
+  MultiViewMode mode = MultiViewMode::Off;
+  int viewCount = MaxViews; // cubemap faces, +X first
+  int layerSize = 512;      // square, per view
+};
+
+// Up to six cubemap faces around frame's camera (+X, -X, +Y, -Y, +Z, -Z),
+// size x size each; the per-frame fields are copied from frame
+void BuildCubeViews(const FrameContext &frame, int count, int size,
+                    FrameContext *views);
+
+// Colour and depth texture arrays with one layer per view. BeginLayered()
+// binds every layer at once, so gl_Layer picks one; BeginLayer() binds a
+// single layer for drawing view by view. Present() tiles the layers onto
+// the default framebuffer.
+class MultiViewTarget {
+public:
+  void Init();
+  void Shutdown();
+
+  // Both bind the target at size x size, set the viewport and clear
+  void BeginLayered(int size, int layers);
+  void BeginLayer(int size, int layers, int layer);
+  void Present(int windowWidth, int windowHeight);
+
+private:
+  void Resize(int newSize, int newLayers);
+
+  GlFramebuffer layered;
+  GlFramebuffer single[MultiViewSettings::MaxViews];
+  GlTexture color;
+  GlTexture depth;
+  int size = 0;
+  int layers = 0;
+};
+
+// Scene cost per view of each mode, averaged over windows of Window frames;
+// a window restarts when the view count changes
+class MultiViewCost {
+public:
+  static constexpr int Window = 60;
+
+  void Add(MultiViewMode mode, int views, const RenderCounters &counters,
+           float gpuMs);
+  void DrawImGui() const;
+  void WriteJson(std::ostream &os) const;
+
+private:
+  struct Entry {
+    int views = 0;
+    uint64_t frames = 0;
+    double cpuMs = 0.0; // submit time per view
+    double gpuMs = 0.0; // scene pass per view
+    double drawCalls = 0.0;
+    double instances = 0.0;
+  };
+  static constexpr int ModeCount = static_cast<int>(MultiViewMode::Count);
+
+  Entry latest[ModeCount];
+  Entry pending[ModeCount]; // sums until the window closes
+};
+
+#endif // MULTI_VIEW_H
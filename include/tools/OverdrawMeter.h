@@ -0,0 +1,67 @@
+#ifndef OVERDRAW_METER_H
+#define OVERDRAW_METER_H
+
+#include "tools/GpuResources.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Shader;
+
+// How the strategies submit the scene each frame
+enum class SubmissionMode {
+  Unsorted,     // scene order
+  FrontToBack,  // sorted by view depth (SceneStore::UpdateDrawOrder)
+  DepthPrepass, // depth-only pass, then shading with GL_EQUAL
+  Count
+};
+const char *SubmissionModeName(SubmissionMode mode);
+
+// Measures overdraw as fragments that pass the depth test while shading. A
+// GL_SAMPLES_PASSED query per frame gives the total, read back a few frames
+// later like GpuTimer; divided by the pixel count it is the average number
+// of layers shaded per pixel. With the heatmap on, every such fragment also
+// increments the stencil buffer and DrawHeatmap() paints the per-pixel
+// counts as colour bands.
+class OverdrawMeter {
+public:
+  // The last band means "this many or more"
+  static constexpr int HeatLevels = 16;
+
+  void Init(int latency = 4);
+  void Shutdown();
+
+  // Around the shading pass only
+  void Begin(uint64_t frameIndex, bool heatmap);
+  void End();
+
+  // Replaces the colour buffer with the stencil counts; shader is
+  // heatmap.vs/heatmap.fs
+  void DrawHeatmap(const Shader &shader) const;
+
+  // Returns true and fills frameIndex/samples for the oldest resolved frame.
+  // Call until it returns false.
+  bool Poll(uint64_t &frameIndex, uint64_t &samples);
+
+  // Colour of band level (0 = nothing drawn)
+  static glm::vec4 HeatColor(int level);
+
+private:
+  struct Slot {
+    GlQuery query;
+    uint64_t frameIndex = 0;
+    bool pending = false;
+  };
+
+  std::vector<Slot> slots;
+  size_t writeSlot = 0;
+  size_t readSlot = 0;
+  bool stencilActive = false;
+  GlVertexArray emptyVAO; // the full-screen triangle has no attributes
+};
+
+#endif // OVERDRAW_METER_H
@@ -0,0 +1,14 @@
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+#include <string>
+
+namespace PngWriter {
+// Writes 8-bit RGBA rows (top row first) as an uncompressed PNG. Stored
+// deflate blocks keep the encoder trivial and fast; captures are for
+// validation, not distribution.
+bool Write(const std::string &path, int width, int height,
+           const unsigned char *rgba);
+} // namespace PngWriter
+
+#endif // PNG_WRITER_H
@@ -0,0 +1,171 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Build with -DRENDERBENCH_PROFILE=0 to compile every PROFILE_* macro away
+#ifndef RENDERBENCH_PROFILE
+#define RENDERBENCH_PROFILE 1
+#endif
+
+// One finished scope, as read back from a thread buffer
+struct ProfileEvent {
+  const char *name = nullptr; // string literal
+  uint64_t startNs = 0;
+  uint64_t endNs = 0;
+  uint32_t depth = 0;
+  uint32_t thread = 0; // index into Profiler::ThreadName
+  uint64_t frame = 0;  // GPU spans only
+};
+
+// Hierarchical CPU scope profiler. Each thread records into its own ring of
+// events with no locking; only the first event on a thread takes a lock to
+// register its ring, and rings of exited threads are reused by the next new
+// thread. Timestamps are steady_clock nanoseconds, the same clock GpuTimer
+// converts GPU timestamps into, so CPU scopes and GPU frames share a timeline
+// in the flame view and the Chrome trace export.
+class Profiler {
+public:
+  static constexpr size_t EventsPerThread = 1 << 15;
+  static constexpr size_t FrameHistory = 256;
+
+  static Profiler &Get();
+  static uint64_t Now();
+
+  // Called on scope exit; depth is the nesting level on this thread
+  void Record(const char *name, uint64_t startNs, uint64_t endNs, uint32_t depth);
+  // GPU span of one frame, already on the CPU clock
+  void RecordGpu(uint64_t frameIndex, uint64_t startNs, uint64_t endNs);
+  // Names the calling thread in the flame view and traces
+  void SetThreadName(const char *name);
+
+  // Marks the start of a frame on the main thread
+  void BeginFrame(uint64_t frameIndex);
+
+  // Runtime switch; scopes still cost one relaxed load while disabled
+  void SetEnabled(bool enabled) { active.store(enabled, std::memory_order_relaxed); }
+  bool Enabled() const { return active.load(std::memory_order_relaxed); }
+
+  // Every event still in the rings that overlaps [fromNs, toNs), GPU frames
+  // first (thread GpuThread)
+  void Collect(uint64_t fromNs, uint64_t toNs, std::vector<ProfileEvent> &out) const;
+  std::string ThreadName(uint32_t thread) const;
+
+  // Writes the last frames (up to FrameHistory) as Chrome trace JSON, which
+  // chrome://tracing and Perfetto both open
+  bool ExportChromeTrace(const char *path, size_t frames) const;
+
+  // Flame view of the most recent complete frame
+  void DrawImGui();
+
+  static constexpr uint32_t GpuThread = 0xFFFF;
+
+private:
+  struct Slot {
+    std::atomic<const char *> name{nullptr};
+    std::atomic<uint64_t> startNs{0};
+    std::atomic<uint64_t> endNs{0};
+    std::atomic<uint32_t> depth{0};
+  };
+
+  // Single writer (its thread); readers check the write count before and
+  // after copying and drop anything the writer may have lapped
+  struct ThreadBuffer {
+    std::unique_ptr<Slot[]> slots{new Slot[EventsPerThread]};
+    std::atomic<uint64_t> written{0};
+    std::string name;
+    uint32_t index = 0;
+    bool inUse = true; // guarded by registry
+  };
+
+  // Returns the calling thread's ring to the registry when the thread exits
+  struct LocalHandle {
+    ThreadBuffer *buffer = nullptr;
+    ~LocalHandle();
+  };
+  static thread_local LocalHandle local;
+
+  struct FrameMark {
+    uint64_t frameIndex = 0;
+    uint64_t startNs = 0;
+  };
+
+  struct GpuSpan {
+    uint64_t frameIndex = 0;
+    uint64_t startNs = 0;
+    uint64_t endNs = 0;
+  };
+
+  ThreadBuffer &Local();
+  void Release(ThreadBuffer &buffer);
+  bool FrameWindow(size_t framesBack, size_t frames, uint64_t &fromNs,
+                   uint64_t &toNs) const;
+
+  std::atomic<bool> active{true};
+
+  mutable std::mutex registry;
+  std::vector<std::unique_ptr<ThreadBuffer>> threads;
+
+  // Main thread only
+  std::vector<FrameMark> frames = std::vector<FrameMark>(FrameHistory);
+  uint64_t frameCount = 0;
+  std::vector<GpuSpan> gpu = std::vector<GpuSpan>(FrameHistory);
+  uint64_t gpuCount = 0;
+
+  // Flame view state
+  std::vector<ProfileEvent> view;
+  uint64_t viewFromNs = 0;
+  uint64_t viewToNs = 0;
+  bool paused = false;
+  float zoom = 1.0f;
+};
+
+#if RENDERBENCH_PROFILE
+
+extern thread_local uint32_t profileDepth;
+
+class ProfileScope {
+public:
+  explicit ProfileScope(const char *name)
+      : name(Profiler::Get().Enabled() ? name : nullptr) {
+    if (this->name) {
+      depth = profileDepth++;
+      start = Profiler::Now();
+    }
+  }
+  ~ProfileScope() {
+    if (name) {
+      profileDepth--;
+      Profiler::Get().Record(name, start, Profiler::Now(), depth);
+    }
+  }
+
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+  const char *name;
+  uint64_t start = 0;
+  uint32_t depth = 0;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// name must be a string literal (or otherwise outlive the profiler)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::Get().SetThreadName(name)
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,230 @@
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include "core/FrameContext.h"
+#include "tools/FramePacer.h"
+#include "tools/FrameReadback.h"
+#include "tools/MultiView.h"
+#include "tools/OverdrawMeter.h"
+
+#include <imgui.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct GLFWwindow;
+
+// Deep copy of one ImGui frame's draw lists, so the main thread can build
+// the next UI frame while this one is drawn. Lists and their buffers are
+// kept between captures; a steady UI copies without allocating.
+class UiDrawData {
+public:
+  UiDrawData() = default;
+  ~UiDrawData();
+
+  UiDrawData(const UiDrawData &) = delete;
+  UiDrawData &operator=(const UiDrawData &) = delete;
+
+  void Capture(const ImDrawData *source);
+  // Null until the first capture
+  ImDrawData *Get() { return data.Valid ? &data : nullptr; }
+
+private:
+  ImDrawData data;
+  std::vector<ImDrawList *> lists;
+};
+
+// Switches set from the UI; plain values, read by the render thread when it
+// draws the snapshot that carries them
+struct RenderSettings {
+  int rendererIndex = 0;
+  SubmissionMode submission = SubmissionMode::Unsorted;
+  bool overdrawHeatmap = false;
+  bool vsync = false;
+  int framesInFlight = 2; // GPU queue limit, 0 leaves it to the driver
+  // Drain the GPU after every frame and hold the main thread until then, so
+  // input is sampled right before the next frame is built
+  bool lowLatency = false;
+  // The scene is drawn offscreen at this fraction of the window size and
+  // stretched onto it; the UI stays at full size
+  float renderScale = 1.0f;
+  int vertexWork = 0; // SceneStore::SetVertexWork
+  MultiViewSettings multiView;
+  bool capture = false; // capture this frame with captureRequest
+  ReadbackRequest captureRequest;
+};
+
+// Everything the render thread needs for one frame. The main thread fills a
+// snapshot and does not touch it again until the render thread is done.
+struct FrameSnapshot {
+  // The scene viewport; smaller than the window below render scale 1
+  FrameContext frame;
+  int windowWidth = 1;
+  int windowHeight = 1;
+  RenderSettings settings;
+  // Cubemap faces drawn instead of frame while a multi-view mode is on;
+  // frame still drives the scene update
+  FrameContext views[MultiViewSettings::MaxViews];
+  int viewCount = 0;
+  // GL work the UI asked for (texture rebuilds and such), run in order
+  // before the frame is drawn
+  std::vector<std::function<void()>> commands;
+  UiDrawData ui;
+  // frame and inputNs from the main thread, the rest stamped on the way
+  FrameTimeline timeline;
+};
+
+// Results flowing back from the render thread. Events accumulate until the
+// main thread takes them; the other fields hold the latest values.
+struct RenderReport {
+  struct GpuFrame {
+    uint64_t frame = 0;
+    float ms = 0.0f;
+    uint64_t startNs = 0;
+    uint64_t endNs = 0;
+  };
+  std::vector<GpuFrame> gpuFrames;
+  std::vector<ReadbackResult> readbacks;
+  std::vector<FrameTimeline> timelines; // frames the GPU finished
+
+  const char *rendererName = "";
+  int rendererIndex = 0;
+  MultiViewMode multiViewMode = MultiViewMode::Off; // of the counters' frame
+  int viewCount = 0;
+  RenderCounters counters;
+  uint64_t countersFrame = 0; // frame the counters belong to
+  size_t objectCount = 0;     // object count that frame asked for
+  float sceneGpuMs = 0.0f;
+  int renderWidth = 0;      // scene resolution after the render scale
+  int renderHeight = 0;
+  uint64_t shadedSamples = 0;
+  double switchMs = 0.0;
+  size_t readbackInFlight = 0;
+  size_t readbackQueued = 0;
+  size_t readbackDropped = 0;
+  size_t arenaUsed = 0;
+  size_t arenaCapacity = 0;
+  size_t gpuFramesInFlight = 0;
+  double gpuWaitMs = 0.0; // last frame's wait on the frames-in-flight fence
+
+  // Appends the events to target, overwrites its latest values and leaves
+  // this report's event lists empty
+  void MoveInto(RenderReport &target);
+};
+
+// Busy and idle time per frame for both threads, averaged over the last
+// sampling window. Overlap is the work both threads did at the same time.
+struct ThreadLoad {
+  double frameMs = 0.0;
+  double mainBusyMs = 0.0;
+  double mainIdleMs = 0.0;
+  double renderBusyMs = 0.0;
+  double renderIdleMs = 0.0;
+  double overlapMs = 0.0;
+};
+
+// Splits the frame loop in two. The main thread polls input, updates the
+// scene and builds the UI into a FrameSnapshot; a render thread that owns the
+// GL context draws it, while the main thread already produces the next one.
+// Up to SnapshotCount() snapshots are in the pipeline, so the main thread
+// runs at most that many minus one frames ahead.
+//
+// The scene store is not copied: the main thread writes it during Update and
+// the render thread reads it while uploading and drawing, so the two hand it
+// back and forth. The draw function calls ReleaseScene() as soon as it is
+// done with the store, and the main thread calls WaitForScene() before it
+// touches the store again; the rest of the frame (UI draw, present, query
+// polling) overlaps with the main thread.
+//
+// Unthreaded, Submit() draws inline and EndFrame() presents, running the
+// same code on the main thread for comparison.
+//
+// Presenting goes through a FramePacer, which enforces the snapshot's
+// frames-in-flight limit and reports each frame's timeline once the GPU is
+// done with it.
+class RenderThread {
+public:
+  using DrawFn = std::function<void(FrameSnapshot &, RenderReport &)>;
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr int MaxSnapshots = 3;
+
+  RenderThread() = default;
+  ~RenderThread() { Stop(); }
+
+  RenderThread(const RenderThread &) = delete;
+  RenderThread &operator=(const RenderThread &) = delete;
+
+  // Threaded, the window's context moves to the new render thread and must
+  // not be current on the caller afterwards
+  void Start(GLFWwindow *window, int snapshotCount, bool threaded, DrawFn draw);
+  // Draws everything submitted, then makes the context current on the
+  // caller again
+  void Stop();
+
+  // The snapshot to fill this frame; its commands are already cleared
+  FrameSnapshot &Acquire();
+  void Submit();
+  // Threaded: blocks until the next snapshot is free, or in low latency mode
+  // until everything is presented. Unthreaded: presents.
+  void EndFrame();
+
+  // Main thread, before touching the scene store
+  void WaitForScene();
+  // Draw function, once it no longer reads the scene store
+  void ReleaseScene();
+
+  // Moves what the render thread reported since the last call into out
+  void TakeReport(RenderReport &out);
+
+  // Call once per frame from the main thread; refreshes Load() every half
+  // second
+  void SampleLoad();
+  const ThreadLoad &Load() const { return load; }
+
+  bool Threaded() const { return threaded; }
+  int SnapshotCount() const { return static_cast<int>(slots.size()); }
+
+private:
+  void Run();
+  void Draw(FrameSnapshot &snapshot);
+  // Swap, fence, hand the report over
+  void Present(FrameSnapshot &snapshot);
+
+  GLFWwindow *window = nullptr;
+  DrawFn draw;
+  bool threaded = false;
+  std::vector<std::unique_ptr<FrameSnapshot>> slots;
+
+  std::thread worker;
+  std::mutex mutex;
+  std::condition_variable wake;     // a snapshot was submitted
+  std::condition_variable progress; // a snapshot was drawn or released the scene
+  uint64_t submitted = 0;
+  uint64_t drawn = 0;
+  uint64_t sceneReleased = 0;
+  bool stopping = false;
+
+  std::mutex reportMutex;
+  RenderReport report;
+  RenderReport pending; // render thread only
+  FramePacer pacer;     // render thread only
+
+  // Accumulated under mutex; sampled by SampleLoad
+  uint64_t mainIdleNs = 0;
+  uint64_t renderBusyNs = 0;
+  Clock::time_point windowStart;
+  uint64_t windowFrames = 0;
+  uint64_t windowMainIdleNs = 0;
+  uint64_t windowRenderBusyNs = 0;
+  ThreadLoad load;
+};
+
+#endif // RENDER_THREAD_H
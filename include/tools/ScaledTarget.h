@@ -0,0 +1,38 @@
+#ifndef SCALED_TARGET_H
+#define SCALED_TARGET_H
+
+#include "tools/GpuResources.h"
+
+#include <glad/glad.h>
+
+// Offscreen colour and depth/stencil target for drawing the scene below the
+// window resolution. Begin() binds it, Resolve() stretches it onto the
+// default framebuffer; the UI is drawn afterwards at full resolution.
+// Storage is reallocated only when the size changes.
+class ScaledTarget {
+public:
+  // scale * size, at least one pixel
+  static int ScaledSize(int size, float scale);
+
+  void Init();
+  void Shutdown();
+
+  // Binds the target at width x height and sets the viewport
+  void Begin(int width, int height);
+  // Blits to the default framebuffer and binds it again
+  void Resolve(int windowWidth, int windowHeight);
+
+  int Width() const { return width; }
+  int Height() const { return height; }
+
+private:
+  void Resize(int newWidth, int newHeight);
+
+  GlFramebuffer framebuffer;
+  GlTexture color;
+  GlTexture depthStencil;
+  int width = 0;
+  int height = 0;
+};
+
+#endif // SCALED_TARGET_H
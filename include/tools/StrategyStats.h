@@ -0,0 +1,60 @@
+#ifndef STRATEGY_STATS_H
+#define STRATEGY_STATS_H
+
+#include "core/FrameContext.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Per-frame averages of one strategy's RenderCounters over its last window
+struct StrategyAverages {
+  std::string strategy;
+  uint64_t frames = 0; // frames behind the averages, 0 until a window closes
+  double drawCalls = 0.0;
+  double instances = 0.0;
+  double triangles = 0.0;
+  double vertices = 0.0;
+  double stateChanges = 0.0;
+  double textureBinds = 0.0;
+  double uploadBytes = 0.0;
+  double submitMs = 0.0;
+  double frameMs = 0.0;
+  double gpuMs = 0.0; // scene pass
+};
+
+// Collects the counters every strategy reports, so they can be compared side
+// by side. Frames are added to whichever strategy drew them and averaged
+// over windows of Window frames; the table keeps each strategy's last
+// finished window after switching away from it.
+class StrategyStats {
+public:
+  static constexpr int Window = 60;
+
+  explicit StrategyStats(const char *const *names, int count);
+
+  // strategy indexes the names given to the constructor
+  void Add(int strategy, const RenderCounters &counters, float frameMs,
+           float gpuMs);
+  void Reset();
+
+  const std::vector<StrategyAverages> &Averages() const { return averages; }
+
+  // Rows are counters, columns are strategies
+  void DrawImGui() const;
+  void WriteJson(std::ostream &os) const;
+
+private:
+  struct Accumulator {
+    RenderCounters sum;
+    double frameMs = 0.0;
+    double gpuMs = 0.0;
+    int frames = 0;
+  };
+
+  std::vector<StrategyAverages> averages;
+  std::vector<Accumulator> pending;
+};
+
+#endif // STRATEGY_STATS_H
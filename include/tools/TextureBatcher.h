@@ -0,0 +1,86 @@
+#ifndef TEXTURE_BATCHER_H
+#define TEXTURE_BATCHER_H
+
+#include "tools/GpuResources.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Where a texture ended up inside the array: sample with
+// vec3(rect.xy + uv * rect.zw, layer)
+struct TextureRegion {
+  glm::vec4 uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+  uint32_t layer = 0;
+};
+
+// CPU copy of one slot's RGBA8 pixels, rows bottom-up as uploaded
+struct TextureImage {
+  int width = 0;
+  int height = 0;
+  const unsigned char *rgba = nullptr;
+};
+
+// Packs many textures into one GL_TEXTURE_2D_ARRAY so objects with different
+// textures can share a draw call. Textures the size of a layer get a layer of
+// their own; smaller ones are shelf-packed into shared atlas layers with an
+// edge-extended gutter, and reached through a UV rectangle. Each texture is
+// addressed by a slot index, and the slot table (rect + layer) is exposed as
+// a texture buffer so shaders can resolve slot indices themselves.
+class TextureBatcher {
+public:
+  ~TextureBatcher() { Release(); }
+
+  // Copies RGBA8 pixels and returns the slot index
+  uint32_t Add(int width, int height, const unsigned char *rgba);
+  // path goes through the VFS
+  uint32_t AddFile(const std::string &path, bool flip = false);
+
+  // Packs and uploads everything added so far. layerSize 0 picks the largest
+  // texture rounded up to a power of two (capped at MaxLayerSize).
+  bool Build(int layerSize = 0);
+  void Release();
+
+  GLuint ArrayTexture() const { return arrayTexture; }
+  GLuint SlotTable() const { return slotTexture; }
+
+  size_t SlotCount() const { return regions.size(); }
+  size_t LayerCount() const { return layerCount; }
+  size_t AtlasPackedCount() const { return atlasPacked; }
+  size_t GpuBytes() const { return gpuBytes; }
+  int LayerSize() const { return layerSize; }
+  const TextureRegion &Region(uint32_t slot) const { return regions[slot]; }
+  // Source pixels stay resident after Build (already shrunk to fit a layer),
+  // for CPU-side sampling
+  TextureImage Image(uint32_t slot) const {
+    const Source &s = sources[slot];
+    return {s.width, s.height, s.pixels.data()};
+  }
+
+  static constexpr int MaxLayerSize = 1024;
+  static constexpr int Gutter = 8;
+
+private:
+  struct Source {
+    int width;
+    int height;
+    std::vector<unsigned char> pixels;
+  };
+
+  std::vector<Source> sources;
+  std::vector<TextureRegion> regions;
+
+  GlTexture arrayTexture;
+  GlBuffer slotBuffer;
+  GlTexture slotTexture;
+  int layerSize = 0;
+  size_t layerCount = 0;
+  size_t atlasPacked = 0;
+  size_t gpuBytes = 0;
+};
+
+#endif // TEXTURE_BATCHER_H
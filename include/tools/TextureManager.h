@@ -1,18 +1,22 @@
 #ifndef TEXTUREMANAGER_H
 #define TEXTUREMANAGER_H
 
+#include "tools/GpuResources.h"
+
 #include <glad/glad.h>
 #include <string>
 #include <vector>
 
+// Textures come back as tracked handles owned by the caller; an empty handle
+// means the load failed.
 namespace TextureLoader {
 //simple texture loading
-GLuint loadTexture(const std::string &path, bool flip = true);
+GlTexture loadTexture(const std::string &path, bool flip = true);
 
 //Advanced 2d texture that includes wrapping and filtering 
-GLuint loadTextureAdvanced(const std::string &path, GLint wrapS, GLint wrapT,
+GlTexture loadTextureAdvanced(const std::string &path, GLint wrapS, GLint wrapT,
                            GLint minFilter, GLint magFilter, bool flip = true);
 //Load a cubemap
-GLuint loadCubemap(const std::vector<std::string> &faces, bool flip = false);
+GlTexture loadCubemap(const std::vector<std::string> &faces, bool flip = false);
 }
 #endif
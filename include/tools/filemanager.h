@@ -1,21 +1,77 @@
-
 #ifndef FILEMANAGER_H
 #define FILEMANAGER_H
 
+#include "tools/AssetArchive.h"
+#include "tools/MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <filesystem>
+#include <vector>
 
 namespace fs = std::filesystem;
 
+// The bytes of one asset. Stored archive entries and loose files point
+// straight into a mapping; compressed entries are decompressed into memory
+// owned here.
+class AssetData {
+public:
+    AssetData() = default;
+    AssetData(const AssetData&) = delete;
+    AssetData& operator=(const AssetData&) = delete;
+
+    const uint8_t* Data() const { return data; }
+    size_t Size() const { return size; }
+    bool IsOpen() const { return data != nullptr; }
+    std::string_view Text() const {
+        return {reinterpret_cast<const char*>(data), size};
+    }
+
+    // Same as MappedFile::Prefetch; does nothing for decompressed data
+    void Prefetch(size_t offset, size_t length) const;
+    void Close();
+
+private:
+    friend class VirtualFileSystem;
+
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    const MappedFile* mapping = nullptr; // what data points into
+    size_t mappingOffset = 0;
+    MappedFile loose;
+    std::vector<uint8_t> owned;
+};
+
+// Resolves asset paths relative to the asset root ("Shaders/naivecube.vs").
+// A mounted archive is searched first; anything it does not have falls back
+// to loose files under the root, then to the path as given, so development
+// works without repacking.
 class VirtualFileSystem {
 public:
-    explicit VirtualFileSystem(const std::string& basePath);
+    // The archive is mounted if it exists
+    explicit VirtualFileSystem(const std::string& basePath,
+                               const std::string& archivePath = "");
+
+    // "../assets" with "../assets.rbpak"; created on first use
+    static VirtualFileSystem& shared();
+
+    bool mountArchive(const std::string& archivePath);
+    void unmountArchive() { archive.Close(); }
+    const ArchiveReader& mountedArchive() const { return archive; }
+
+    bool open(const std::string& relativePath, AssetData& out) const;
+    bool exists(const std::string& relativePath) const;
+
+    // Loose-file location under the root, whether or not it exists
     std::string getFullPath(const std::string& relativePath) const;
     std::string readFile(const std::string& relativePath);
+    const std::string& baseDirectory() const { return baseDir; }
 
 private:
     std::string baseDir;
+    ArchiveReader archive;
 };
 
 #endif // FILEMANAGER_H
-
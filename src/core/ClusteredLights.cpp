@@ -0,0 +1,444 @@
+#include "core/ClusteredLights.h"
+#include "core/FrameContext.h"
+#include "core/SceneGenerator.h"
+#include "core/Shader.h"
+#include "tools/FrameArena.h"
+#include "tools/JobSystem.h"
+#include "tools/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CLUSTERED_LIGHTS_SSE2 1
+#endif
+
+static constexpr size_t TileCount = size_t(ClusteredLights::ClustersX) * ClusteredLights::ClustersY;
+
+static int tileIndex(float ndc, int tiles) {
+  float t = (std::clamp(ndc, -1.0f, 1.0f) * 0.5f + 0.5f) * tiles;
+  return std::min(static_cast<int>(t), tiles - 1);
+}
+
+void ClusteredLights::Generate(size_t lightCount, const glm::vec3 &boundsMin,
+                               const glm::vec3 &boundsMax, float radiusScale,
+                               uint64_t seed) {
+  PROFILE_SCOPE("Lights Generate");
+  count = std::min(lightCount, MaxLights);
+  posX.resize(count);
+  posY.resize(count);
+  posZ.resize(count);
+  radius.resize(count);
+  viewX.resize(count);
+  viewY.resize(count);
+  viewDepth.resize(count);
+  bounds.resize(count);
+
+  glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(1.0f));
+  float spacing = std::cbrt(extent.x * extent.y * extent.z /
+                            static_cast<float>(std::max<size_t>(count, 1)));
+
+  SquaresRng rng(seed);
+  texels.assign(std::max<size_t>(count, 1) * 2, glm::vec4(0.0f));
+  for (size_t i = 0; i < count; i++) {
+    uint64_t c = i * 8;
+    glm::vec3 p = boundsMin + extent * glm::vec3(rng.Uniform(c), rng.Uniform(c + 1),
+                                                 rng.Uniform(c + 2));
+    float r = spacing * radiusScale * (0.5f + rng.Uniform(c + 3));
+    posX[i] = p.x;
+    posY[i] = p.y;
+    posZ[i] = p.z;
+    radius[i] = r;
+
+    float hue = rng.Uniform(c + 4) * 6.0f;
+    glm::vec3 color(std::clamp(std::fabs(hue - 3.0f) - 1.0f, 0.0f, 1.0f),
+                    std::clamp(2.0f - std::fabs(hue - 2.0f), 0.0f, 1.0f),
+                    std::clamp(2.0f - std::fabs(hue - 4.0f), 0.0f, 1.0f));
+    texels[i * 2] = glm::vec4(p, r);
+    texels[i * 2 + 1] = glm::vec4(color, 0.0f);
+  }
+  texelsDirty = true;
+
+  // Nothing is lit until the first Assign
+  std::fill(grid.begin(), grid.end(), 0u);
+  indices.clear();
+}
+
+void ClusteredLights::CreateBuffers() {
+  // Light texels: (position, radius), (colour, unused)
+  if (!lightBuffer)
+    lightBuffer.Create("Lights");
+  glBindBuffer(GL_TEXTURE_BUFFER, lightBuffer);
+  glBufferData(GL_TEXTURE_BUFFER, texels.size() * sizeof(glm::vec4), texels.data(),
+               GL_STATIC_DRAW);
+  lightBuffer.SetBytes(texels.size() * sizeof(glm::vec4));
+  if (!lightTexture) {
+    lightTexture.Create("Lights");
+    glBindTexture(GL_TEXTURE_BUFFER, lightTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, lightBuffer);
+  }
+
+  // Cluster grid: one (offset, count) RG32UI texel per cluster
+  if (!gridBuffer) {
+    gridBuffer.Create("Lights");
+    glBindBuffer(GL_TEXTURE_BUFFER, gridBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, grid.size() * sizeof(uint32_t), nullptr,
+                 GL_STREAM_DRAW);
+    gridBuffer.SetBytes(grid.size() * sizeof(uint32_t));
+    gridTexture.Create("Lights");
+    glBindTexture(GL_TEXTURE_BUFFER, gridTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, gridBuffer);
+  }
+
+  if (!indexBuffer) {
+    indexCapacity = 65536;
+    indexBuffer.Create("Lights");
+    glBindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, indexCapacity * sizeof(uint16_t), nullptr,
+                 GL_STREAM_DRAW);
+    indexBuffer.SetBytes(indexCapacity * sizeof(uint16_t));
+    indexTexture.Create("Lights");
+    glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R16UI, indexBuffer);
+  }
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  texelsDirty = false;
+}
+
+void ClusteredLights::Release() {
+  lightTexture.Reset();
+  lightBuffer.Reset();
+  gridTexture.Reset();
+  gridBuffer.Reset();
+  indexTexture.Reset();
+  indexBuffer.Reset();
+  indexCapacity = 0;
+  count = 0;
+  texels.clear();
+  texelsDirty = false;
+  posX.clear();
+  posY.clear();
+  posZ.clear();
+  radius.clear();
+  viewX.clear();
+  viewY.clear();
+  viewDepth.clear();
+  bounds.clear();
+}
+
+// Turns a light's NDC rectangle and view depth range into cluster ranges
+static void clusterRange(float minX, float maxX, float minY, float maxY,
+                         float dNear, float dFar, float zNear, float zFar,
+                         float sliceScale, float sliceBias,
+                         ClusteredLights::LightBounds &out) {
+  if (dFar < zNear || dNear > zFar || maxX < -1.0f || minX > 1.0f ||
+      maxY < -1.0f || minY > 1.0f) {
+    out = {0, 0, 0, 0, 1, 0};
+    return;
+  }
+
+  auto slice = [&](float depth) {
+    int s = static_cast<int>(std::floor(std::log(depth) * sliceScale + sliceBias));
+    return std::clamp(s, 0, ClusteredLights::ClustersZ - 1);
+  };
+  out.xBegin = static_cast<uint8_t>(tileIndex(minX, ClusteredLights::ClustersX));
+  out.xEnd = static_cast<uint8_t>(tileIndex(maxX, ClusteredLights::ClustersX));
+  out.yBegin = static_cast<uint8_t>(tileIndex(minY, ClusteredLights::ClustersY));
+  out.yEnd = static_cast<uint8_t>(tileIndex(maxY, ClusteredLights::ClustersY));
+  out.zBegin = static_cast<uint8_t>(slice(std::max(dNear, zNear)));
+  out.zEnd = static_cast<uint8_t>(slice(std::min(dFar, zFar)));
+}
+
+// Conservative NDC bounds of a view-space sphere: the box around it, with
+// each side divided by whichever of its nearest or farthest depth pushes it
+// further out. Spheres reaching the near plane cover the whole screen.
+void ClusteredLights::ComputeBounds(const glm::mat4 &view, float p00, float p11,
+                                    float zNear, float zFar) {
+  PROFILE_SCOPE("Lights Bounds");
+  size_t i = 0;
+
+#ifdef CLUSTERED_LIGHTS_SSE2
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 nearPlane = _mm_set1_ps(zNear);
+  auto select = [](__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+  };
+  auto row = [&](int r, __m128 x, __m128 y, __m128 z) {
+    return _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(view[0][r]), x),
+                   _mm_mul_ps(_mm_set1_ps(view[1][r]), y)),
+        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(view[2][r]), z), _mm_set1_ps(view[3][r])));
+  };
+  // lo / hi side of one axis, in NDC
+  auto extent = [&](__m128 centre, __m128 r, __m128 dNear, __m128 dFar,
+                    __m128 scale, __m128 &lo, __m128 &hi) {
+    __m128 a = _mm_sub_ps(centre, r);
+    __m128 b = _mm_add_ps(centre, r);
+    lo = _mm_mul_ps(_mm_div_ps(a, select(_mm_cmplt_ps(a, zero), dNear, dFar)), scale);
+    hi = _mm_mul_ps(_mm_div_ps(b, select(_mm_cmpgt_ps(b, zero), dNear, dFar)), scale);
+  };
+
+  alignas(16) float out[6][4];
+  for (; i + 4 <= count; i += 4) {
+    __m128 x = _mm_loadu_ps(&posX[i]);
+    __m128 y = _mm_loadu_ps(&posY[i]);
+    __m128 z = _mm_loadu_ps(&posZ[i]);
+    __m128 r = _mm_loadu_ps(&radius[i]);
+    __m128 vx = row(0, x, y, z);
+    __m128 vy = row(1, x, y, z);
+    __m128 depth = _mm_sub_ps(zero, row(2, x, y, z));
+    _mm_storeu_ps(&viewX[i], vx);
+    _mm_storeu_ps(&viewY[i], vy);
+    _mm_storeu_ps(&viewDepth[i], depth);
+    __m128 dNear = _mm_sub_ps(depth, r);
+    __m128 dFar = _mm_add_ps(depth, r);
+
+    __m128 minX, maxX, minY, maxY;
+    extent(vx, r, dNear, dFar, _mm_set1_ps(p00), minX, maxX);
+    extent(vy, r, dNear, dFar, _mm_set1_ps(p11), minY, maxY);
+    __m128 full = _mm_cmple_ps(dNear, nearPlane);
+    _mm_store_ps(out[0], select(full, _mm_sub_ps(zero, one), minX));
+    _mm_store_ps(out[1], select(full, one, maxX));
+    _mm_store_ps(out[2], select(full, _mm_sub_ps(zero, one), minY));
+    _mm_store_ps(out[3], select(full, one, maxY));
+    _mm_store_ps(out[4], dNear);
+    _mm_store_ps(out[5], dFar);
+
+    for (int lane = 0; lane < 4; lane++)
+      clusterRange(out[0][lane], out[1][lane], out[2][lane], out[3][lane],
+                   out[4][lane], out[5][lane], zNear, zFar, sliceScale, sliceBias,
+                   bounds[i + lane]);
+  }
+#endif
+
+  for (; i < count; i++) {
+    glm::vec4 v = view * glm::vec4(posX[i], posY[i], posZ[i], 1.0f);
+    float r = radius[i];
+    float depth = -v.z;
+    viewX[i] = v.x;
+    viewY[i] = v.y;
+    viewDepth[i] = depth;
+    float dNear = depth - r, dFar = depth + r;
+    float minX = -1.0f, maxX = 1.0f, minY = -1.0f, maxY = 1.0f;
+    if (dNear > zNear) {
+      auto lo = [&](float a) { return a / (a < 0.0f ? dNear : dFar); };
+      auto hi = [&](float b) { return b / (b > 0.0f ? dNear : dFar); };
+      minX = lo(v.x - r) * p00;
+      maxX = hi(v.x + r) * p00;
+      minY = lo(v.y - r) * p11;
+      maxY = hi(v.y + r) * p11;
+    }
+    clusterRange(minX, maxX, minY, maxY, dNear, dFar, zNear, zFar, sliceScale,
+                 sliceBias, bounds[i]);
+  }
+}
+
+// A light as seen by one depth slice
+struct SliceLight {
+  uint16_t light;
+  uint8_t xBegin, xEnd, yBegin, yEnd;
+};
+
+// Narrows a light's tile rectangle to the part of its sphere inside the depth
+// slab [s0, s1]: the cross-section there is at most sqrt(r^2 - dz^2) wide,
+// where dz is the distance from the centre to the slab. Most lights span a
+// few slices, so this trims the lists of every slice but the centre one.
+static void slabRange(float vx, float vy, float depth, float r, float s0,
+                      float s1, float zNear, float p00, float p11,
+                      const ClusteredLights::LightBounds &whole, SliceLight &out) {
+  out.xBegin = whole.xBegin;
+  out.xEnd = whole.xEnd;
+  out.yBegin = whole.yBegin;
+  out.yEnd = whole.yEnd;
+
+  float lo = std::max(depth - r, s0), hi = std::min(depth + r, s1);
+  if (lo > hi || lo <= zNear)
+    return;
+  float dz = depth < lo ? lo - depth : (depth > hi ? depth - hi : 0.0f);
+  float rr = std::sqrt(std::max(r * r - dz * dz, 0.0f));
+
+  auto low = [&](float a) { return a / (a < 0.0f ? lo : hi); };
+  auto high = [&](float b) { return b / (b > 0.0f ? lo : hi); };
+  out.xBegin = static_cast<uint8_t>(std::max<int>(
+      whole.xBegin, tileIndex(low(vx - rr) * p00, ClusteredLights::ClustersX)));
+  out.xEnd = static_cast<uint8_t>(std::min<int>(
+      whole.xEnd, tileIndex(high(vx + rr) * p00, ClusteredLights::ClustersX)));
+  out.yBegin = static_cast<uint8_t>(std::max<int>(
+      whole.yBegin, tileIndex(low(vy - rr) * p11, ClusteredLights::ClustersY)));
+  out.yEnd = static_cast<uint8_t>(std::min<int>(
+      whole.yEnd, tileIndex(high(vy + rr) * p11, ClusteredLights::ClustersY)));
+}
+
+void ClusteredLights::Assign(const glm::mat4 &view, float fovY, float aspect,
+                             float zNear, float zFar) {
+  PROFILE_SCOPE("Lights Assign");
+  auto start = std::chrono::steady_clock::now();
+
+  // Exponential slices keep clusters roughly cube shaped at every depth
+  float logRange = std::log(zFar / zNear);
+  sliceScale = ClustersZ / logRange;
+  sliceBias = -ClustersZ * std::log(zNear) / logRange;
+  viewPos = glm::vec3(glm::inverse(view)[3]);
+  for (int z = 0; z <= ClustersZ; z++)
+    sliceNear[z] = std::exp((z - sliceBias) / sliceScale);
+  // The first and last slice also take depths the log rounds into them
+  sliceNear[0] = 0.0f;
+  sliceNear[ClustersZ] = zFar * 2.0f;
+
+  float p11 = 1.0f / std::tan(fovY * 0.5f);
+  float p00 = p11 / aspect;
+  ComputeBounds(view, p00, p11, zNear, zFar);
+
+  // Each slice bins into its own list, so no two jobs write the same memory
+  JobSystem::Shared().ParallelFor(ClustersZ, 1, [&](size_t begin, size_t end) {
+    PROFILE_SCOPE("Lights Bin");
+    SliceLight *sliceLights = FrameArenas::Shared().Local().AllocateArray<SliceLight>(count);
+    uint32_t cursor[TileCount];
+    for (size_t z = begin; z < end; z++) {
+      // Slab edges widened a little, as the shader picks slices with a log
+      float s0 = sliceNear[z] * 0.999f, s1 = sliceNear[z + 1] * 1.001f;
+      size_t sliceCount = 0;
+      std::fill(cursor, cursor + TileCount, 0u);
+      for (size_t l = 0; l < count; l++) {
+        const LightBounds &b = bounds[l];
+        if (z < b.zBegin || z > b.zEnd)
+          continue;
+        SliceLight &light = sliceLights[sliceCount++];
+        light.light = static_cast<uint16_t>(l);
+        slabRange(viewX[l], viewY[l], viewDepth[l], radius[l], s0, s1, zNear,
+                  p00, p11, b, light);
+        for (int y = light.yBegin; y <= light.yEnd; y++)
+          for (int x = light.xBegin; x <= light.xEnd; x++)
+            cursor[y * ClustersX + x]++;
+      }
+
+      uint32_t *cells = &grid[z * TileCount * 2];
+      uint32_t offset = 0;
+      for (size_t c = 0; c < TileCount; c++) {
+        cells[c * 2] = offset;
+        cells[c * 2 + 1] = cursor[c];
+        cursor[c] = offset;
+        offset += cells[c * 2 + 1];
+      }
+
+      std::vector<uint16_t> &list = sliceIndices[z];
+      list.resize(offset);
+      for (size_t i = 0; i < sliceCount; i++) {
+        const SliceLight &light = sliceLights[i];
+        for (int y = light.yBegin; y <= light.yEnd; y++)
+          for (int x = light.xBegin; x <= light.xEnd; x++)
+            list[cursor[y * ClustersX + x]++] = light.light;
+      }
+    }
+  });
+
+  size_t total = 0;
+  for (int z = 0; z < ClustersZ; z++) {
+    sliceBase[z] = total;
+    total += sliceIndices[z].size();
+  }
+  lastIndexCount = total;
+  lastOverflow = total > MaxIndices ? total - MaxIndices : 0;
+  indices.resize(std::min(total, MaxIndices));
+
+  // Concatenate, making offsets absolute and clipping at the cap
+  JobSystem::Shared().ParallelFor(ClustersZ, 1, [&](size_t begin, size_t end) {
+    for (size_t z = begin; z < end; z++) {
+      size_t base = sliceBase[z];
+      const std::vector<uint16_t> &list = sliceIndices[z];
+      size_t kept = base < indices.size() ? std::min(list.size(), indices.size() - base) : 0;
+      std::copy(list.begin(), list.begin() + kept, indices.begin() + base);
+
+      uint32_t *cells = &grid[z * TileCount * 2];
+      for (size_t c = 0; c < TileCount; c++) {
+        size_t offset = base + cells[c * 2];
+        size_t available = offset < indices.size() ? indices.size() - offset : 0;
+        cells[c * 2] = static_cast<uint32_t>(std::min(offset, indices.size()));
+        cells[c * 2 + 1] = static_cast<uint32_t>(std::min<size_t>(cells[c * 2 + 1], available));
+      }
+    }
+  });
+
+  lastVisible = 0;
+  for (const LightBounds &b : bounds)
+    lastVisible += b.zBegin <= b.zEnd;
+  lastMaxPerCluster = 0;
+  for (size_t c = 0; c < ClusterCount; c++)
+    lastMaxPerCluster = std::max(lastMaxPerCluster, grid[c * 2 + 1]);
+
+  lastAssignMs = std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+}
+
+void ClusteredLights::Upload() {
+  PROFILE_SCOPE("Lights Upload");
+  auto start = std::chrono::steady_clock::now();
+  lastUploadBytes = 0;
+  if (texelsDirty) {
+    CreateBuffers();
+    lastUploadBytes += texels.size() * sizeof(glm::vec4);
+  }
+  if (!gridBuffer)
+    return;
+
+  glBindBuffer(GL_TEXTURE_BUFFER, gridBuffer);
+  glBufferSubData(GL_TEXTURE_BUFFER, 0, grid.size() * sizeof(uint32_t), grid.data());
+
+  // Orphan first so the driver never waits on last frame's draws
+  glBindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+  if (indices.size() > indexCapacity) {
+    while (indexCapacity < indices.size())
+      indexCapacity *= 2;
+    indexCapacity = std::min(indexCapacity, MaxIndices);
+    indexBuffer.SetBytes(indexCapacity * sizeof(uint16_t));
+  }
+  glBufferData(GL_TEXTURE_BUFFER, indexCapacity * sizeof(uint16_t), nullptr,
+               GL_STREAM_DRAW);
+  if (!indices.empty())
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, indices.size() * sizeof(uint16_t),
+                    indices.data());
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  lastUploadBytes += grid.size() * sizeof(uint32_t) + indices.size() * sizeof(uint16_t);
+
+  lastUploadMs = std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+}
+
+void ClusteredLights::Bind(const Shader &shader, int viewportWidth,
+                           int viewportHeight, RenderCounters *stats) const {
+  glActiveTexture(GL_TEXTURE0 + LightDataUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, lightTexture);
+  shader.setUniform("lightData", LightDataUnit);
+  glActiveTexture(GL_TEXTURE0 + ClusterGridUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, gridTexture);
+  shader.setUniform("clusterGrid", ClusterGridUnit);
+  glActiveTexture(GL_TEXTURE0 + LightIndexUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+  shader.setUniform("lightIndices", LightIndexUnit);
+  glActiveTexture(GL_TEXTURE0);
+
+  shader.setUniform("tileScale",
+                    glm::vec2(static_cast<float>(ClustersX) / std::max(viewportWidth, 1),
+                              static_cast<float>(ClustersY) / std::max(viewportHeight, 1)));
+  shader.setUniform("sliceScale", sliceScale);
+  shader.setUniform("sliceBias", sliceBias);
+  shader.setUniform("viewPos", viewPos);
+
+  if (stats) {
+    stats->textureBinds += 3;
+    stats->stateChanges += 7; // uniforms
+  }
+}
+
+size_t ClusteredLights::GpuBytes() const {
+  if (!lightBuffer)
+    return 0;
+  return std::max<size_t>(count, 1) * 2 * sizeof(glm::vec4) +
+         grid.size() * sizeof(uint32_t) + indexCapacity * sizeof(uint16_t);
+}
@@ -1,24 +1,4 @@
 #include "core/Cube.h"
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
-#include <glm/glm.hpp>
-
-#include "core/Camera.h"
-#include "core/Material.h"
-#include "core/Shader.h"
-#include "core/Material.h"
-#include "tools/EngineConfig.h"
-#include "tools/TextureManager.h"
-
-#include <glm/detail/qualifier.hpp>
-#include <glm/ext/matrix_transform.hpp>
-#include <glm/fwd.hpp>
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-#include <stb_image.h>
-#define _USE_MATH_DEFINES
-#include <cmath>
 
 float cubeVertices[] = {
     // positions          // normals        // texcoords
@@ -57,82 +37,3 @@ float cubeVertices[] = {
     1.0f,  0.0f,  1.0f,  0.0f,  0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
     1.0f,  0.0f,  -0.5f, 0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
     -0.5f, 0.5f,  -0.5f, 0.0f,  1.0f,  0.0f,  0.0f,  1.0f};
-
-void Cube::loadCube() {
-  glGenVertexArrays(1, &VAO);
-  glGenBuffers(1, &VBO);
-
-  glBindVertexArray(VAO);
-
-  glBindBuffer(GL_ARRAY_BUFFER, VBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices,
-               GL_STATIC_DRAW);
-
-  // position attribute
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
-  glEnableVertexAttribArray(0);
-
-  // normal attribute
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float),
-                        (void *)(3 * sizeof(float)));
-  glEnableVertexAttribArray(1);
-
-  // texcoords attribute
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float),
-                        (void *)(6 * sizeof(float)));
-  glEnableVertexAttribArray(2);
-
-  int width, height, nrChannels;
-  unsigned char *data =
-      stbi_load((EngineConfig::TextureDirectory + "test1.jpg").c_str(), &width,
-                &height, &nrChannels, 0);
-  if (data) {
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                    GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    int format = (nrChannels == 4) ? GL_RGBA : GL_RGB;
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-                 GL_UNSIGNED_BYTE, data);
-  }
-  stbi_image_free(data);
-  shader.LoadShaders((EngineConfig::ShaderDirectory + "basiccube.vs").c_str(),
-                     (EngineConfig::ShaderDirectory + "basiccube.fs").c_str());
-}
-
-void Cube::render(Camera &camera, GLFWwindow *window) {
-  shader.use();
-
-  glm::mat4 projection = glm::perspective(
-      glm::radians(camera.Zoom), (float)800 / (float)600, 0.1f, 100.0f);
-  glm::mat4 view = camera.GetViewMatrix();
-
-  shader.setUniform("projection", projection);
-  shader.setUniform("view", view);
-
-  glm::mat4 model = glm::mat4(1.0f);
-  model = glm::translate(model, Position);
-  shader.setUniform("model", model);
-
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, texture);
-  shader.setUniform("diffuseTex", 0);
-
-  glBindVertexArray(VAO);
-  glDrawArrays(GL_TRIANGLES, 0, 36);
-}
-
-Cube::~Cube() {
-  glDeleteVertexArrays(1, &VAO);
-  glDeleteBuffers(1, &VBO);
-  glDeleteTextures(1, &texture);
-}
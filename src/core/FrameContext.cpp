@@ -0,0 +1,41 @@
+#include "core/FrameContext.h"
+#include "core/Camera.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+
+FrameContext FrameContext::FromCamera(const Camera &camera, int viewportWidth,
+                                      int viewportHeight) {
+  return FromView(camera.GetViewMatrix(), camera.Position,
+                  glm::radians(camera.Zoom), viewportWidth, viewportHeight);
+}
+
+FrameContext FrameContext::FromView(const glm::mat4 &view,
+                                    const glm::vec3 &position, float fovY,
+                                    int viewportWidth, int viewportHeight) {
+  FrameContext frame;
+  frame.viewportWidth = std::max(viewportWidth, 1);
+  frame.viewportHeight = std::max(viewportHeight, 1);
+  frame.fovY = fovY;
+  frame.aspect = static_cast<float>(frame.viewportWidth) / frame.viewportHeight;
+  frame.view = view;
+  frame.projection = glm::perspective(frame.fovY, frame.aspect, frame.zNear, frame.zFar);
+  frame.viewProjection = frame.projection * frame.view;
+  frame.cameraPosition = position;
+
+  // Gribb-Hartmann: each plane is the fourth row plus or minus another row
+  const glm::mat4 &m = frame.viewProjection;
+  glm::vec4 rows[4];
+  for (int r = 0; r < 4; r++)
+    rows[r] = glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+  frame.frustumPlanes[0] = rows[3] + rows[0];
+  frame.frustumPlanes[1] = rows[3] - rows[0];
+  frame.frustumPlanes[2] = rows[3] + rows[1];
+  frame.frustumPlanes[3] = rows[3] - rows[1];
+  frame.frustumPlanes[4] = rows[3] + rows[2];
+  frame.frustumPlanes[5] = rows[3] - rows[2];
+  for (glm::vec4 &plane : frame.frustumPlanes)
+    plane = plane * (1.0f / glm::length(glm::vec3(plane)));
+  return frame;
+}
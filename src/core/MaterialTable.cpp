@@ -0,0 +1,45 @@
+#include "core/MaterialTable.h"
+#include "tools/Profiler.h"
+
+#include <algorithm>
+#include <iostream>
+
+bool MaterialTable::Build(const std::vector<Material> &materials) {
+  PROFILE_SCOPE("MaterialTable Build");
+  if (materials.empty())
+    return false;
+
+  size_t count = materials.size();
+  if (count > MaxMaterials) {
+    std::cerr << "Material table holds " << MaxMaterials << " materials, "
+              << count - MaxMaterials << " dropped\n";
+    count = MaxMaterials;
+  }
+
+  records.resize(count);
+  for (size_t i = 0; i < count; i++)
+    records[i] = materials[i].Bake();
+
+  // The block is declared with MaxMaterials entries, so always allocate the
+  // full size and leave the tail zeroed
+  std::vector<MaterialRecord> padded(MaxMaterials, MaterialRecord{});
+  std::copy(records.begin(), records.end(), padded.begin());
+
+  if (!buffer)
+    buffer.Create("Materials");
+  glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+  glBufferData(GL_UNIFORM_BUFFER, padded.size() * sizeof(MaterialRecord),
+               padded.data(), GL_STATIC_DRAW);
+  buffer.SetBytes(padded.size() * sizeof(MaterialRecord));
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  return true;
+}
+
+void MaterialTable::Release() {
+  buffer.Reset();
+  records.clear();
+}
+
+void MaterialTable::Bind() const {
+  glBindBufferBase(GL_UNIFORM_BUFFER, BindingPoint, buffer);
+}
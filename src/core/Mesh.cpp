@@ -0,0 +1,159 @@
+#include "core/Mesh.h"
+#include "tools/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+Mesh Mesh::Sphere(int rings, int segments, float bumpiness) {
+  rings = std::max(rings, 2);
+  segments = std::max(segments, 3);
+  Mesh mesh;
+  mesh.vertices.reserve(size_t(rings + 1) * (segments + 1));
+  constexpr float Pi = 3.14159265358979f;
+  for (int r = 0; r <= rings; r++) {
+    float v = static_cast<float>(r) / rings;
+    float theta = v * Pi;
+    for (int s = 0; s <= segments; s++) {
+      float u = static_cast<float>(s) / segments;
+      float phi = u * 2.0f * Pi;
+      glm::vec3 dir(std::sin(theta) * std::cos(phi), std::cos(theta),
+                    std::sin(theta) * std::sin(phi));
+      float bump = 1.0f + bumpiness * std::sin(5.0f * phi) * std::sin(4.0f * theta);
+      mesh.vertices.push_back({dir * 0.5f * bump, glm::vec3(0.0f), glm::vec2(u, v)});
+    }
+  }
+
+  // Quads go out in 7 x 7 patches, exactly 64 vertices, so the greedy
+  // clustering cuts square meshlets instead of long strips around a ring
+  constexpr int Patch = 7;
+  uint32_t stride = static_cast<uint32_t>(segments + 1);
+  for (int r0 = 0; r0 < rings; r0 += Patch) {
+    for (int s0 = 0; s0 < segments; s0 += Patch) {
+      for (int r = r0; r < std::min(r0 + Patch, rings); r++) {
+        for (int s = s0; s < std::min(s0 + Patch, segments); s++) {
+          uint32_t a = static_cast<uint32_t>(r) * stride + s, b = a + stride;
+          // The first and last rings collapse to the poles
+          if (r != 0)
+            mesh.indices.insert(mesh.indices.end(), {a, a + 1, b});
+          if (r + 1 != rings)
+            mesh.indices.insert(mesh.indices.end(), {a + 1, b + 1, b});
+        }
+      }
+    }
+  }
+
+  // Smooth normals from the displaced surface
+  for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+    MeshVertex &a = mesh.vertices[mesh.indices[i]];
+    MeshVertex &b = mesh.vertices[mesh.indices[i + 1]];
+    MeshVertex &c = mesh.vertices[mesh.indices[i + 2]];
+    glm::vec3 n = glm::cross(b.position - a.position, c.position - a.position);
+    a.normal += n;
+    b.normal += n;
+    c.normal += n;
+  }
+  for (MeshVertex &vertex : mesh.vertices) {
+    float length = glm::length(vertex.normal);
+    vertex.normal = length > 0.0f ? vertex.normal / length : glm::normalize(vertex.position);
+  }
+
+  mesh.BuildMeshlets();
+  return mesh;
+}
+
+void Mesh::BuildMeshlets() {
+  PROFILE_SCOPE("Meshlet Build");
+  meshlets.clear();
+  meshletBounds = MeshletBounds{};
+
+  glm::vec3 lo(INFINITY), hi(-INFINITY);
+  for (const MeshVertex &vertex : vertices) {
+    lo = glm::min(lo, vertex.position);
+    hi = glm::max(hi, vertex.position);
+  }
+  center = vertices.empty() ? glm::vec3(0.0f) : (lo + hi) * 0.5f;
+  radius = 0.0f;
+  for (const MeshVertex &vertex : vertices)
+    radius = std::max(radius, glm::length(vertex.position - center));
+
+  // stamp[v] == meshlets.size() + 1 marks vertices already in the open meshlet
+  std::vector<uint32_t> stamp(vertices.size(), 0);
+  Meshlet open;
+  auto close = [&](uint32_t end) {
+    if (open.triangleCount == 0)
+      return;
+    meshlets.push_back(open);
+    open = Meshlet{};
+    open.firstIndex = end;
+  };
+  for (uint32_t i = 0; i + 2 < indices.size(); i += 3) {
+    uint32_t mark = static_cast<uint32_t>(meshlets.size()) + 1;
+    uint32_t added = 0;
+    for (uint32_t k = 0; k < 3; k++)
+      added += stamp[indices[i + k]] != mark;
+    if (open.vertexCount + added > MaxMeshletVertices ||
+        open.triangleCount == MaxMeshletTriangles) {
+      close(i);
+      mark = static_cast<uint32_t>(meshlets.size()) + 1;
+      added = 3;
+    }
+    for (uint32_t k = 0; k < 3; k++) {
+      uint32_t &s = stamp[indices[i + k]];
+      open.vertexCount += s != mark;
+      s = mark;
+    }
+    open.triangleCount++;
+  }
+  close(static_cast<uint32_t>(indices.size()));
+
+  for (const Meshlet &meshlet : meshlets) {
+    uint32_t first = meshlet.firstIndex, end = first + meshlet.triangleCount * 3;
+    glm::vec3 mlo(INFINITY), mhi(-INFINITY);
+    for (uint32_t i = first; i < end; i++) {
+      mlo = glm::min(mlo, vertices[indices[i]].position);
+      mhi = glm::max(mhi, vertices[indices[i]].position);
+    }
+    glm::vec3 c = (mlo + mhi) * 0.5f;
+    float r = 0.0f;
+    glm::vec3 axis(0.0f);
+    for (uint32_t i = first; i < end; i += 3) {
+      glm::vec3 a = vertices[indices[i]].position;
+      glm::vec3 b = vertices[indices[i + 1]].position;
+      glm::vec3 d = vertices[indices[i + 2]].position;
+      r = std::max({r, glm::length(a - c), glm::length(b - c), glm::length(d - c)});
+      glm::vec3 n = glm::cross(b - a, d - a);
+      float length = glm::length(n);
+      if (length > 0.0f)
+        axis += n / length;
+    }
+
+    // Widest angle between the mean and any face normal
+    float cutoff = 1.0f;
+    float axisLength = glm::length(axis);
+    if (axisLength > 0.0f) {
+      axis = axis / axisLength;
+      float minDot = 1.0f;
+      for (uint32_t i = first; i < end; i += 3) {
+        glm::vec3 a = vertices[indices[i]].position;
+        glm::vec3 n = glm::cross(vertices[indices[i + 1]].position - a,
+                                 vertices[indices[i + 2]].position - a);
+        float length = glm::length(n);
+        if (length > 0.0f)
+          minDot = std::min(minDot, glm::dot(n / length, axis));
+      }
+      // Past 90 degrees some triangle always faces the camera
+      if (minDot > 0.0f)
+        cutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+
+    MeshletBounds &b = meshletBounds;
+    b.centerX.push_back(c.x);
+    b.centerY.push_back(c.y);
+    b.centerZ.push_back(c.z);
+    b.radius.push_back(r);
+    b.axisX.push_back(axis.x);
+    b.axisY.push_back(axis.y);
+    b.axisZ.push_back(axis.z);
+    b.cutoff.push_back(cutoff);
+  }
+}
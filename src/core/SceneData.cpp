@@ -0,0 +1,21 @@
+#include "core/SceneData.h"
+
+void SceneData::Resize(size_t count) {
+  readyCount.store(0, std::memory_order_release);
+  positions.resize(count);
+  rotations.resize(count);
+  scales.resize(count);
+  meshIds.resize(count);
+  materialIds.resize(count);
+  bounds.resize(count);
+}
+
+void SceneData::Clear() {
+  readyCount.store(0, std::memory_order_release);
+  positions.clear();
+  rotations.clear();
+  scales.clear();
+  meshIds.clear();
+  materialIds.clear();
+  bounds.clear();
+}
@@ -0,0 +1,337 @@
+#include "core/SceneFile.h"
+#include "tools/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+static_assert(std::is_trivially_copyable_v<SceneFile::Header>);
+static_assert(std::is_trivially_copyable_v<SceneFile::ChunkEntry>);
+static_assert(sizeof(glm::vec3) == 12 && sizeof(glm::vec4) == 16,
+              "scene file sections assume tightly packed glm vectors");
+
+namespace {
+
+constexpr uint64_t ChunkAlignment = 4096;
+constexpr uint64_t SectionAlignment = 64;
+
+constexpr uint32_t SectionStrides[SceneFile::SectionCount] = {
+    sizeof(glm::vec3),    // Positions
+    sizeof(glm::vec4),    // Rotations
+    sizeof(glm::vec3),    // Scales
+    sizeof(uint32_t),     // MeshIds
+    sizeof(uint32_t),     // MaterialIds
+    sizeof(ObjectBounds), // Bounds
+};
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// count items of stride bytes at offset lie inside size bytes. Written as
+// subtractions so offsets and counts from the file cannot wrap past the check
+bool fitsIn(uint64_t offset, uint64_t count, uint64_t stride, uint64_t size) {
+  return offset <= size && count <= (size - offset) / stride;
+}
+
+const void *sectionData(const SceneData &scene, uint32_t section) {
+  switch (section) {
+  case SceneFile::Positions:
+    return scene.positions.data();
+  case SceneFile::Rotations:
+    return scene.rotations.data();
+  case SceneFile::Scales:
+    return scene.scales.data();
+  case SceneFile::MeshIds:
+    return scene.meshIds.data();
+  case SceneFile::MaterialIds:
+    return scene.materialIds.data();
+  case SceneFile::Bounds:
+    return scene.bounds.data();
+  default:
+    return nullptr;
+  }
+}
+
+void *sectionData(SceneData &scene, uint32_t section) {
+  return const_cast<void *>(
+      sectionData(static_cast<const SceneData &>(scene), section));
+}
+
+// Checks the header and chunk table against the mapped file size so a
+// truncated or foreign file is rejected before anything is copied.
+bool validate(const AssetData &file, const SceneFile::Header *&header,
+              const SceneFile::ChunkEntry *&chunks) {
+  if (file.Size() < sizeof(SceneFile::Header)) {
+    std::cerr << "Scene file too small\n";
+    return false;
+  }
+
+  header = reinterpret_cast<const SceneFile::Header *>(file.Data());
+  if (header->magic != SceneFile::Magic ||
+      header->version != SceneFile::Version ||
+      header->sectionCount != SceneFile::SectionCount) {
+    std::cerr << "Not a supported scene file (version " << header->version
+              << ")\n";
+    return false;
+  }
+  for (uint32_t s = 0; s < SceneFile::SectionCount; s++) {
+    if (header->sectionStrides[s] != SectionStrides[s]) {
+      std::cerr << "Scene file section " << s << " has unexpected stride\n";
+      return false;
+    }
+  }
+
+  if (!fitsIn(header->chunkTableOffset, header->chunkCount,
+              sizeof(SceneFile::ChunkEntry), file.Size())) {
+    std::cerr << "Scene file chunk table is truncated\n";
+    return false;
+  }
+  // Every object needs its bytes in every section, which bounds the count
+  // before anything is resized to it
+  uint64_t objectBytes = 0;
+  for (uint32_t stride : SectionStrides)
+    objectBytes += stride;
+  if (header->objectCount > file.Size() / objectBytes) {
+    std::cerr << "Scene file object count exceeds its size\n";
+    return false;
+  }
+  chunks = reinterpret_cast<const SceneFile::ChunkEntry *>(
+      file.Data() + header->chunkTableOffset);
+
+  uint64_t expectedFirst = 0;
+  for (uint32_t c = 0; c < header->chunkCount; c++) {
+    const SceneFile::ChunkEntry &chunk = chunks[c];
+    if (chunk.firstObject != expectedFirst) {
+      std::cerr << "Scene file chunk " << c << " is out of order\n";
+      return false;
+    }
+    // Sections follow each other, which chunkBytes relies on
+    uint64_t sectionStart = 0;
+    for (uint32_t s = 0; s < SceneFile::SectionCount; s++) {
+      if (chunk.sectionOffsets[s] < sectionStart ||
+          !fitsIn(chunk.sectionOffsets[s], chunk.objectCount, SectionStrides[s],
+                  file.Size())) {
+        std::cerr << "Scene file chunk " << c << " is truncated\n";
+        return false;
+      }
+      sectionStart = chunk.sectionOffsets[s] +
+                     uint64_t(chunk.objectCount) * SectionStrides[s];
+    }
+    expectedFirst += chunk.objectCount;
+    if (expectedFirst > header->objectCount)
+      break; // reported below
+  }
+
+  if (expectedFirst != header->objectCount) {
+    std::cerr << "Scene file object count does not match its chunks\n";
+    return false;
+  }
+  return true;
+}
+
+void copyChunk(const AssetData &file, const SceneFile::ChunkEntry &chunk,
+               SceneData &scene) {
+  for (uint32_t s = 0; s < SceneFile::SectionCount; s++) {
+    uint8_t *dst = static_cast<uint8_t *>(sectionData(scene, s)) +
+                   chunk.firstObject * SectionStrides[s];
+    std::memcpy(dst, file.Data() + chunk.sectionOffsets[s],
+                size_t(chunk.objectCount) * SectionStrides[s]);
+  }
+}
+
+uint64_t chunkBytes(const SceneFile::ChunkEntry &chunk) {
+  constexpr uint32_t last = SceneFile::SectionCount - 1;
+  return chunk.sectionOffsets[last] +
+         uint64_t(chunk.objectCount) * SectionStrides[last] -
+         chunk.sectionOffsets[0];
+}
+
+} // namespace
+
+// --------------------------------------------------------
+// Save / Load
+// --------------------------------------------------------
+
+bool SceneFile::Save(const std::string &path, const SceneData &scene,
+                     uint32_t chunkSize) {
+  size_t count = scene.ReadyCount();
+  if (chunkSize == 0)
+    chunkSize = DefaultChunkSize;
+
+  // Padding is written too; memset so equal scenes give equal files, which
+  // aggregate initialisation does not promise
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  header.magic = Magic;
+  header.version = Version;
+  header.objectCount = count;
+  header.seed = scene.seed;
+  header.chunkSize = chunkSize;
+  header.chunkCount = static_cast<uint32_t>((count + chunkSize - 1) / chunkSize);
+  header.sectionCount = SectionCount;
+  std::memcpy(header.sectionStrides, SectionStrides, sizeof(SectionStrides));
+  header.chunkTableOffset = alignUp(sizeof(Header), 16);
+
+  // Lay out every chunk before writing so the table can go first.
+  std::vector<ChunkEntry> table(header.chunkCount);
+  uint64_t offset =
+      header.chunkTableOffset + uint64_t(header.chunkCount) * sizeof(ChunkEntry);
+  for (uint32_t c = 0; c < header.chunkCount; c++) {
+    ChunkEntry &chunk = table[c];
+    chunk = ChunkEntry{};
+    chunk.firstObject = uint64_t(c) * chunkSize;
+    chunk.objectCount =
+        static_cast<uint32_t>(std::min<uint64_t>(chunkSize, count - chunk.firstObject));
+
+    offset = alignUp(offset, ChunkAlignment);
+    for (uint32_t s = 0; s < SectionCount; s++) {
+      offset = alignUp(offset, SectionAlignment);
+      chunk.sectionOffsets[s] = offset;
+      offset += uint64_t(chunk.objectCount) * SectionStrides[s];
+    }
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    std::cerr << "Could not write scene file: " << path << "\n";
+    return false;
+  }
+
+  uint64_t written = 0;
+  auto write = [&](const void *data, uint64_t size) {
+    file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    written += size;
+  };
+  auto padTo = [&](uint64_t target) {
+    static const char zeros[ChunkAlignment] = {};
+    while (written < target)
+      write(zeros, std::min<uint64_t>(target - written, sizeof(zeros)));
+  };
+
+  write(&header, sizeof(header));
+  padTo(header.chunkTableOffset);
+  write(table.data(), table.size() * sizeof(ChunkEntry));
+
+  for (const ChunkEntry &chunk : table) {
+    for (uint32_t s = 0; s < SectionCount; s++) {
+      padTo(chunk.sectionOffsets[s]);
+      const uint8_t *src = static_cast<const uint8_t *>(sectionData(scene, s)) +
+                           chunk.firstObject * SectionStrides[s];
+      write(src, uint64_t(chunk.objectCount) * SectionStrides[s]);
+    }
+  }
+
+  if (!file.good()) {
+    std::cerr << "Failed while writing scene file: " << path << "\n";
+    return false;
+  }
+
+  std::cout << "SUCCESS::SCENE::SAVED::" << path << " (" << count
+            << " objects, " << header.chunkCount << " chunks)" << std::endl;
+  return true;
+}
+
+bool SceneFile::Load(const std::string &path, SceneData &scene) {
+  AssetData file;
+  if (!VirtualFileSystem::shared().open(path, file))
+    return false;
+
+  const Header *header = nullptr;
+  const ChunkEntry *chunks = nullptr;
+  if (!validate(file, header, chunks))
+    return false;
+
+  scene.Resize(header->objectCount);
+  scene.seed = header->seed;
+  for (uint32_t c = 0; c < header->chunkCount; c++)
+    copyChunk(file, chunks[c], scene);
+  scene.readyCount.store(header->objectCount, std::memory_order_release);
+
+  std::cout << "SUCCESS::SCENE::LOADED::" << path << " ("
+            << header->objectCount << " objects)" << std::endl;
+  return true;
+}
+
+// --------------------------------------------------------
+// SceneStreamer
+// --------------------------------------------------------
+
+SceneStreamer::~SceneStreamer() { Stop(); }
+
+bool SceneStreamer::Start(const std::string &path, SceneData &scene) {
+  Stop();
+
+  // Archived scenes stream straight out of the archive mapping
+  if (!VirtualFileSystem::shared().open(path, file))
+    return false;
+  if (!validate(file, header, chunks)) {
+    file.Close();
+    return false;
+  }
+
+  // Sized once here; the worker only ever writes into existing storage, so
+  // readers of the first readyCount objects never see a reallocation.
+  target = &scene;
+  target->Resize(header->objectCount);
+  target->seed = header->seed;
+
+  cancel.store(false);
+  chunksLoaded.store(0);
+  elapsedMs.store(0.0);
+  running.store(true, std::memory_order_release);
+  worker = std::thread(&SceneStreamer::Run, this);
+
+  std::cout << "SCENE::STREAMING::" << path << " (" << header->objectCount
+            << " objects, " << header->chunkCount << " chunks)" << std::endl;
+  return true;
+}
+
+void SceneStreamer::Stop() {
+  cancel.store(true);
+  if (worker.joinable())
+    worker.join();
+  running.store(false);
+  file.Close();
+  header = nullptr;
+  chunks = nullptr;
+}
+
+float SceneStreamer::Progress() const {
+  if (!header || header->chunkCount == 0)
+    return 1.0f;
+  return static_cast<float>(chunksLoaded.load()) / header->chunkCount;
+}
+
+void SceneStreamer::Run() {
+  PROFILE_THREAD("Scene Streamer");
+  auto start = std::chrono::steady_clock::now();
+
+  if (header->chunkCount > 0)
+    file.Prefetch(chunks[0].sectionOffsets[0], chunkBytes(chunks[0]));
+
+  for (uint32_t c = 0; c < header->chunkCount; c++) {
+    if (cancel.load(std::memory_order_relaxed))
+      break;
+
+    // Ask the OS for the next chunk while this one is being copied.
+    if (c + 1 < header->chunkCount)
+      file.Prefetch(chunks[c + 1].sectionOffsets[0], chunkBytes(chunks[c + 1]));
+
+    PROFILE_SCOPE("Stream Chunk");
+    copyChunk(file, chunks[c], *target);
+    target->readyCount.store(chunks[c].firstObject + chunks[c].objectCount,
+                             std::memory_order_release);
+    chunksLoaded.store(c + 1, std::memory_order_release);
+  }
+
+  elapsedMs.store(std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - start)
+                      .count(),
+                  std::memory_order_release);
+  running.store(false, std::memory_order_release);
+}
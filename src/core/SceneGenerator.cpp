@@ -0,0 +1,295 @@
+#include "core/SceneGenerator.h"
+#include "tools/Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr float TwoPi = 6.28318530718f;
+
+// Streams per object: every attribute draws from its own counter so adding a
+// new attribute never shifts the values of the existing ones.
+enum Stream : uint64_t {
+  PosX,
+  PosY,
+  PosZ,
+  Extra0,
+  Extra1,
+  Extra2,
+  Extra3,
+  Material,
+  StreamCount = 8
+};
+
+uint64_t splitmix64(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ull;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+
+struct ObjectRng {
+  const SquaresRng &rng;
+  uint64_t base;
+
+  float Uniform(Stream s) const { return rng.Uniform(base + s); }
+  uint32_t Bits(Stream s) const { return rng.Next(base + s); }
+
+  // Standard normal via Box-Muller over two streams
+  float Gaussian(Stream a, Stream b) const {
+    float u1 = std::max(Uniform(a), 1e-7f);
+    float u2 = Uniform(b);
+    return std::sqrt(-2.0f * std::log(u1)) * std::cos(TwoPi * u2);
+  }
+};
+
+struct Placement {
+  glm::vec3 position;
+  glm::vec3 scale{1.0f};
+};
+
+Placement placeUniform(const ObjectRng &r, const SceneGeneratorSettings &s) {
+  return {glm::vec3(r.Uniform(PosX), r.Uniform(PosY), r.Uniform(PosZ)) *
+              (2.0f * s.extent) -
+          glm::vec3(s.extent)};
+}
+
+Placement placeClustered(const ObjectRng &r, const SceneGeneratorSettings &s,
+                         const SquaresRng &clusterRng) {
+  uint64_t clusterCount = static_cast<uint64_t>(std::max(s.clusterCount, 1));
+  uint64_t cluster = r.Bits(Extra0) % clusterCount;
+
+  // Cluster centres come from a separate key so they only depend on the seed
+  uint64_t c = cluster * 3;
+  glm::vec3 centre = glm::vec3(clusterRng.Uniform(c), clusterRng.Uniform(c + 1),
+                               clusterRng.Uniform(c + 2)) *
+                         (2.0f * s.extent) -
+                     glm::vec3(s.extent);
+
+  glm::vec3 offset(r.Gaussian(PosX, Extra1), r.Gaussian(PosY, Extra2),
+                   r.Gaussian(PosZ, Extra3));
+  return {centre + offset * s.clusterRadius};
+}
+
+Placement placeGrid(size_t index, const SceneGeneratorSettings &s) {
+  size_t side = static_cast<size_t>(
+      std::ceil(std::cbrt(static_cast<double>(std::max<size_t>(s.objectCount, 1)))));
+  float spacing = 2.0f * s.extent / static_cast<float>(side);
+
+  size_t x = index % side;
+  size_t y = (index / side) % side;
+  size_t z = index / (side * side);
+  return {glm::vec3(static_cast<float>(x), static_cast<float>(y),
+                    static_cast<float>(z)) *
+                  spacing +
+              glm::vec3(spacing * 0.5f - s.extent)};
+}
+
+Placement placeCityBlock(size_t index, const ObjectRng &r,
+                         const SceneGeneratorSettings &s) {
+  // One tower per lot, 8x8 lots per block, streets between blocks. The city
+  // grows with the object count instead of being squeezed into the box.
+  constexpr size_t lotsPerBlock = 8;
+  constexpr float lotSize = 1.5f;
+  constexpr float streetWidth = 4.0f;
+  constexpr float maxHeight = 12.0f;
+
+  size_t side = static_cast<size_t>(
+      std::ceil(std::sqrt(static_cast<double>(std::max<size_t>(s.objectCount, 1)))));
+  size_t lotX = index % side;
+  size_t lotZ = index / side;
+
+  auto axis = [&](size_t lot) {
+    size_t block = lot / lotsPerBlock;
+    size_t inBlock = lot % lotsPerBlock;
+    return static_cast<float>(block) * (lotsPerBlock * lotSize + streetWidth) +
+           static_cast<float>(inBlock) * lotSize;
+  };
+
+  float blocks = static_cast<float>((side + lotsPerBlock - 1) / lotsPerBlock);
+  float cityWidth = blocks * (lotsPerBlock * lotSize + streetWidth);
+
+  // Squaring the uniform gives many low buildings and a few towers
+  float u = r.Uniform(Extra0);
+  float height = 1.0f + u * u * (maxHeight - 1.0f);
+
+  Placement p;
+  p.scale = glm::vec3(1.0f, height, 1.0f);
+  p.position = glm::vec3(axis(lotX) - cityWidth * 0.5f, height * 0.5f - 2.0f,
+                         axis(lotZ) - cityWidth * 0.5f);
+  return p;
+}
+
+Placement placeSphereShell(const ObjectRng &r, const SceneGeneratorSettings &s) {
+  constexpr float thickness = 0.05f;
+
+  float z = 1.0f - 2.0f * r.Uniform(PosX);
+  float phi = TwoPi * r.Uniform(PosY);
+  float ring = std::sqrt(std::max(0.0f, 1.0f - z * z));
+  float radius = s.extent * (1.0f - thickness * r.Uniform(PosZ));
+  return {glm::vec3(ring * std::cos(phi), ring * std::sin(phi), z) * radius};
+}
+
+void generateRange(SceneData &scene, const SceneGeneratorSettings &settings,
+                   const SquaresRng &rng, const SquaresRng &clusterRng,
+                   size_t begin, size_t end) {
+  for (size_t i = begin; i < end; i++) {
+    ObjectRng r{rng, static_cast<uint64_t>(i) * StreamCount};
+
+    Placement p;
+    switch (settings.distribution) {
+    case SceneDistribution::Clustered:
+      p = placeClustered(r, settings, clusterRng);
+      break;
+    case SceneDistribution::Grid:
+      p = placeGrid(i, settings);
+      break;
+    case SceneDistribution::CityBlock:
+      p = placeCityBlock(i, r, settings);
+      break;
+    case SceneDistribution::SphereShell:
+      p = placeSphereShell(r, settings);
+      break;
+    default:
+      p = placeUniform(r, settings);
+      break;
+    }
+
+    scene.positions[i] = p.position;
+    scene.rotations[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    scene.scales[i] = p.scale;
+    scene.meshIds[i] = 0;
+    scene.materialIds[i] = r.Bits(Material) % std::max(settings.materialCount, 1u);
+    scene.bounds[i] = {p.position - p.scale * 0.5f, p.position + p.scale * 0.5f};
+  }
+}
+
+// FNV-style mix over 8-byte words; only needs to be fast and order-dependent
+uint64_t hashBytes(uint64_t hash, const void *data, size_t size) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, bytes + i, 8);
+    hash = (hash ^ word) * 0x100000001B3ull;
+    hash ^= hash >> 29;
+  }
+  for (; i < size; i++)
+    hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+  return hash;
+}
+
+} // namespace
+
+const char *SceneDistributionName(SceneDistribution distribution) {
+  switch (distribution) {
+  case SceneDistribution::UniformBox:
+    return "Uniform Box";
+  case SceneDistribution::Clustered:
+    return "Clustered";
+  case SceneDistribution::Grid:
+    return "Grid";
+  case SceneDistribution::CityBlock:
+    return "City Block";
+  case SceneDistribution::SphereShell:
+    return "Sphere Shell";
+  default:
+    return "Unknown";
+  }
+}
+
+// --------------------------------------------------------
+// SquaresRng
+// --------------------------------------------------------
+
+SquaresRng::SquaresRng(uint64_t seed) {
+  // Squares needs a key with well-mixed bits; odd keeps the low bit busy.
+  key = splitmix64(seed) | 1ull;
+}
+
+uint32_t SquaresRng::Next(uint64_t counter) const {
+  uint64_t x = counter * key;
+  uint64_t y = x;
+  uint64_t z = y + key;
+  x = x * x + y;
+  x = (x >> 32) | (x << 32);
+  x = x * x + z;
+  x = (x >> 32) | (x << 32);
+  x = x * x + y;
+  x = (x >> 32) | (x << 32);
+  return static_cast<uint32_t>((x * x + z) >> 32);
+}
+
+float SquaresRng::Uniform(uint64_t counter) const {
+  // Top 24 bits fit a float mantissa exactly
+  return static_cast<float>(Next(counter) >> 8) * (1.0f / 16777216.0f);
+}
+
+// --------------------------------------------------------
+// Generation
+// --------------------------------------------------------
+
+double GenerateScene(SceneData &scene, const SceneGeneratorSettings &settings) {
+  PROFILE_SCOPE("GenerateScene");
+  auto start = std::chrono::steady_clock::now();
+
+  size_t count = settings.objectCount;
+  scene.Resize(count);
+  scene.seed = settings.seed;
+
+  SquaresRng rng(settings.seed);
+  SquaresRng clusterRng(settings.seed ^ 0x5EEDC1A5ull);
+
+  int threads = settings.threadCount > 0
+                    ? settings.threadCount
+                    : static_cast<int>(std::thread::hardware_concurrency());
+  threads = std::max(threads, 1);
+
+  // Workers pull fixed-size blocks so uneven cores still finish together.
+  constexpr size_t blockSize = 16384;
+  size_t blockCount = (count + blockSize - 1) / blockSize;
+  std::atomic<size_t> nextBlock{0};
+
+  auto worker = [&]() {
+    for (;;) {
+      size_t block = nextBlock.fetch_add(1, std::memory_order_relaxed);
+      if (block >= blockCount)
+        break;
+      size_t begin = block * blockSize;
+      generateRange(scene, settings, rng, clusterRng, begin,
+                    std::min(begin + blockSize, count));
+    }
+  };
+
+  size_t workerCount = std::min<size_t>(threads, blockCount);
+  std::vector<std::thread> pool;
+  for (size_t t = 1; t < workerCount; t++)
+    pool.emplace_back(worker);
+  worker();
+  for (auto &thread : pool)
+    thread.join();
+
+  scene.readyCount.store(count, std::memory_order_release);
+
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+uint64_t HashSceneData(const SceneData &scene) {
+  size_t n = scene.ReadyCount();
+  uint64_t hash = 0xCBF29CE484222325ull;
+  hash = hashBytes(hash, scene.positions.data(), n * sizeof(glm::vec3));
+  hash = hashBytes(hash, scene.rotations.data(), n * sizeof(glm::vec4));
+  hash = hashBytes(hash, scene.scales.data(), n * sizeof(glm::vec3));
+  hash = hashBytes(hash, scene.meshIds.data(), n * sizeof(uint32_t));
+  hash = hashBytes(hash, scene.materialIds.data(), n * sizeof(uint32_t));
+  hash = hashBytes(hash, scene.bounds.data(), n * sizeof(ObjectBounds));
+  return hash;
+}
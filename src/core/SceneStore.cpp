@@ -0,0 +1,535 @@
+#include "core/SceneStore.h"
+#include "core/Cube.h"
+#include "tools/EngineConfig.h"
+#include "tools/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// Caps the per-frame upload while a large scene is streaming in, so the
+// mirror catches up over several frames instead of stalling one.
+static constexpr size_t MaxUploadPerUpdate = 262144;
+
+// Slot 0 is the benchmark's photo texture; the rest are generated patterns in
+// four sizes so the batcher exercises both full layers and atlas packing.
+static void addTextureSet(TextureBatcher &textures, int count) {
+  textures.AddFile(EngineConfig::TextureDirectory + "test1.jpg");
+
+  const int sizes[] = {512, 256, 128, 64};
+  std::vector<unsigned char> pixels;
+  for (int i = 1; i < count; i++) {
+    int size = sizes[i % 4];
+    pixels.resize(size_t(size) * size * 4);
+
+    // Golden-ratio hue steps keep neighbouring slots visually distinct
+    float hue = std::fmod(i * 0.618034f, 1.0f) * 6.0f;
+    glm::vec3 color(std::clamp(std::fabs(hue - 3.0f) - 1.0f, 0.0f, 1.0f),
+                    std::clamp(2.0f - std::fabs(hue - 2.0f), 0.0f, 1.0f),
+                    std::clamp(2.0f - std::fabs(hue - 4.0f), 0.0f, 1.0f));
+
+    int cells = 2 + i % 7;
+    int pattern = (i / 4) % 3;
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size; x++) {
+        int cx = x * cells / size, cy = y * cells / size;
+        bool on;
+        if (pattern == 0) // checker
+          on = ((cx + cy) & 1) != 0;
+        else if (pattern == 1) // stripes
+          on = (cx & 1) != 0;
+        else { // rings
+          float dx = x - size * 0.5f, dy = y - size * 0.5f;
+          on = (static_cast<int>(std::sqrt(dx * dx + dy * dy) * cells / size) & 1) != 0;
+        }
+
+        float shade = on ? 1.0f : 0.35f;
+        unsigned char *px = &pixels[(size_t(y) * size + x) * 4];
+        px[0] = static_cast<unsigned char>(color.x * shade * 255.0f);
+        px[1] = static_cast<unsigned char>(color.y * shade * 255.0f);
+        px[2] = static_cast<unsigned char>(color.z * shade * 255.0f);
+        px[3] = 255;
+      }
+    }
+    textures.Add(size, size, pixels.data());
+  }
+
+  // Build changes nothing when it fails; the set was released before it, so
+  // objects draw untextured until the next successful build
+  if (!textures.Build())
+    std::cerr << "ERROR::SCENESTORE::TEXTURE_BUILD_FAILED::" << count
+              << " textures" << std::endl;
+}
+
+// Light tints and a roughness/metallic spread over the texture set, so
+// neighbouring materials differ even when they share a texture.
+static void addMaterialSet(MaterialTable &materials, int count, size_t slots) {
+  std::vector<Material> set(count);
+  for (int i = 0; i < count; i++) {
+    Material &m = set[i];
+    float hue = std::fmod(i * 0.381966f, 1.0f) * 6.0f;
+    m.baseColor = glm::vec4(
+        0.7f + 0.3f * std::clamp(std::fabs(hue - 3.0f) - 1.0f, 0.0f, 1.0f),
+        0.7f + 0.3f * std::clamp(2.0f - std::fabs(hue - 2.0f), 0.0f, 1.0f),
+        0.7f + 0.3f * std::clamp(2.0f - std::fabs(hue - 4.0f), 0.0f, 1.0f),
+        1.0f);
+    m.roughness = 0.2f + 0.6f * std::fmod(i * 0.754877f, 1.0f);
+    m.metallic = (i % 5 == 0) ? 1.0f : 0.0f;
+    m.diffuseSlot = static_cast<uint32_t>(i % std::max<size_t>(slots, 1));
+  }
+  materials.Build(set);
+}
+
+void SceneStore::Init() {
+  PROFILE_SCOPE("SceneStore Init");
+  cubeBuffer.Create("Scene");
+  glBindBuffer(GL_ARRAY_BUFFER, cubeBuffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices,
+               GL_STATIC_DRAW);
+  cubeBuffer.SetBytes(sizeof(cubeVertices));
+  cubeTexture.Create("Scene");
+  glBindTexture(GL_TEXTURE_BUFFER, cubeTexture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, cubeBuffer);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+  instanceBuffer.Create("Scene");
+  materialBuffer.Create("Scene");
+  // Created up front so strategies can point a VAO at them before the first
+  // sort fills them
+  sortedInstanceBuffer.Create("Scene/Sorted");
+  sortedMaterialBuffer.Create("Scene/Sorted");
+
+  addTextureSet(textures, textureCount);
+  addMaterialSet(materials, materialCount, textures.SlotCount());
+}
+
+void SceneStore::SetTextureCount(int count) {
+  textureCount = std::max(count, 1);
+  textures.Release();
+  addTextureSet(textures, textureCount);
+  // Only the records change; per-object indices stay valid
+  addMaterialSet(materials, materialCount, textures.SlotCount());
+}
+
+void SceneStore::SetMaterialCount(int count) {
+  materialCount = std::clamp(count, 1, static_cast<int>(MaterialTable::MaxMaterials));
+  addMaterialSet(materials, materialCount, textures.SlotCount());
+
+  // Only the object -> material mapping changed: remap the resident objects
+  // and resend the index buffers, leaving matrices, hierarchy and lights be
+  uint32_t tableSize = static_cast<uint32_t>(std::max<size_t>(materials.Count(), 1));
+  for (size_t i = 0; i < gpuCount; i++)
+    objectMaterials[i] = data.materialIds[i] % tableSize;
+  for (size_t i = 0; i < sortedMaterials.size() && i < drawOrder.size(); i++)
+    sortedMaterials[i] = objectMaterials[drawOrder[i]];
+  materialsPending = true;
+  materialVersion++;
+}
+
+void SceneStore::SetHierarchy(bool enabled, int fanout, int pivotLevels) {
+  hierarchyEnabled = enabled;
+  hierarchyFanout = fanout;
+  hierarchyLevels = pivotLevels;
+  hierarchy.Clear();
+  // Matrices written by the hierarchy no longer match the flat scene
+  Invalidate();
+}
+
+void SceneStore::SetLighting(bool enabled, int count) {
+  lightingEnabled = enabled;
+  lightCount = std::clamp(count, 0, static_cast<int>(ClusteredLights::MaxLights));
+}
+
+void SceneStore::Shutdown() {
+  for (auto &[name, shader] : shaders) {
+    GpuResourceTracker::Get().Untrack(GpuResourceType::Program, shader.ID);
+    glDeleteProgram(shader.ID);
+  }
+  shaders.clear();
+  derived.clear();
+
+  textures.Release();
+  materials.Release();
+  lights.Release();
+  lightsVersion = 0;
+  sortedInstanceBuffer.Reset();
+  sortedMaterialBuffer.Reset();
+  sortedTransformVersion = 0;
+  sortedPending = lightsPending = hierarchyPending = reallocatePending = false;
+  streamBegin = streamEnd = 0;
+  drawOrder.clear();
+  instanceBuffer.Reset();
+  materialBuffer.Reset();
+  cubeTexture.Reset();
+  cubeBuffer.Reset();
+  gpuCount = gpuCapacity = 0;
+  gpuVersion = 0;
+  hierarchy.Clear();
+}
+
+void SceneStore::Update(const FrameContext &frame) {
+  PROFILE_SCOPE("SceneStore Update");
+  auto start = std::chrono::steady_clock::now();
+  lastUploadBytes = 0;
+
+  // New scene: reallocate the mirror and start filling it from scratch.
+  if (gpuVersion != version || gpuCapacity != data.Size()) {
+    gpuCapacity = data.Size();
+    gpuCount = 0;
+    gpuVersion = version;
+    modelMatrices.resize(gpuCapacity);
+    objectMaterials.resize(gpuCapacity);
+    reallocatePending = true;
+    streamBegin = streamEnd = 0;
+  }
+
+  size_t ready = std::min(data.ReadyCount(), gpuCapacity);
+  if (ready > gpuCount) {
+    size_t begin = gpuCount;
+    size_t end = std::min(ready, begin + MaxUploadPerUpdate);
+
+    uint32_t tableSize = static_cast<uint32_t>(std::max<size_t>(materials.Count(), 1));
+    for (size_t i = begin; i < end; i++) {
+      modelMatrices[i] = ComposeTransform(data.positions[i], data.rotations[i],
+                                          data.scales[i]);
+      objectMaterials[i] = data.materialIds[i] % tableSize;
+    }
+
+    if (streamEnd == streamBegin)
+      streamBegin = begin;
+    streamEnd = end;
+    lastUploadBytes = (end - begin) * (sizeof(glm::mat4) + sizeof(uint32_t));
+    gpuCount = end;
+    transformVersion++;
+  }
+
+  // The hierarchy covers the whole scene, so it waits for streaming to finish
+  if (hierarchyEnabled && gpuCapacity > 0 && gpuCount == gpuCapacity) {
+    if (hierarchy.Empty() || hierarchyVersion != version) {
+      hierarchy.Build(data, gpuCapacity, hierarchyFanout, hierarchyLevels);
+      hierarchyVersion = version;
+    }
+
+    hierarchy.Animate(frame.time, hierarchyMovingFraction);
+    if (hierarchy.Update(modelMatrices.data()) > 0) {
+      for (const TransformHierarchy::LeafRange &range : hierarchy.DirtyLeafRanges())
+        lastUploadBytes += (range.end - range.begin) * sizeof(glm::mat4);
+      hierarchyPending = true;
+      transformVersion++;
+    }
+  }
+
+  lastUpdateMs = std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+
+  UpdateLights(frame);
+  UpdateDrawOrder(frame);
+}
+
+size_t SceneStore::Upload() {
+  PROFILE_SCOPE("SceneStore Upload");
+  size_t bytes = 0;
+  if (reallocatePending) {
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, gpuCapacity * sizeof(glm::mat4), nullptr,
+                 GL_STATIC_DRAW);
+    instanceBuffer.SetBytes(gpuCapacity * sizeof(glm::mat4));
+    glBindBuffer(GL_ARRAY_BUFFER, materialBuffer);
+    glBufferData(GL_ARRAY_BUFFER, gpuCapacity * sizeof(uint32_t), nullptr,
+                 GL_STATIC_DRAW);
+    materialBuffer.SetBytes(gpuCapacity * sizeof(uint32_t));
+    reallocatePending = false;
+  }
+
+  if (streamEnd > streamBegin) {
+    size_t count = streamEnd - streamBegin;
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, streamBegin * sizeof(glm::mat4),
+                    count * sizeof(glm::mat4), modelMatrices.data() + streamBegin);
+    glBindBuffer(GL_ARRAY_BUFFER, materialBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, streamBegin * sizeof(uint32_t),
+                    count * sizeof(uint32_t), objectMaterials.data() + streamBegin);
+    bytes += count * (sizeof(glm::mat4) + sizeof(uint32_t));
+    streamBegin = streamEnd = 0;
+  }
+
+  if (hierarchyPending) {
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    for (const TransformHierarchy::LeafRange &range : hierarchy.DirtyLeafRanges()) {
+      size_t count = range.end - range.begin;
+      glBufferSubData(GL_ARRAY_BUFFER, range.begin * sizeof(glm::mat4),
+                      count * sizeof(glm::mat4), modelMatrices.data() + range.begin);
+      bytes += count * sizeof(glm::mat4);
+    }
+    hierarchyPending = false;
+  }
+
+  if (sortedPending) {
+    size_t count = sortedMatrices.size();
+    glBindBuffer(GL_ARRAY_BUFFER, sortedInstanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::mat4), sortedMatrices.data(),
+                 GL_STREAM_DRAW);
+    sortedInstanceBuffer.SetBytes(count * sizeof(glm::mat4));
+    glBindBuffer(GL_ARRAY_BUFFER, sortedMaterialBuffer);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(uint32_t), sortedMaterials.data(),
+                 GL_STREAM_DRAW);
+    sortedMaterialBuffer.SetBytes(count * sizeof(uint32_t));
+    bytes += count * (sizeof(glm::mat4) + sizeof(uint32_t));
+    sortedPending = false;
+  }
+
+  if (materialsPending) {
+    glBindBuffer(GL_ARRAY_BUFFER, materialBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, gpuCount * sizeof(uint32_t),
+                    objectMaterials.data());
+    bytes += gpuCount * sizeof(uint32_t);
+    if (!sortedMaterials.empty()) {
+      glBindBuffer(GL_ARRAY_BUFFER, sortedMaterialBuffer);
+      glBufferSubData(GL_ARRAY_BUFFER, 0, sortedMaterials.size() * sizeof(uint32_t),
+                      sortedMaterials.data());
+      bytes += sortedMaterials.size() * sizeof(uint32_t);
+    }
+    materialsPending = false;
+  }
+
+  if (lightsPending) {
+    lights.Upload();
+    bytes += lights.lastUploadBytes;
+    lightsPending = false;
+  }
+  return bytes;
+}
+
+void SceneStore::UpdateLights(const FrameContext &frame) {
+  // Lights are placed over the whole scene, so wait until it is resident
+  if (!lightingEnabled || gpuCapacity == 0 || gpuCount < gpuCapacity)
+    return;
+
+  if (lightsVersion != version || lights.Count() != size_t(lightCount) ||
+      lightsRadiusScale != lightRadiusScale) {
+    glm::vec3 boundsMin(modelMatrices[0][3]), boundsMax(boundsMin);
+    for (size_t i = 1; i < gpuCount; i++) {
+      glm::vec3 p(modelMatrices[i][3]);
+      boundsMin = glm::min(boundsMin, p);
+      boundsMax = glm::max(boundsMax, p);
+    }
+    // Fixed seed, so captures of the same scene and count stay comparable
+    lights.Generate(lightCount, boundsMin, boundsMax, lightRadiusScale, 1);
+    lightsVersion = version;
+    lightsRadiusScale = lightRadiusScale;
+  }
+
+  viewportWidth = frame.viewportWidth;
+  viewportHeight = frame.viewportHeight;
+  lights.Assign(frame.view, frame.fovY, frame.aspect, frame.zNear, frame.zFar);
+  lightsPending = true;
+}
+
+void SceneStore::BindLighting(const Shader &shader, RenderCounters *stats) const {
+  lights.Bind(shader, viewportWidth, viewportHeight, stats);
+}
+
+void SceneStore::BindCubeAttributes() const {
+  glBindBuffer(GL_ARRAY_BUFFER, cubeBuffer);
+  GLsizei stride = CubeVertexStride * sizeof(float);
+
+  // position attribute
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *)0);
+  glEnableVertexAttribArray(0);
+  // normal attribute
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
+                        (void *)(3 * sizeof(float)));
+  glEnableVertexAttribArray(1);
+  // texcoords attribute
+  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
+                        (void *)(6 * sizeof(float)));
+  glEnableVertexAttribArray(2);
+}
+
+// Same ordering as the float, as an unsigned integer
+static uint32_t sortableFloat(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+void SceneStore::UpdateDrawOrder(const FrameContext &frame) {
+  if (!frontToBack)
+    return;
+  PROFILE_SCOPE("Draw Order Sort");
+  auto start = std::chrono::steady_clock::now();
+  size_t count = std::min(frame.objectCount, gpuCount);
+
+  // Distance along the view direction of each object's origin
+  const glm::mat4 &view = frame.view;
+  glm::vec4 depthRow(-view[0][2], -view[1][2], -view[2][2], -view[3][2]);
+  std::vector<uint64_t> &items = sortItems[0];
+  std::vector<uint64_t> &scratch = sortItems[1];
+  items.resize(count);
+  scratch.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    float depth = glm::dot(depthRow, glm::vec4(glm::vec3(modelMatrices[i][3]), 1.0f));
+    items[i] = (uint64_t(sortableFloat(depth)) << 32) | i;
+  }
+
+  // LSD radix sort on the key, eight bits per pass; stable, so equal depths
+  // keep index order
+  uint64_t *in = items.data(), *out = scratch.data();
+  for (int shift = 32; shift < 64; shift += 8) {
+    size_t offsets[256] = {};
+    for (size_t i = 0; i < count; i++)
+      offsets[(in[i] >> shift) & 0xFF]++;
+    size_t sum = 0;
+    for (size_t &offset : offsets) {
+      size_t bucket = offset;
+      offset = sum;
+      sum += bucket;
+    }
+    for (size_t i = 0; i < count; i++)
+      out[offsets[(in[i] >> shift) & 0xFF]++] = in[i];
+    std::swap(in, out);
+  }
+
+  bool changed = drawOrder.size() != count;
+  drawOrder.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    uint32_t index = static_cast<uint32_t>(in[i]);
+    changed |= drawOrder[i] != index;
+    drawOrder[i] = index;
+  }
+  if (changed)
+    drawOrderVersion++;
+
+  // Sorted copy of the instance data, only when the order or a matrix moved
+  if (count > 0 && (sortedOrderVersion != drawOrderVersion ||
+                    sortedTransformVersion != transformVersion)) {
+    sortedMatrices.resize(count);
+    sortedMaterials.resize(count);
+    for (size_t i = 0; i < count; i++) {
+      sortedMatrices[i] = modelMatrices[drawOrder[i]];
+      sortedMaterials[i] = objectMaterials[drawOrder[i]];
+    }
+    sortedPending = true;
+    sortedOrderVersion = drawOrderVersion;
+    sortedTransformVersion = transformVersion;
+  }
+
+  lastSortMs = std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+}
+
+void SceneStore::BindInstanceAttributes(GLuint firstLocation, bool sorted) const {
+  glBindBuffer(GL_ARRAY_BUFFER, sorted ? sortedInstanceBuffer : instanceBuffer);
+
+  // A mat4 attribute takes four consecutive vec4 locations
+  for (GLuint column = 0; column < 4; column++) {
+    GLuint location = firstLocation + column;
+    glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                          (void *)(column * sizeof(glm::vec4)));
+    glEnableVertexAttribArray(location);
+    glVertexAttribDivisor(location, 1);
+  }
+
+  GLuint materialLocation = firstLocation + 4;
+  glBindBuffer(GL_ARRAY_BUFFER, sorted ? sortedMaterialBuffer : materialBuffer);
+  glVertexAttribIPointer(materialLocation, 1, GL_UNSIGNED_INT, sizeof(uint32_t),
+                         (void *)0);
+  glEnableVertexAttribArray(materialLocation);
+  glVertexAttribDivisor(materialLocation, 1);
+}
+
+void SceneStore::BindMaterials(const Shader &shader, RenderCounters *stats) const {
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, textures.ArrayTexture());
+  shader.setUniform("diffuseArray", 0);
+
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_BUFFER, textures.SlotTable());
+  shader.setUniform("textureSlots", 1);
+
+  glActiveTexture(GL_TEXTURE0);
+  materials.Bind();
+
+  if (stats) {
+    stats->textureBinds += 2;
+    stats->stateChanges += 3; // two sampler uniforms and the uniform block
+  }
+}
+
+SceneStore::Programs SceneStore::GetPrograms(const std::string &vertexName,
+                                             const std::string &geometryName) {
+  Programs programs;
+  programs.unlit = &GetShader(vertexName, "texarray.fs", geometryName);
+  programs.lit = &GetShader(vertexName, "clustered.fs", geometryName);
+  programs.depth = &GetShader(vertexName, "depthonly.fs", geometryName);
+  return programs;
+}
+
+Shader &SceneStore::UseProgram(const Programs &programs,
+                               RenderCounters *stats) const {
+  if (stats)
+    stats->stateChanges += 2; // the program and vertexWork
+
+  if (depthOnly) {
+    // Only positions matter, but the vertex shader still reads materials
+    programs.depth->use();
+    BindMaterials(*programs.depth, stats);
+    programs.depth->setUniform("vertexWork", vertexWork);
+    return *programs.depth;
+  }
+
+  bool lit = lightingEnabled && !unlit;
+  Shader &shader = lit ? *programs.lit : *programs.unlit;
+  shader.use();
+  BindMaterials(shader, stats);
+  shader.setUniform("vertexWork", vertexWork);
+  if (lit)
+    BindLighting(shader, stats);
+  return shader;
+}
+
+Shader &SceneStore::GetShader(const std::string &vertexName,
+                              const std::string &fragmentName,
+                              const std::string &geometryName) {
+  std::string key = vertexName + "|" + fragmentName + "|" + geometryName;
+  auto it = shaders.find(key);
+  if (it != shaders.end())
+    return it->second;
+
+  PROFILE_SCOPE("Shader Compile");
+  Shader &shader = shaders[key];
+  std::string geometryPath = EngineConfig::ShaderDirectory + geometryName;
+  shader.LoadAdvShaders((EngineConfig::ShaderDirectory + vertexName).c_str(),
+                        (EngineConfig::ShaderDirectory + fragmentName).c_str(),
+                        geometryName.empty() ? nullptr : geometryPath.c_str());
+
+  // Programs are created inside Shader, so register them here
+  GLint binaryLength = 0;
+  glGetProgramiv(shader.ID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+  GpuResourceTracker::Get().Track(GpuResourceType::Program, shader.ID, "Shaders",
+                                  std::source_location::current());
+  GpuResourceTracker::Get().SetBytes(GpuResourceType::Program, shader.ID,
+                                     static_cast<size_t>(binaryLength));
+  return shader;
+}
+
+SceneStore::DerivedBuffer &SceneStore::GetDerived(const std::string &name) {
+  DerivedBuffer &buffer = derived[name];
+  if (!buffer.buffer)
+    buffer.buffer.Create("Scene/Derived");
+  return buffer;
+}
+
+size_t SceneStore::GpuBytes() const {
+  size_t bytes = gpuCapacity * (sizeof(glm::mat4) + sizeof(uint32_t)) +
+                 sizeof(cubeVertices) + textures.GpuBytes() +
+                 MaterialTable::MaxMaterials * sizeof(MaterialRecord) +
+                 lights.GpuBytes();
+  for (const auto &[name, buffer] : derived)
+    bytes += buffer.bytes;
+  return bytes;
+}
@@ -0,0 +1,197 @@
+#include "core/TransformHierarchy.h"
+#include "tools/FrameArena.h"
+#include "tools/JobSystem.h"
+#include "tools/Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+// Nodes per job block; small enough to balance uneven dirty subtrees
+static constexpr size_t UpdateGrain = 2048;
+// Dirty leaf runs closer than this many matrices (4 KB) are uploaded as one
+// range; a few wasted bytes beat one more glBufferSubData call
+static constexpr size_t RangeMergeGap = 64;
+// Merged runs are at least RangeMergeGap apart, which bounds them per block
+static constexpr size_t MaxRangesPerBlock = UpdateGrain / (RangeMergeGap + 1) + 1;
+
+template <typename Ranges>
+static void appendRange(Ranges &ranges, size_t begin, size_t end) {
+  if (!ranges.empty() && begin <= ranges.back().end + RangeMergeGap)
+    ranges.back().end = end;
+  else
+    ranges.push_back({begin, end});
+}
+
+void TransformHierarchy::Build(const SceneData &scene, size_t count, int fanout,
+                               int pivotLevels) {
+  PROFILE_SCOPE("Hierarchy Build");
+  Clear();
+  if (count == 0)
+    return;
+  fanout = std::max(fanout, 2);
+
+  // Level sizes from the leaves up
+  std::vector<size_t> sizes{count};
+  for (int l = 0; l < pivotLevels && sizes.back() > 1; l++)
+    sizes.push_back((sizes.back() + fanout - 1) / fanout);
+  std::reverse(sizes.begin(), sizes.end());
+
+  levelStart.push_back(0);
+  for (size_t size : sizes)
+    levelStart.push_back(levelStart.back() + static_cast<uint32_t>(size));
+  size_t nodeCount = levelStart.back();
+  leafBegin = nodeCount - count;
+
+  parent.assign(nodeCount, NoParent);
+  localPosition.assign(nodeCount, glm::vec3(0.0f));
+  localRotation.assign(nodeCount, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+  localScale.assign(nodeCount, glm::vec3(1.0f));
+  world.assign(leafBegin, glm::mat4(1.0f));
+  dirty.assign(nodeCount, 1);
+  updatedStamp.assign(nodeCount, 0);
+  stamp = 0;
+
+  for (size_t l = 1; l < sizes.size(); l++) {
+    for (uint32_t i = levelStart[l]; i < levelStart[l + 1]; i++)
+      parent[i] = static_cast<int32_t>(levelStart[l - 1] + (i - levelStart[l]) / fanout);
+  }
+
+  // Pivot world positions are their children's centroid, built bottom-up
+  std::vector<glm::vec3> worldPosition(nodeCount);
+  std::vector<uint32_t> childCount(leafBegin, 0);
+  for (size_t i = 0; i < count; i++)
+    worldPosition[leafBegin + i] = scene.positions[i];
+  for (size_t l = sizes.size() - 1; l > 0; l--) {
+    for (uint32_t i = levelStart[l]; i < levelStart[l + 1]; i++) {
+      worldPosition[parent[i]] += worldPosition[i];
+      childCount[parent[i]]++;
+    }
+    for (uint32_t i = levelStart[l - 1]; i < levelStart[l]; i++)
+      worldPosition[i] = worldPosition[i] / static_cast<float>(std::max(childCount[i], 1u));
+  }
+
+  for (size_t i = 0; i < nodeCount; i++) {
+    glm::vec3 parentPosition =
+        parent[i] == NoParent ? glm::vec3(0.0f) : worldPosition[parent[i]];
+    localPosition[i] = worldPosition[i] - parentPosition;
+  }
+  for (size_t i = 0; i < count; i++) {
+    localRotation[leafBegin + i] = scene.rotations[i];
+    localScale[leafBegin + i] = scene.scales[i];
+  }
+}
+
+void TransformHierarchy::Clear() {
+  parent.clear();
+  levelStart.clear();
+  localPosition.clear();
+  localRotation.clear();
+  localScale.clear();
+  world.clear();
+  dirty.clear();
+  updatedStamp.clear();
+  dirtyRanges.clear();
+  leafBegin = 0;
+  lastUpdated = 0;
+}
+
+void TransformHierarchy::SetLocal(uint32_t node, const glm::vec3 &position,
+                                  const glm::vec4 &rotation,
+                                  const glm::vec3 &scale) {
+  localPosition[node] = position;
+  localRotation[node] = rotation;
+  localScale[node] = scale;
+  dirty[node] = 1;
+}
+
+void TransformHierarchy::Animate(float time, float movingFraction) {
+  PROFILE_SCOPE("Hierarchy Animate");
+  if (LevelCount() < 2)
+    return;
+
+  // The level right above the leaves
+  uint32_t begin = levelStart[LevelCount() - 2];
+  uint32_t end = levelStart[LevelCount() - 1];
+  uint64_t threshold = static_cast<uint64_t>(
+      std::clamp(movingFraction, 0.0f, 1.0f) * 4294967296.0);
+
+  for (uint32_t i = begin; i < end; i++) {
+    // Knuth multiplicative hash picks a stable, evenly spread subset
+    uint32_t h = (i - begin) * 2654435761u;
+    if (h >= threshold)
+      continue;
+    float angle = time * (0.5f + static_cast<float>(h >> 8) / 16777216.0f);
+    localRotation[i] =
+        glm::vec4(0.0f, std::sin(angle * 0.5f), 0.0f, std::cos(angle * 0.5f));
+    dirty[i] = 1;
+  }
+}
+
+size_t TransformHierarchy::Update(glm::mat4 *objectWorld) {
+  PROFILE_SCOPE("Hierarchy Update");
+  auto start = std::chrono::steady_clock::now();
+  dirtyRanges.clear();
+
+  // Stamp 0 means "never updated"
+  if (++stamp == 0)
+    stamp = 1;
+
+  std::atomic<size_t> updated{0};
+  // Per-block run lists live in the frame arena
+  LinearArena &arena = FrameArenas::Shared().Local();
+  ArenaVector<LeafRange> *blockRanges = nullptr;
+  size_t blockCount = 0;
+  JobSystem &jobs = JobSystem::Shared();
+
+  for (size_t l = 0; l < LevelCount(); l++) {
+    size_t begin = levelStart[l];
+    size_t end = levelStart[l + 1];
+    bool leaves = begin >= leafBegin;
+    if (leaves) {
+      blockCount = (end - begin + UpdateGrain - 1) / UpdateGrain;
+      blockRanges = arena.AllocateArray<ArenaVector<LeafRange>>(blockCount);
+      for (size_t b = 0; b < blockCount; b++)
+        new (&blockRanges[b]) ArenaVector<LeafRange>(arena, MaxRangesPerBlock);
+    }
+
+    jobs.ParallelFor(end - begin, UpdateGrain, [&](size_t first, size_t last) {
+      size_t count = 0;
+      ArenaVector<LeafRange> *ranges =
+          leaves ? &blockRanges[first / UpdateGrain] : nullptr;
+      for (size_t n = begin + first; n < begin + last; n++) {
+        int32_t p = parent[n];
+        bool parentMoved = p != NoParent && updatedStamp[p] == stamp;
+        if (!dirty[n] && !parentMoved)
+          continue;
+
+        glm::mat4 local =
+            ComposeTransform(localPosition[n], localRotation[n], localScale[n]);
+        glm::mat4 result = p == NoParent ? local : world[p] * local;
+        if (leaves) {
+          size_t leaf = n - leafBegin;
+          objectWorld[leaf] = result;
+          appendRange(*ranges, leaf, leaf + 1);
+        } else {
+          world[n] = result;
+        }
+        dirty[n] = 0;
+        updatedStamp[n] = stamp;
+        count++;
+      }
+      updated.fetch_add(count, std::memory_order_relaxed);
+    });
+  }
+
+  // Blocks are in leaf order; stitch their runs together across boundaries
+  for (size_t b = 0; b < blockCount; b++)
+    for (const LeafRange &range : blockRanges[b])
+      appendRange(dirtyRanges, range.begin, range.end);
+
+  lastUpdated = updated.load(std::memory_order_relaxed);
+  lastUpdateMs = std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  return lastUpdated;
+}
@@ -1,17 +1,56 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <string>
 
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_opengl3.h>
 #include <imgui.h>
 
 #include "core/Camera.h"
+#include "core/FrameContext.h"
+#include "core/SceneData.h"
+#include "core/SceneFile.h"
+#include "core/SceneGenerator.h"
+#include "core/SceneStore.h"
 #include "renderers/BatchRenderer.h"
+#include "renderers/GeometryRenderer.h"
 #include "renderers/IRenderStrategy.h"
 #include "renderers/InstancedRenderer.h"
+#include "renderers/LayeredRenderer.h"
+#include "renderers/MeshletRenderer.h"
 #include "renderers/NaiveRenderer.h"
+#include "renderers/PackedRenderer.h"
+#include "renderers/PullingRenderer.h"
+#include "renderers/SoftwareRenderer.h"
+#include "tools/AssetArchive.h"
+#include "tools/BottleneckClassifier.h"
+#include "tools/AutoStrategy.h"
+#include "tools/CapacitySearch.h"
+#include "tools/EngineConfig.h"
+#include "tools/FrameArena.h"
+#include "tools/FrameReadback.h"
+#include "tools/FrameStats.h"
+#include "tools/GpuResources.h"
+#include "tools/GpuTimer.h"
+#include "tools/JobSystem.h"
+#include "tools/LatencyStats.h"
+#include "tools/MultiView.h"
+#include "tools/OverdrawMeter.h"
+#include "tools/Profiler.h"
+#include "tools/RenderThread.h"
+#include "tools/ScaledTarget.h"
+#include "tools/StrategyStats.h"
+#include "tools/filemanager.h"
 
 // --------------------------------
 // Settings
@@ -32,18 +71,82 @@ bool cursorEnabled = false;
 
 // --------------------------------
 // Forward declarations
-void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 void processInput(GLFWwindow *window);
 void mouse_callback(GLFWwindow *window, double xpos, double ypos);
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
+bool exportResults(const char *path, const char *rendererName, int objectCount,
+                   const FrameStats &stats, const RenderThread &renderThread,
+                   const LatencyStats &latency, const CapacitySearch &capacity,
+                   const BottleneckClassifier &bottleneck,
+                   const StrategyStats &strategies,
+                   const MultiViewCost &multiView,
+                   const AutoStrategy &autoStrategy);
 
 // --------------------------------
 // Main
-int main() {
+int main(int argc, char **argv) {
+  // Command line: --scene <file> streams a saved scene instead of generating
+  // one, --save-scene <file> writes the generated scene out after startup.
+  // --objects, --seed, --distribution <0-4> and --threads drive the generator.
+  // --lights <count> starts with clustered lighting on. --inline-render
+  // draws on the main thread, --snapshots <2-3> sets the pipeline depth.
+  // --frames-in-flight <0-4> caps the GPU queue (0 = driver), --low-latency
+  // drains it every frame. --archive <file> mounts a packed asset archive,
+  // --pack-assets <file> packs the asset directory into one and exits.
+  // --capacity <ms> runs the capacity search over every strategy once the
+  // scene is loaded, writes capacity_results.json and exits.
+  std::string scenePath;
+  std::string saveScenePath;
+  SceneGeneratorSettings sceneSettings;
+  int lightCount = -1;
+  bool renderThreaded = true;
+  int snapshotCount = 2;
+  RenderSettings settings;
+  CapacitySettings capacitySettings;
+  bool capacityOnLaunch = false;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--scene") == 0 && i + 1 < argc)
+      scenePath = argv[++i];
+    else if (std::strcmp(argv[i], "--save-scene") == 0 && i + 1 < argc)
+      saveScenePath = argv[++i];
+    else if (std::strcmp(argv[i], "--objects") == 0 && i + 1 < argc)
+      sceneSettings.objectCount = std::strtoull(argv[++i], nullptr, 10);
+    else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+      sceneSettings.seed = std::strtoull(argv[++i], nullptr, 10);
+    else if (std::strcmp(argv[i], "--distribution") == 0 && i + 1 < argc)
+      sceneSettings.distribution = static_cast<SceneDistribution>(std::clamp(
+          std::atoi(argv[++i]), 0, int(SceneDistribution::Count) - 1));
+    else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+      sceneSettings.threadCount = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--lights") == 0 && i + 1 < argc)
+      lightCount = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--inline-render") == 0)
+      renderThreaded = false;
+    else if (std::strcmp(argv[i], "--snapshots") == 0 && i + 1 < argc)
+      snapshotCount = std::clamp(std::atoi(argv[++i]), 2, RenderThread::MaxSnapshots);
+    else if (std::strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc)
+      settings.framesInFlight =
+          std::clamp(std::atoi(argv[++i]), 0, FramePacer::MaxFramesInFlight);
+    else if (std::strcmp(argv[i], "--low-latency") == 0)
+      settings.lowLatency = true;
+    else if (std::strcmp(argv[i], "--capacity") == 0 && i + 1 < argc) {
+      capacitySettings.budgetMs = std::strtof(argv[++i], nullptr);
+      capacityOnLaunch = true;
+    } else if (std::strcmp(argv[i], "--archive") == 0 && i + 1 < argc)
+      VirtualFileSystem::shared().mountArchive(argv[++i]);
+    else if (std::strcmp(argv[i], "--pack-assets") == 0 && i + 1 < argc)
+      return AssetArchive::Build(argv[++i],
+                                 VirtualFileSystem::shared().baseDirectory())
+                 ? 0
+                 : 1;
+  }
+
   glfwInit();
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
   glfwWindowHint(GLFW_OPENGL_CORE_PROFILE, GL_TRUE);
+  // The overdraw heatmap counts fragments in the stencil buffer
+  glfwWindowHint(GLFW_STENCIL_BITS, 8);
 
   GLFWwindow *window =
       glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "GL-Bench", NULL, NULL);
@@ -53,7 +156,7 @@ int main() {
   }
 
   glfwMakeContextCurrent(window);
-  glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+  PROFILE_THREAD("Main");
   glfwSetCursorPosCallback(window, mouse_callback);
   glfwSetScrollCallback(window, scroll_callback);
   glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -73,79 +176,1032 @@ int main() {
 
   ImGui_ImplGlfw_InitForOpenGL(window, true);
   ImGui_ImplOpenGL3_Init("#version 420 core");
+  // Creates the font texture while the context is still current here; the
+  // render thread only draws
+  ImGui_ImplOpenGL3_NewFrame();
 
   // --------------------------------
   // Renderer Setup
   int currentRendererIndex = 0;
-  const char *rendererNames[] = {"Naive", "Batch", "Instanced"};
+  const char *rendererNames[] = {"Naive",   "Batch",   "Instanced",
+                                 "Software", "Meshlet", "Pulling",
+                                 "Geometry", "Packed"};
 
-  auto createRenderer = [&](int index) -> IRenderStrategy * {
+  auto newRenderer = [](int index) -> IRenderStrategy * {
     if (index == 0)
       return new NaiveRenderer();
     if (index == 1)
       return new BatchRenderer();
     if (index == 2)
       return new InstancedRenderer();
+    if (index == 3)
+      return new SoftwareRenderer();
+    if (index == 4)
+      return new MeshletRenderer();
+    if (index == 5)
+      return new PullingRenderer();
+    if (index == 6)
+      return new GeometryRenderer();
+    if (index == 7)
+      return new PackedRenderer();
     return nullptr;
   };
+  // Stats, timelines, GPU resource tags and leak reports are keyed by
+  // GetName(), so it has to match the name shown for the strategy
+  auto createRenderer = [&](int index) {
+    IRenderStrategy *strategy = newRenderer(index);
+    assert(std::strcmp(strategy->GetName(), rendererNames[index]) == 0 &&
+           "renderer name does not match rendererNames");
+    return strategy;
+  };
+
+  // --------------------------------
+  // Scene: owned here for the whole run and shared by every strategy
+  SceneStore sceneStore;
+  sceneStore.Init();
+  SceneData &scene = sceneStore.Data();
+  SceneStreamer sceneStreamer;
+  double sceneGenerateMs = 0.0;
+  uint64_t sceneHash = 0;
+  if (scenePath.empty() || !sceneStreamer.Start(scenePath, scene))
+    sceneGenerateMs = GenerateScene(scene, sceneSettings);
+  if (!saveScenePath.empty())
+    SceneFile::Save(saveScenePath, scene);
+
+  bool lightingEnabled = lightCount >= 0;
+  if (lightingEnabled)
+    sceneStore.SetLighting(true, lightCount);
+  lightCount = sceneStore.LightCount();
+
+  bool hierarchyEnabled = false;
+  int hierarchyFanout = 16;
+  int hierarchyLevels = 3;
+
+  char scenePathBuffer[256] = "scene.rbscene";
+  if (!scenePath.empty())
+    std::snprintf(scenePathBuffer, sizeof(scenePathBuffer), "%s",
+                  scenePath.c_str());
 
   IRenderStrategy *renderer = createRenderer(currentRendererIndex);
+  renderer->SetScene(&sceneStore);
   renderer->Init();
+  int activeRendererIndex = currentRendererIndex;
 
   int objectCount = 100;
-  bool vsync = false;
+
+  // --------------------------------
+  // Frame statistics
+  FrameStats frameStats;
+  GpuTimer gpuTimer;
+  gpuTimer.Init();
+  // Just the strategy's draws, so shading cost shows apart from the UI
+  GpuTimer sceneTimer;
+  sceneTimer.Init();
+
+  // --------------------------------
+  // Overdraw: submission order, fragment counts and the stencil heatmap
+  OverdrawMeter overdrawMeter;
+  overdrawMeter.Init();
+  Shader &heatmapShader = sceneStore.GetShader("heatmap.vs", "heatmap.fs");
+
+  // Offscreen scene target for render scales below 1
+  ScaledTarget scaledTarget;
+  scaledTarget.Init();
+
+  // Multi-view: cubemap faces into a layered target, drawn either by the
+  // active strategy once per view or by the layered renderer in one pass
+  MultiViewTarget multiViewTarget;
+  multiViewTarget.Init();
+  LayeredRenderer layeredRenderer;
+  layeredRenderer.SetScene(&sceneStore);
+  layeredRenderer.Init();
+
+  // --------------------------------
+  // Frame capture: asynchronous readback, PNG output and golden comparison
+  FrameReadback frameReadback;
+  frameReadback.Init();
+  enum class CaptureMode { None, Save, SaveGolden, Compare };
+  CaptureMode captureRequest = CaptureMode::None;
+  bool hashEveryFrame = false;
+  char captureDir[256] = "captures";
+  char goldenDir[256] = "golden";
+  int goldenTolerance = 2;
+  ReadbackResult lastReadback;
+  bool haveReadback = false;
+
+  // --------------------------------
+  // Render thread. Everything drawFrame touches (strategy, timers, meters,
+  // readback, its own frame arenas) belongs to it once started; the main
+  // thread sees it only through snapshots and the report.
+  RenderThread renderThread;
+  FrameArenas renderArenas(JobSystem::Shared().ThreadCount());
+  bool activeVsync = false;
+
+  auto drawFrame = [&](FrameSnapshot &snapshot, RenderReport &report) {
+    renderArenas.Reset();
+    RenderCounters counters;
+    FrameContext &frame = snapshot.frame;
+    frame.arenas = &renderArenas;
+    frame.stats = &counters;
+    const RenderSettings &settings = snapshot.settings;
+
+    gpuTimer.Begin(frame.frameIndex);
+    glViewport(0, 0, snapshot.windowWidth, snapshot.windowHeight);
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+    for (const auto &command : snapshot.commands)
+      command();
+
+    if (settings.rendererIndex != activeRendererIndex) {
+      // glFinish so the latency includes any GPU work the switch caused
+      PROFILE_SCOPE("Renderer Switch");
+      auto switchStart = std::chrono::steady_clock::now();
+      const char *oldName = renderer->GetName();
+      renderer->Cleanup();
+      delete renderer;
+      // Anything the old strategy created should be gone by now
+      GpuResourceTracker::Get().ReportLeaks(oldName, std::cerr);
+      renderer = createRenderer(settings.rendererIndex);
+      renderer->SetScene(&sceneStore);
+      renderer->Init();
+      glFinish();
+      report.switchMs = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - switchStart)
+                            .count();
+      activeRendererIndex = settings.rendererIndex;
+    }
+    snapshot.timeline.renderer = renderer->GetName();
+    if (settings.vsync != activeVsync) {
+      glfwSwapInterval(settings.vsync ? 1 : 0);
+      activeVsync = settings.vsync;
+    }
+
+    // Send what the main thread's scene update changed
+    sceneStore.SetVertexWork(settings.vertexWork);
+    counters.uploadBytes += sceneStore.Upload();
+
+    if (snapshot.viewCount > 0) {
+      // Multi-view replaces the scene pass: each view goes to a layer of the
+      // multi-view target, which is then tiled onto the window. The depth
+      // pre-pass and overdraw meter only apply to the single view, and the
+      // light clusters are the main view's, so the views draw unlit.
+      int layerSize = settings.multiView.layerSize;
+      for (int v = 0; v < snapshot.viewCount; v++) {
+        snapshot.views[v].arenas = &renderArenas;
+        snapshot.views[v].stats = &counters;
+      }
+      sceneStore.SetUnlit(true);
+      sceneTimer.Begin(frame.frameIndex);
+      auto submitStart = std::chrono::steady_clock::now();
+      if (settings.multiView.mode == MultiViewMode::Layered) {
+        multiViewTarget.BeginLayered(layerSize, snapshot.viewCount);
+        layeredRenderer.Render(snapshot.views, snapshot.viewCount, &counters);
+      } else {
+        for (int v = 0; v < snapshot.viewCount; v++) {
+          multiViewTarget.BeginLayer(layerSize, snapshot.viewCount, v);
+          renderer->Render(snapshot.views[v]);
+        }
+      }
+      counters.submitMs = std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - submitStart)
+                              .count();
+      sceneTimer.End();
+      sceneStore.SetUnlit(false);
+      renderThread.ReleaseScene();
+
+      multiViewTarget.Present(snapshot.windowWidth, snapshot.windowHeight);
+      // The layers stacked, so per-pixel figures divide by all of them
+      report.renderWidth = layerSize;
+      report.renderHeight = layerSize * snapshot.viewCount;
+    } else {
+      // Below render scale 1 the scene goes offscreen; the clear above was
+      // the window's
+      bool scaled = frame.viewportWidth != snapshot.windowWidth ||
+                    frame.viewportHeight != snapshot.windowHeight;
+      if (scaled) {
+        scaledTarget.Begin(frame.viewportWidth, frame.viewportHeight);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+      }
+
+      // Render scene. The software rasterizer has its own depth buffer, so a
+      // GL pre-pass would do nothing for it.
+      sceneTimer.Begin(frame.frameIndex);
+      auto submitStart = std::chrono::steady_clock::now();
+      bool prepass = settings.submission == SubmissionMode::DepthPrepass &&
+                     std::strcmp(renderer->GetName(), "Software") != 0;
+      if (prepass) {
+        PROFILE_SCOPE("Depth Pre-pass");
+        sceneStore.SetDepthOnly(true);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        renderer->Render(frame);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        sceneStore.SetDepthOnly(false);
+        // Only the visible surface of each pixel passes now
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+      }
+      overdrawMeter.Begin(frame.frameIndex, settings.overdrawHeatmap);
+      renderer->Render(frame);
+      overdrawMeter.End();
+      if (prepass) {
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+      }
+      counters.submitMs = std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - submitStart)
+                              .count();
+      sceneTimer.End();
+      // The main thread may update the scene for the next frame from here on
+      renderThread.ReleaseScene();
+
+      if (settings.overdrawHeatmap)
+        overdrawMeter.DrawHeatmap(heatmapShader);
+      if (scaled)
+        scaledTarget.Resolve(snapshot.windowWidth, snapshot.windowHeight);
+      report.renderWidth = frame.viewportWidth;
+      report.renderHeight = frame.viewportHeight;
+    }
+
+    // Captured before the UI is drawn on top
+    if (settings.capture)
+      frameReadback.Capture(frame.frameIndex, snapshot.windowWidth,
+                            snapshot.windowHeight, settings.captureRequest);
+
+    if (ImDrawData *ui = snapshot.ui.Get()) {
+      PROFILE_SCOPE("ImGui Render");
+      ImGui_ImplOpenGL3_RenderDrawData(ui);
+    }
+    gpuTimer.End();
+
+    // Queries from earlier frames; none of these wait on the GPU
+    uint64_t gpuFrame;
+    float gpuMs;
+    while (gpuTimer.Poll(gpuFrame, gpuMs))
+      report.gpuFrames.push_back(
+          {gpuFrame, gpuMs, gpuTimer.LastStartNs(), gpuTimer.LastEndNs()});
+    while (sceneTimer.Poll(gpuFrame, gpuMs))
+      report.sceneGpuMs = gpuMs;
+    uint64_t samplesFrame, samples;
+    while (overdrawMeter.Poll(samplesFrame, samples))
+      report.shadedSamples = samples;
+
+    frameReadback.Poll(frame.frameIndex);
+    ReadbackResult result;
+    while (frameReadback.PopResult(result))
+      report.readbacks.push_back(std::move(result));
+
+    report.rendererName = renderer->GetName();
+    report.rendererIndex = activeRendererIndex;
+    report.multiViewMode = snapshot.viewCount > 0 ? settings.multiView.mode
+                                                  : MultiViewMode::Off;
+    report.viewCount = snapshot.viewCount;
+    report.counters = counters;
+    report.countersFrame = frame.frameIndex;
+    report.objectCount = frame.objectCount;
+    report.readbackInFlight = frameReadback.InFlight();
+    report.readbackQueued = frameReadback.Queued();
+    report.readbackDropped = frameReadback.Dropped();
+    report.arenaUsed = renderArenas.Used();
+    report.arenaCapacity = renderArenas.Capacity();
+  };
+
+  renderThread.Start(window, snapshotCount, renderThreaded, drawFrame);
+  RenderReport renderReport;
+  LatencyStats latencyStats;
+  StrategyStats strategyStats(rendererNames, IM_ARRAYSIZE(rendererNames));
+  MultiViewCost multiViewCost;
+  uint64_t lastCountersFrame = 0;
+
+  // Capacity search: overrides the object count and strategy while running
+  CapacitySearch capacitySearch;
+  bool capacityStrategies[IM_ARRAYSIZE(rendererNames)] = {
+      true, true, true, true, true, true, true, true};
+  bool capacityExitWhenDone = capacityOnLaunch;
+  auto startCapacitySearch = [&] {
+    std::vector<int> selected;
+    for (int s = 0; s < IM_ARRAYSIZE(rendererNames); s++) {
+      if (capacityStrategies[s])
+        selected.push_back(s);
+    }
+    capacitySearch.Start(capacitySettings, selected, rendererNames,
+                         static_cast<int>(scene.Size()));
+    frameStats.Annotate("capacity search");
+  };
+
+  // Bottleneck classifier: overrides the strategy, object count, render
+  // scale and vertex work while running
+  BottleneckClassifier bottleneckClassifier;
+  BottleneckSettings bottleneckSettings;
+  bool bottleneckStrategies[IM_ARRAYSIZE(rendererNames)] = {
+      true, true, true, true, true, true, true, true};
+
+  // Auto strategy: picks the renderer while running; paused while the
+  // capacity search or the bottleneck classifier own it. Software and
+  // Meshlet are off by default: Meshlet draws a sphere of ~9k triangles per
+  // object, not the cube, so its cost per object is not comparable
+  AutoStrategy autoStrategy;
+  AutoStrategySettings autoSettings;
+  bool autoStrategies[IM_ARRAYSIZE(rendererNames)] = {
+      true, true, true, false, false, true, true, true};
+  auto startAutoStrategy = [&] {
+    std::vector<int> selected;
+    for (int s = 0; s < IM_ARRAYSIZE(rendererNames); s++) {
+      if (autoStrategies[s])
+        selected.push_back(s);
+    }
+    autoStrategy.Start(autoSettings, selected, rendererNames, currentRendererIndex,
+                       objectCount);
+    frameStats.Annotate("auto strategy");
+  };
+  bool restartRenderThread = false;
 
   // --------------------------------
   // Render Loop
   while (!glfwWindowShouldClose(window)) {
+    frameStats.BeginFrame();
+    Profiler::Get().BeginFrame(frameStats.FrameIndex());
+    // Only the main thread allocates from the shared arenas
+    FrameArenas::Shared().Reset();
+
     float currentFrame = glfwGetTime();
     deltaTime = currentFrame - lastFrame;
     lastFrame = currentFrame;
 
+    // The search measures whole frames, so it sees the previous one here
+    if (capacityOnLaunch && scene.ReadyCount() == scene.Size()) {
+      startCapacitySearch();
+      capacityOnLaunch = false;
+    }
+    if (capacitySearch.Running()) {
+      capacitySearch.Update(deltaTime * 1000.0f);
+      if (capacitySearch.Running()) {
+        if (capacitySearch.Strategy() != currentRendererIndex) {
+          currentRendererIndex = capacitySearch.Strategy();
+          frameStats.Annotate("renderer switch");
+        } else if (capacitySearch.Count() != objectCount) {
+          frameStats.Annotate("capacity step");
+        }
+        objectCount = capacitySearch.Count();
+      } else {
+        capacitySearch.Export("capacity_results.json");
+        if (capacityExitWhenDone)
+          glfwSetWindowShouldClose(window, true);
+      }
+    }
+    if (bottleneckClassifier.Running()) {
+      // The report is a frame behind the frame time, which the warm-up hides
+      bottleneckClassifier.Update(deltaTime * 1000.0f,
+                                  float(renderReport.counters.submitMs),
+                                  renderReport.sceneGpuMs);
+      if (bottleneckClassifier.Strategy() != currentRendererIndex) {
+        currentRendererIndex = bottleneckClassifier.Strategy();
+        frameStats.Annotate("renderer switch");
+      }
+      // Back to the analysed count once it finishes
+      objectCount = bottleneckClassifier.Count();
+    }
+
+    // Input is sampled here; in low latency mode the previous frame has
+    // already left the GPU
+    glfwPollEvents();
     processInput(window);
+    uint64_t inputNs = Profiler::Now();
 
-    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // Whatever the render thread finished since last frame
+    renderThread.TakeReport(renderReport);
+    for (const RenderReport::GpuFrame &gpu : renderReport.gpuFrames) {
+      frameStats.SetGpuTime(gpu.frame, gpu.ms);
+      Profiler::Get().RecordGpu(gpu.frame, gpu.startNs, gpu.endNs);
+    }
+    for (ReadbackResult &result : renderReport.readbacks) {
+      lastReadback = std::move(result);
+      haveReadback = true;
+    }
+    for (const FrameTimeline &timeline : renderReport.timelines)
+      latencyStats.Add(timeline);
+    latencyStats.Update();
+    // The report repeats its counters until the render thread draws again
+    if (renderReport.countersFrame != lastCountersFrame) {
+      if (renderReport.viewCount > 0)
+        multiViewCost.Add(renderReport.multiViewMode, renderReport.viewCount,
+                          renderReport.counters, renderReport.sceneGpuMs);
+      else
+        strategyStats.Add(renderReport.rendererIndex, renderReport.counters,
+                          deltaTime * 1000.0f, renderReport.sceneGpuMs);
+      if (autoStrategy.Running() && renderReport.viewCount == 0 &&
+          !capacitySearch.Running() && !bottleneckClassifier.Running())
+        autoStrategy.Update(renderReport.countersFrame, renderReport.rendererIndex,
+                            static_cast<int>(renderReport.objectCount),
+                            renderReport.counters.submitMs, renderReport.sceneGpuMs);
+      lastCountersFrame = renderReport.countersFrame;
+    }
+    if (autoStrategy.Running() && !capacitySearch.Running() &&
+        !bottleneckClassifier.Running() &&
+        autoStrategy.Strategy() != currentRendererIndex) {
+      currentRendererIndex = autoStrategy.Strategy();
+      frameStats.Annotate("auto switch");
+    }
+
+    // Camera matrices and frustum once per frame; the scene update and the
+    // strategies read them from here
+    FrameSnapshot &snapshot = renderThread.Acquire();
+    int framebufferWidth, framebufferHeight;
+    UpdateFramebufferSize(window, framebufferWidth, framebufferHeight);
+    FrameContext &frame = snapshot.frame;
+    frame = FrameContext::FromCamera(camera, framebufferWidth, framebufferHeight);
+    float renderScale = bottleneckClassifier.Running()
+                            ? bottleneckClassifier.RenderScale()
+                            : settings.renderScale;
+    if (renderScale < 1.0f) {
+      // Same projection, fewer pixels
+      frame.viewportWidth = ScaledTarget::ScaledSize(framebufferWidth, renderScale);
+      frame.viewportHeight = ScaledTarget::ScaledSize(framebufferHeight, renderScale);
+    }
+    snapshot.windowWidth = framebufferWidth;
+    snapshot.windowHeight = framebufferHeight;
+    frame.time = currentFrame;
+    frame.deltaTime = deltaTime;
+    frame.frameIndex = frameStats.FrameIndex();
+    frame.objectCount = static_cast<size_t>(objectCount);
+    snapshot.timeline = FrameTimeline{};
+    snapshot.timeline.frame = frame.frameIndex;
+    snapshot.timeline.inputNs = inputNs;
+    snapshot.viewCount = 0;
+    if (settings.multiView.mode != MultiViewMode::Off) {
+      snapshot.viewCount = settings.multiView.viewCount;
+      BuildCubeViews(frame, snapshot.viewCount, settings.multiView.layerSize,
+                     snapshot.views);
+    }
+
+    // The render thread is done with the scene store until Submit
+    renderThread.WaitForScene();
 
-    // Render scene
-    renderer->Render(objectCount, camera, window);
+    // Compose, animate, sort and bin on this thread; the render thread
+    // uploads the result
+    sceneStore.SetFrontToBack(settings.submission == SubmissionMode::FrontToBack);
+    sceneStore.Update(frame);
 
     // ImGui Frame
-    ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
     ImGui::Begin("Benchmark");
 
-    ImGui::SliderInt("Object Count", &objectCount, 1, 50000);
+    int maxObjects = static_cast<int>(std::max<size_t>(scene.Size(), 1));
+    ImGui::SliderInt("Object Count", &objectCount, 1, maxObjects);
 
+    // The render thread swaps strategies when it draws this frame
+    ImGui::BeginDisabled(autoStrategy.Running());
     if (ImGui::Combo("Renderer", &currentRendererIndex, rendererNames,
-                     IM_ARRAYSIZE(rendererNames))) {
-      renderer->Cleanup();
-      delete renderer;
-      renderer = createRenderer(currentRendererIndex);
-      renderer->Init();
+                     IM_ARRAYSIZE(rendererNames)))
+      frameStats.Annotate("renderer switch");
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    bool autoRunning = autoStrategy.Running();
+    if (ImGui::Checkbox("Auto", &autoRunning)) {
+      if (autoRunning)
+        startAutoStrategy();
+      else
+        autoStrategy.Stop();
     }
+    ImGui::Text("Last switch: %.3f ms", renderReport.switchMs);
 
-    if (ImGui::Checkbox("VSync", &vsync)) {
-      glfwSwapInterval(vsync ? 1 : 0);
-    }
+    ImGui::Checkbox("VSync", &settings.vsync);
+
+    ImGui::Separator();
+    ImGui::SliderFloat("Render Scale", &settings.renderScale, 0.25f, 1.0f, "%.2f");
 
     ImGui::Separator();
     ImGui::Text("FPS: %.1f", 1.0f / deltaTime);
     ImGui::Text("Frame Time: %.3f ms", deltaTime * 1000.0f);
+    ImGui::Text("Submit CPU: %.3f ms, scene GPU: %.3f ms at %dx%d",
+                renderReport.counters.submitMs, renderReport.sceneGpuMs,
+                renderReport.renderWidth, renderReport.renderHeight);
+    if (bottleneckClassifier.Running())
+      ImGui::Text("Bottleneck: analysing (%s)", bottleneckClassifier.Phase());
+    else if (const BottleneckResult *result =
+                 bottleneckClassifier.Latest(rendererNames[currentRendererIndex]))
+      ImGui::Text("Bottleneck: %s (%d objects at %dx%d)",
+                  BottleneckName(result->label), result->objectCount,
+                  result->width, result->height);
+    else
+      ImGui::TextDisabled("Bottleneck: not analysed");
+
+    if (ImGui::CollapsingHeader("Scene")) {
+      ImGui::Text("Objects: %zu / %zu ready", scene.ReadyCount(), scene.Size());
+      ImGui::Text("GPU mirror: %zu objects, %.1f MB (v%llu), sync %.3f ms",
+                  sceneStore.GpuCount(), sceneStore.GpuBytes() / (1024.0 * 1024.0),
+                  static_cast<unsigned long long>(sceneStore.Version()),
+                  sceneStore.lastUpdateMs);
+      const TextureBatcher &textures = sceneStore.Textures();
+      ImGui::Text("Textures: %zu slots in %zu layers of %dpx (%zu atlas packed), %.1f MB",
+                  textures.SlotCount(), textures.LayerCount(),
+                  textures.LayerSize(), textures.AtlasPackedCount(),
+                  textures.GpuBytes() / (1024.0 * 1024.0));
+      int textureCount = sceneStore.TextureCount();
+      if (ImGui::InputInt("Texture Count", &textureCount, 16, 128,
+                          ImGuiInputTextFlags_EnterReturnsTrue)) {
+        textureCount = std::clamp(textureCount, 1, 4096);
+        snapshot.commands.push_back(
+            [&sceneStore, textureCount] { sceneStore.SetTextureCount(textureCount); });
+        frameStats.Annotate("texture rebuild");
+      }
+      ImGui::Text("Material table: %zu / %zu records",
+                  sceneStore.Materials().Count(), MaterialTable::MaxMaterials);
+      int materialCount = sceneStore.MaterialCount();
+      if (ImGui::InputInt("Material Count", &materialCount, 16, 128,
+                          ImGuiInputTextFlags_EnterReturnsTrue)) {
+        snapshot.commands.push_back([&sceneStore, materialCount] {
+          sceneStore.SetMaterialCount(materialCount);
+        });
+        frameStats.Annotate("material rebuild");
+      }
+      if (sceneStreamer.IsStreaming())
+        ImGui::ProgressBar(sceneStreamer.Progress(), ImVec2(-1, 0), "Streaming");
+      else if (sceneStreamer.ElapsedMs() > 0.0)
+        ImGui::Text("Last stream: %.1f ms", sceneStreamer.ElapsedMs());
+
+      ImGui::InputText("Scene File", scenePathBuffer, sizeof(scenePathBuffer));
+      if (ImGui::Button("Save Scene"))
+        SceneFile::Save(scenePathBuffer, scene);
+      ImGui::SameLine();
+      if (ImGui::Button("Load Scene")) {
+        // Stop first: the streamer writes into the arrays being replaced
+        sceneStreamer.Stop();
+        if (!sceneStreamer.Start(scenePathBuffer, scene))
+          sceneGenerateMs = GenerateScene(scene, sceneSettings);
+        sceneStore.Invalidate();
+        frameStats.Annotate("scene load");
+      }
+
+      ImGui::Separator();
+      int distribution = static_cast<int>(sceneSettings.distribution);
+      if (ImGui::BeginCombo("Distribution",
+                            SceneDistributionName(sceneSettings.distribution))) {
+        for (int d = 0; d < static_cast<int>(SceneDistribution::Count); d++) {
+          if (ImGui::Selectable(
+                  SceneDistributionName(static_cast<SceneDistribution>(d)),
+                  d == distribution))
+            sceneSettings.distribution = static_cast<SceneDistribution>(d);
+        }
+        ImGui::EndCombo();
+      }
+
+      int generateCount = static_cast<int>(sceneSettings.objectCount);
+      if (ImGui::InputInt("Generate Count", &generateCount, 10000, 100000))
+        sceneSettings.objectCount = static_cast<size_t>(std::max(generateCount, 1));
+      int seed = static_cast<int>(sceneSettings.seed);
+      if (ImGui::InputInt("Seed", &seed))
+        sceneSettings.seed = static_cast<uint64_t>(seed);
+      if (sceneSettings.distribution == SceneDistribution::Clustered) {
+        ImGui::SliderInt("Clusters", &sceneSettings.clusterCount, 1, 256);
+        ImGui::SliderFloat("Cluster Radius", &sceneSettings.clusterRadius, 0.1f,
+                           5.0f);
+      }
+      int materials = static_cast<int>(sceneSettings.materialCount);
+      if (ImGui::SliderInt("Materials", &materials, 1, 4096))
+        sceneSettings.materialCount = static_cast<uint32_t>(materials);
+      ImGui::SliderInt("Threads (0 = auto)", &sceneSettings.threadCount, 0, 64);
+
+      if (ImGui::Button("Regenerate")) {
+        sceneStreamer.Stop();
+        sceneGenerateMs = GenerateScene(scene, sceneSettings);
+        sceneStore.Invalidate();
+        sceneHash = 0;
+        frameStats.Annotate("scene regenerate");
+      }
+      ImGui::SameLine();
+      if (ImGui::Button("Hash"))
+        sceneHash = HashSceneData(scene);
+      ImGui::Text("Generated in %.2f ms", sceneGenerateMs);
+      if (sceneHash != 0)
+        ImGui::Text("Scene hash: %016llx",
+                    static_cast<unsigned long long>(sceneHash));
+    }
+
+    if (ImGui::CollapsingHeader("Lighting")) {
+      bool changed = ImGui::Checkbox("Clustered Lighting", &lightingEnabled);
+      changed |= ImGui::SliderInt("Light Count", &lightCount, 0,
+                                  static_cast<int>(ClusteredLights::MaxLights),
+                                  "%d", ImGuiSliderFlags_Logarithmic);
+      if (changed) {
+        sceneStore.SetLighting(lightingEnabled, lightCount);
+        frameStats.Annotate("lighting change");
+      }
+      ImGui::SliderFloat("Light Radius", &sceneStore.lightRadiusScale, 0.25f,
+                         4.0f);
+
+      const ClusteredLights &lights = sceneStore.Lights();
+      if (lightingEnabled && lights.Count() > 0) {
+        ImGui::Text("Clusters: %dx%dx%d, %zu / %zu lights visible",
+                    ClusteredLights::ClustersX, ClusteredLights::ClustersY,
+                    ClusteredLights::ClustersZ, lights.lastVisible, lights.Count());
+        ImGui::Text("Light references: %zu (max %u per cluster)",
+                    lights.lastIndexCount, lights.lastMaxPerCluster);
+        if (lights.lastOverflow > 0)
+          ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.3f, 1.0f),
+                             "Index list full: %zu references dropped",
+                             lights.lastOverflow);
+        ImGui::Text("Assignment (CPU): %.3f ms, upload %.3f ms",
+                    lights.lastAssignMs, lights.lastUploadMs);
+      } else if (lightingEnabled) {
+        ImGui::TextUnformatted("Waiting for the scene to finish loading");
+      }
+      ImGui::Text("Scene draw (GPU): %.3f ms%s", renderReport.sceneGpuMs,
+                  lightingEnabled && settings.multiView.mode == MultiViewMode::Off
+                      ? " with shading"
+                      : "");
+      if (lightingEnabled && std::strcmp(rendererNames[currentRendererIndex],
+                                         "Software") == 0)
+        ImGui::TextUnformatted("The software rasterizer draws unlit");
+      if (lightingEnabled && settings.multiView.mode != MultiViewMode::Off)
+        ImGui::TextUnformatted("Multi-view draws unlit; clusters follow the main view");
+    }
+
+    if (ImGui::CollapsingHeader("Overdraw")) {
+      int mode = static_cast<int>(settings.submission);
+      if (ImGui::BeginCombo("Submission", SubmissionModeName(settings.submission))) {
+        for (int m = 0; m < static_cast<int>(SubmissionMode::Count); m++) {
+          if (ImGui::Selectable(SubmissionModeName(static_cast<SubmissionMode>(m)),
+                                m == mode)) {
+            settings.submission = static_cast<SubmissionMode>(m);
+            frameStats.Annotate(SubmissionModeName(settings.submission));
+          }
+        }
+        ImGui::EndCombo();
+      }
+      ImGui::Checkbox("Heatmap", &settings.overdrawHeatmap);
+
+      // The scene's own resolution, which the render scale may have reduced
+      double pixels =
+          std::max(1.0, double(renderReport.renderWidth) * renderReport.renderHeight);
+      ImGui::Text("Shaded fragments: %.2f M, %.2f layers per pixel",
+                  renderReport.shadedSamples / 1.0e6,
+                  renderReport.shadedSamples / pixels);
+      ImGui::Text("Scene draw (GPU): %.3f ms", renderReport.sceneGpuMs);
+      if (settings.submission == SubmissionMode::FrontToBack)
+        ImGui::Text("Sort: %.3f ms for %zu objects", sceneStore.lastSortMs,
+                    sceneStore.DrawOrder().size());
+      if (std::strcmp(rendererNames[currentRendererIndex], "Software") == 0)
+        ImGui::TextUnformatted("The software rasterizer is not measured");
+
+      if (settings.overdrawHeatmap) {
+        for (int level = 1; level <= OverdrawMeter::HeatLevels; level++) {
+          glm::vec4 c = OverdrawMeter::HeatColor(level);
+          char label[16];
+          std::snprintf(label, sizeof(label), level == OverdrawMeter::HeatLevels
+                                                  ? "%d+" : "%d", level);
+          ImGui::ColorButton(label, ImVec4(c.x, c.y, c.z, c.w),
+                             ImGuiColorEditFlags_NoTooltip, ImVec2(18, 18));
+          if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("%s layers", label);
+          if (level < OverdrawMeter::HeatLevels)
+            ImGui::SameLine(0.0f, 2.0f);
+        }
+      }
+    }
+
+    if (ImGui::CollapsingHeader("Hierarchy")) {
+      bool changed = ImGui::Checkbox("Parent Objects", &hierarchyEnabled);
+      changed |= ImGui::SliderInt("Fanout", &hierarchyFanout, 2, 64);
+      changed |= ImGui::SliderInt("Pivot Levels", &hierarchyLevels, 1, 8);
+      if (changed) {
+        sceneStore.SetHierarchy(hierarchyEnabled, hierarchyFanout,
+                                hierarchyLevels);
+        frameStats.Annotate("hierarchy rebuild");
+      }
+      ImGui::SliderFloat("Moving Pivots", &sceneStore.hierarchyMovingFraction,
+                         0.0f, 1.0f);
+
+      const TransformHierarchy &hierarchy = sceneStore.Hierarchy();
+      if (hierarchyEnabled && !hierarchy.Empty()) {
+        ImGui::Text("Nodes: %zu (%zu leaves, %zu levels)", hierarchy.NodeCount(),
+                    hierarchy.LeafCount(), hierarchy.LevelCount());
+        ImGui::Text("Updated: %zu nodes (%.1f%%) in %.3f ms on %d threads",
+                    hierarchy.lastUpdated,
+                    100.0 * hierarchy.lastUpdated / hierarchy.NodeCount(),
+                    hierarchy.lastUpdateMs, JobSystem::Shared().ThreadCount());
+        ImGui::Text("Uploaded: %.1f KB in %zu ranges",
+                    sceneStore.lastUploadBytes / 1024.0,
+                    hierarchy.DirtyLeafRanges().size());
+      } else if (hierarchyEnabled) {
+        ImGui::TextUnformatted("Waiting for the scene to finish loading");
+      }
+    }
+
+    if (ImGui::CollapsingHeader("Frame Statistics",
+                                ImGuiTreeNodeFlags_DefaultOpen)) {
+      frameStats.DrawImGui();
+      ImGui::Text("Frame arenas: %.2f / %.2f MB main, %.2f / %.2f MB render",
+                  FrameArenas::Shared().Used() / (1024.0 * 1024.0),
+                  FrameArenas::Shared().Capacity() / (1024.0 * 1024.0),
+                  renderReport.arenaUsed / (1024.0 * 1024.0),
+                  renderReport.arenaCapacity / (1024.0 * 1024.0));
+      ImGui::Text("Submitted: %llu draws, %llu instances, %llu triangles",
+                  (unsigned long long)renderReport.counters.drawCalls,
+                  (unsigned long long)renderReport.counters.instances,
+                  (unsigned long long)renderReport.counters.triangles);
+      if (uint64_t total = renderReport.counters.sceneTriangles)
+        ImGui::Text("Cluster culling: %llu of %llu triangles (%.1f%%)",
+                    (unsigned long long)renderReport.counters.triangles,
+                    (unsigned long long)total,
+                    100.0 * renderReport.counters.triangles / total);
+    }
+
+    if (ImGui::CollapsingHeader("Strategy Statistics")) {
+      ImGui::Text("Per-frame averages over each strategy's last %d frames",
+                  StrategyStats::Window);
+      strategyStats.DrawImGui();
+      if (ImGui::Button("Reset Statistics"))
+        strategyStats.Reset();
+    }
+
+    if (ImGui::CollapsingHeader("Auto Strategy")) {
+      ImGui::PushID("Auto");
+      ImGui::SliderFloat("Hysteresis", &autoSettings.hysteresis, 0.0f, 0.5f, "%.2f");
+      ImGui::SliderInt("Min Dwell Frames", &autoSettings.minDwellFrames, 0, 600);
+      ImGui::SliderFloat("Workload Change", &autoSettings.workloadChange, 0.05f,
+                         1.0f, "%.2f");
+      ImGui::SliderInt("Review Frames", &autoSettings.reviewFrames, 30, 1200);
+      ImGui::SliderInt("Explore Frames", &autoSettings.exploreFrames, 8, 240);
+      for (int s = 0; s < IM_ARRAYSIZE(rendererNames); s++) {
+        if (s % 4 != 0)
+          ImGui::SameLine();
+        ImGui::Checkbox(rendererNames[s], &autoStrategies[s]);
+      }
+      ImGui::TextDisabled("Settings and candidates apply when Auto starts");
+      if (autoStrategy.Running() &&
+          (capacitySearch.Running() || bottleneckClassifier.Running()))
+        ImGui::TextDisabled("Paused while another tool picks the renderer");
+      autoStrategy.DrawImGui();
+      ImGui::PopID();
+    }
+
+    if (ImGui::CollapsingHeader("Capacity")) {
+      ImGui::SliderFloat("Budget (ms)", &capacitySettings.budgetMs, 2.0f, 50.0f,
+                         "%.1f");
+      ImGui::SameLine();
+      if (ImGui::SmallButton("60 Hz"))
+        capacitySettings.budgetMs = 16.6f;
+      ImGui::SameLine();
+      if (ImGui::SmallButton("120 Hz"))
+        capacitySettings.budgetMs = 8.3f;
+      ImGui::RadioButton("p50", &capacitySettings.percentile, 50);
+      ImGui::SameLine();
+      ImGui::RadioButton("p95", &capacitySettings.percentile, 95);
+      ImGui::SameLine();
+      ImGui::RadioButton("p99", &capacitySettings.percentile, 99);
+      ImGui::SliderInt("Warm-up Frames", &capacitySettings.warmupFrames, 0, 240);
+      ImGui::SliderInt("Measure Frames", &capacitySettings.measureFrames, 30, 600);
+      for (int s = 0; s < IM_ARRAYSIZE(rendererNames); s++) {
+        if (s % 4 != 0)
+          ImGui::SameLine();
+        ImGui::Checkbox(rendererNames[s], &capacityStrategies[s]);
+      }
+      if (settings.vsync)
+        ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.3f, 1.0f),
+                           "VSync caps the frame time; turn it off first");
+
+      if (!capacitySearch.Running()) {
+        ImGui::BeginDisabled(bottleneckClassifier.Running());
+        if (ImGui::Button("Start Search"))
+          startCapacitySearch();
+        ImGui::EndDisabled();
+      } else {
+        if (ImGui::Button("Stop Search"))
+          capacitySearch.Stop();
+        ImGui::SameLine();
+        ImGui::Text("%s: %s at %d objects", capacitySearch.Phase(),
+                    rendererNames[capacitySearch.Strategy()],
+                    capacitySearch.Count());
+        ImGui::ProgressBar(capacitySearch.Progress(), ImVec2(-1, 0));
+      }
+      capacitySearch.DrawImGui();
+      if (!capacitySearch.Results().empty() && ImGui::Button("Export Capacity"))
+        capacitySearch.Export("capacity_results.json");
+    }
+
+    if (ImGui::CollapsingHeader("Bottleneck")) {
+      ImGui::PushID("Bottleneck");
+      ImGui::SliderFloat("Low Render Scale", &bottleneckSettings.lowScale, 0.25f,
+                         0.75f, "%.2f");
+      ImGui::SliderInt("Vertex Work", &bottleneckSettings.vertexWork, 1, 64);
+      ImGui::SliderFloat("Object Fraction", &bottleneckSettings.countFraction,
+                         0.1f, 0.9f, "%.2f");
+      ImGui::SliderInt("Warm-up Frames", &bottleneckSettings.warmupFrames, 0, 240);
+      ImGui::SliderInt("Measure Frames", &bottleneckSettings.measureFrames, 30, 600);
+      for (int s = 0; s < IM_ARRAYSIZE(rendererNames); s++) {
+        if (s % 4 != 0)
+          ImGui::SameLine();
+        ImGui::Checkbox(rendererNames[s], &bottleneckStrategies[s]);
+      }
+
+      if (!bottleneckClassifier.Running()) {
+        ImGui::BeginDisabled(capacitySearch.Running());
+        if (ImGui::Button("Analyse")) {
+          std::vector<int> selected;
+          for (int s = 0; s < IM_ARRAYSIZE(rendererNames); s++) {
+            if (bottleneckStrategies[s])
+              selected.push_back(s);
+          }
+          bottleneckClassifier.Start(bottleneckSettings, selected, rendererNames,
+                                     objectCount, framebufferWidth,
+                                     framebufferHeight);
+          frameStats.Annotate("bottleneck analysis");
+        }
+        ImGui::EndDisabled();
+      } else {
+        if (ImGui::Button("Stop Analysis")) {
+          bottleneckClassifier.Stop();
+          objectCount = bottleneckClassifier.Count();
+        }
+        ImGui::SameLine();
+        ImGui::Text("%s: %s", bottleneckClassifier.Phase(),
+                    rendererNames[bottleneckClassifier.Strategy()]);
+        ImGui::ProgressBar(bottleneckClassifier.Progress(), ImVec2(-1, 0));
+      }
+      bottleneckClassifier.DrawImGui();
+      ImGui::PopID();
+    }
+
+    if (ImGui::CollapsingHeader("Multi-View")) {
+      int mode = static_cast<int>(settings.multiView.mode);
+      if (ImGui::BeginCombo("Mode", MultiViewModeName(settings.multiView.mode))) {
+        for (int m = 0; m < static_cast<int>(MultiViewMode::Count); m++) {
+          if (ImGui::Selectable(MultiViewModeName(static_cast<MultiViewMode>(m)),
+                                m == mode)) {
+            settings.multiView.mode = static_cast<MultiViewMode>(m);
+            frameStats.Annotate(MultiViewModeName(settings.multiView.mode));
+          }
+        }
+        ImGui::EndCombo();
+      }
+      if (ImGui::SliderInt("Views", &settings.multiView.viewCount, 1,
+                           MultiViewSettings::MaxViews))
+        frameStats.Annotate("view count change");
+      ImGui::SliderInt("Layer Size", &settings.multiView.layerSize, 128, 2048);
+      ImGui::TextUnformatted("Cubemap faces around the camera, +X first");
+      if (settings.multiView.mode == MultiViewMode::Repeat)
+        ImGui::Text("Repeating %s once per view",
+                    rendererNames[currentRendererIndex]);
+      if (lightingEnabled)
+        ImGui::TextUnformatted("Views draw unlit; the light clusters are built "
+                               "for the main view only");
+      multiViewCost.DrawImGui();
+    }
+
+    if (ImGui::CollapsingHeader("Latency")) {
+      if (ImGui::SliderInt("Frames In Flight", &settings.framesInFlight, 0,
+                           FramePacer::MaxFramesInFlight,
+                           settings.framesInFlight == 0 ? "driver" : "%d"))
+        frameStats.Annotate("frames in flight change");
+      if (ImGui::Checkbox("Low Latency", &settings.lowLatency))
+        frameStats.Annotate("low latency toggle");
+      ImGui::Text("GPU queue: %zu frames, last wait %.3f ms",
+                  renderReport.gpuFramesInFlight, renderReport.gpuWaitMs);
+      latencyStats.DrawImGui();
+      if (ImGui::Button("Reset Latency"))
+        latencyStats.Reset();
+    }
+
+    if (ImGui::CollapsingHeader("Threading")) {
+      bool threaded = renderThreaded;
+      if (ImGui::Checkbox("Render Thread", &threaded)) {
+        renderThreaded = threaded;
+        restartRenderThread = true;
+      }
+      if (ImGui::SliderInt("Snapshots", &snapshotCount, 2,
+                           RenderThread::MaxSnapshots))
+        restartRenderThread = true;
+
+      const ThreadLoad &load = renderThread.Load();
+      ImGui::Text("Frame: %.3f ms", load.frameMs);
+      ImGui::Text("Main:   %.3f ms busy, %.3f ms idle", load.mainBusyMs,
+                  load.mainIdleMs);
+      ImGui::Text("Render: %.3f ms busy, %.3f ms idle", load.renderBusyMs,
+                  load.renderIdleMs);
+      ImGui::Text("Overlap: %.3f ms (%.0f%% of the frame)", load.overlapMs,
+                  100.0 * load.overlapMs / std::max(load.frameMs, 1e-6));
+      if (!renderThread.Threaded())
+        ImGui::TextUnformatted("Inline: render work runs on the main thread");
+    }
+
+    if (ImGui::CollapsingHeader("Profiler")) {
+      Profiler::Get().DrawImGui();
+    }
+
+    if (ImGui::CollapsingHeader("GPU Resources")) {
+      GpuResourceTracker::Get().DrawImGui();
+    }
+
+    if (ImGui::CollapsingHeader("Frame Capture")) {
+      ImGui::InputText("Capture Dir", captureDir, sizeof(captureDir));
+      ImGui::InputText("Golden Dir", goldenDir, sizeof(goldenDir));
+      ImGui::SliderInt("Tolerance", &goldenTolerance, 0, 32);
+      if (ImGui::Button("Capture")) {
+        std::filesystem::create_directories(captureDir);
+        captureRequest = CaptureMode::Save;
+      }
+      ImGui::SameLine();
+      if (ImGui::Button("Save Golden")) {
+        std::filesystem::create_directories(goldenDir);
+        captureRequest = CaptureMode::SaveGolden;
+      }
+      ImGui::SameLine();
+      if (ImGui::Button("Compare Golden"))
+        captureRequest = CaptureMode::Compare;
+      ImGui::Checkbox("Hash Every Frame", &hashEveryFrame);
+
+      ImGui::Text("In flight: %zu, queued: %zu, dropped: %zu",
+                  renderReport.readbackInFlight, renderReport.readbackQueued,
+                  renderReport.readbackDropped);
+      if (haveReadback) {
+        ImGui::Text("Frame %llu (%s) %dx%d, %.0f frames late",
+                    static_cast<unsigned long long>(lastReadback.frame),
+                    lastReadback.label.c_str(), lastReadback.width,
+                    lastReadback.height, lastReadback.latencyFrames);
+        ImGui::Text("Hash: %016llx",
+                    static_cast<unsigned long long>(lastReadback.hash));
+        if (lastReadback.compared)
+          ImGui::Text("Golden: %s, %zu pixels differ (max delta %d)",
+                      lastReadback.matched ? "match" : "MISMATCH",
+                      lastReadback.differingPixels, lastReadback.maxDelta);
+      }
+    }
+
+    if (ImGui::Button("Export Results")) {
+      exportResults("benchmark_results.json", rendererNames[currentRendererIndex],
+                    objectCount, frameStats, renderThread, latencyStats,
+                    capacitySearch, bottleneckClassifier, strategyStats,
+                    multiViewCost, autoStrategy);
+    }
 
     ImGui::End();
 
-    ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    {
+      PROFILE_SCOPE("ImGui Build");
+      ImGui::Render();
+      snapshot.ui.Capture(ImGui::GetDrawData());
+    }
 
-    glfwSwapBuffers(window);
-    glfwPollEvents();
+    settings.rendererIndex = currentRendererIndex;
+    settings.capture = captureRequest != CaptureMode::None || hashEveryFrame;
+    if (settings.capture) {
+      const char *name = rendererNames[currentRendererIndex];
+      ReadbackRequest &request = settings.captureRequest;
+      request = ReadbackRequest{};
+      request.label = name;
+      request.tolerance = goldenTolerance;
+      std::string goldenPath = std::string(goldenDir) + "/" + name + ".png";
+      if (captureRequest == CaptureMode::Save)
+        request.savePath = std::string(captureDir) + "/" + name + "_" +
+                           std::to_string(frameStats.FrameIndex()) + ".png";
+      else if (captureRequest == CaptureMode::SaveGolden)
+        request.savePath = goldenPath;
+      else if (captureRequest == CaptureMode::Compare)
+        request.goldenPath = goldenPath;
+      captureRequest = CaptureMode::None;
+    }
+    snapshot.settings = settings;
+    snapshot.settings.renderScale = renderScale;
+    if (bottleneckClassifier.Running()) {
+      snapshot.settings.vertexWork = bottleneckClassifier.VertexWork();
+      // Vsync would hide every change in frame time
+      snapshot.settings.vsync = false;
+    }
+
+    renderThread.Submit();
+    frameStats.EndSubmit();
+    // Threaded, waits for a free snapshot; inline, presents
+    renderThread.EndFrame();
+    frameStats.EndFrame();
+    renderThread.SampleLoad();
+
+    if (restartRenderThread) {
+      // Stop drains the pipeline, so nothing submitted is lost
+      renderThread.Start(window, snapshotCount, renderThreaded, drawFrame);
+      frameStats.Annotate("render thread restart");
+      restartRenderThread = false;
+    }
   }
 
+  // GL is only used from this thread again after Stop
+  renderThread.Stop();
+  gpuTimer.Shutdown();
+  sceneTimer.Shutdown();
+  overdrawMeter.Shutdown();
+  scaledTarget.Shutdown();
+  multiViewTarget.Shutdown();
+  layeredRenderer.Cleanup();
+  frameReadback.Shutdown();
+  sceneStreamer.Stop();
+
   renderer->Cleanup();
   delete renderer;
+  sceneStore.Shutdown();
+  // Everything still registered here outlived its owner
+  GpuResourceTracker::Get().ReportLeaks(nullptr, std::cerr);
 
   ImGui_ImplOpenGL3_Shutdown();
   ImGui_ImplGlfw_Shutdown();
@@ -184,11 +1240,6 @@ void processInput(GLFWwindow *window) {
     camera.ProcessKeyboard(RIGHT, deltaTime);
 }
 
-// glfw: whenever the window size changed (by OS or user resize) this callback
-void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
-  glViewport(0, 0, width, height);
-}
-
 void mouse_callback(GLFWwindow *window, double xpos, double ypos) {
   if (cursorEnabled) {
     firstMouse = true;
@@ -212,3 +1263,55 @@ void mouse_callback(GLFWwindow *window, double xpos, double ypos) {
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset) {
   camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
+
+// Writes the current benchmark numbers as JSON next to the executable
+bool exportResults(const char *path, const char *rendererName, int objectCount,
+                   const FrameStats &stats, const RenderThread &renderThread,
+                   const LatencyStats &latency, const CapacitySearch &capacity,
+                   const BottleneckClassifier &bottleneck,
+                   const StrategyStats &strategies,
+                   const MultiViewCost &multiView,
+                   const AutoStrategy &autoStrategy) {
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    std::cerr << "Could not write results: " << path << "\n";
+    return false;
+  }
+
+  file << "{\n";
+  file << "  \"renderer\": \"" << rendererName << "\",\n";
+  file << "  \"objectCount\": " << objectCount << ",\n";
+  const ThreadLoad &load = renderThread.Load();
+  file << "  \"renderThread\": {\"threaded\": "
+       << (renderThread.Threaded() ? "true" : "false")
+       << ", \"snapshots\": " << renderThread.SnapshotCount()
+       << ", \"mainBusyMs\": " << load.mainBusyMs
+       << ", \"renderBusyMs\": " << load.renderBusyMs
+       << ", \"overlapMs\": " << load.overlapMs << "},\n";
+  file << "  \"frameStats\": ";
+  stats.WriteJson(file);
+  file << ",\n  \"latency\": ";
+  latency.WriteJson(file);
+  file << ",\n  \"strategies\": ";
+  strategies.WriteJson(file);
+  file << ",\n  \"multiView\": ";
+  multiView.WriteJson(file);
+  if (!autoStrategy.Decisions().empty()) {
+    file << ",\n  \"autoStrategy\": ";
+    autoStrategy.WriteJson(file);
+  }
+  if (!capacity.Results().empty()) {
+    file << ",\n  \"capacity\": ";
+    capacity.WriteJson(file);
+  }
+  if (!bottleneck.Results().empty()) {
+    if (const BottleneckResult *result = bottleneck.Latest(rendererName))
+      file << ",\n  \"bottleneckLabel\": \"" << BottleneckName(result->label) << "\"";
+    file << ",\n  \"bottleneck\": ";
+    bottleneck.WriteJson(file);
+  }
+  file << "\n}\n";
+
+  std::cout << "SUCCESS::RESULTS::EXPORTED::" << path << std::endl;
+  return true;
+}
@@ -1,43 +1,190 @@
 #include "renderers/BatchRenderer.h"
-#include "core/Camera.h"
 #include "core/Cube.h"
+#include "core/SceneStore.h"
 #include "core/Shader.h"
-#include "tools/EngineConfig.h"
+#include "tools/Profiler.h"
 
 #include <glad/glad.h>
-#include <GLFW/glfw3.h>
 #include <glm/detail/qualifier.hpp>
 #include <glm/fwd.hpp>
-#include <random>
 
-Cube cube;
-std::vector<glm::vec3> positions;
+#include <algorithm>
+#include <iostream>
 
 void BatchRenderer::Init() {
-  // init system
-  cube.loadCube();
-  positions.clear();
+  PROFILE_SCOPE("Batch Init");
+  // Batched vertices are already in world space and carry their material
+  programs = scene->GetPrograms("batchcube.vs");
 
-  std::mt19937 rng(42); // fixed seed = reproducible
-  std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+  SceneStore::DerivedBuffer &batch = scene->GetDerived("batch");
+  GLsizei stride = BatchVertexStride * sizeof(float);
 
-  int maxObjects = 50000; // cap limit
+  VAO.Create(GetName());
+  glBindVertexArray(VAO);
+  glBindBuffer(GL_ARRAY_BUFFER, batch.buffer);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *)0);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
+                        (void *)(3 * sizeof(float)));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
+                        (void *)(6 * sizeof(float)));
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, stride,
+                        (void *)(8 * sizeof(float)));
+  glEnableVertexAttribArray(3);
+  // Only read by the front-to-back path
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene->GetDerived("batch order").buffer);
+  glBindVertexArray(0);
+}
+
+// Maps target's buffer for a full rewrite of bytes, reallocating it only when
+// the size changes. The batch runs to hundreds of MB, so it is written in
+// place rather than staged in the frame arena, which would keep the spike.
+static void *mapForRewrite(GLenum target, SceneStore::DerivedBuffer &derived,
+                           size_t bytes) {
+  glBindBuffer(target, derived.buffer);
+  if (derived.bytes != bytes) {
+    glBufferData(target, bytes, nullptr, GL_DYNAMIC_DRAW);
+    derived.buffer.SetBytes(bytes);
+    derived.bytes = bytes;
+  }
+  return glMapBufferRange(target, 0, bytes,
+                          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+}
+
+void BatchRenderer::RebuildBatch(size_t count, RenderCounters *stats) {
+  PROFILE_SCOPE("Batch Rebuild");
+  SceneStore::DerivedBuffer &batch = scene->GetDerived("batch");
+  const auto &models = scene->ModelMatrices();
+
+  // Write-only and sequential: the mapping may be uncached memory
+  size_t bytes = count * CubeVertexCount * BatchVertexStride * sizeof(float);
+  batch.objectCount = 0;
+  if (bytes == 0)
+    return;
+  float *out = static_cast<float *>(mapForRewrite(GL_ARRAY_BUFFER, batch, bytes));
+  if (!out) {
+    std::cerr << "ERROR::BATCH::MAP_FAILED::" << bytes << " bytes" << std::endl;
+    return;
+  }
+  for (size_t i = 0; i < count; i++) {
+    const glm::mat4 &model = models[i];
+    glm::mat3 normalMatrix(model);
+    float material = static_cast<float>(scene->ObjectMaterial(i));
+
+    for (int v = 0; v < CubeVertexCount; v++) {
+      const float *in = cubeVertices + v * CubeVertexStride;
+      glm::vec4 p = model * glm::vec4(in[0], in[1], in[2], 1.0f);
+      glm::vec3 n = glm::normalize(normalMatrix * glm::vec3(in[3], in[4], in[5]));
+      *out++ = p.x;
+      *out++ = p.y;
+      *out++ = p.z;
+      *out++ = n.x;
+      *out++ = n.y;
+      *out++ = n.z;
+      *out++ = in[6];
+      *out++ = in[7];
+      *out++ = material;
+    }
+  }
+
+  // Contents are undefined after a failed unmap; the next frame rebuilds
+  if (glUnmapBuffer(GL_ARRAY_BUFFER) != GL_TRUE)
+    return;
+  batch.objectCount = count;
+  batch.version = scene->InstanceVersion();
+  if (stats) {
+    stats->uploadBytes += batch.bytes;
+    stats->stateChanges += 1;
+  }
+}
+
+void BatchRenderer::Render(const FrameContext &frame) {
+  PROFILE_SCOPE("Batch Render");
+  // The merged buffer lives in the scene store, so it survives strategy
+  // switches and is only rebuilt when a model matrix or material changes
+  size_t available = std::min(scene->GpuCount(), MaxBatchedObjects);
+  SceneStore::DerivedBuffer &batch = scene->GetDerived("batch");
+  if (batch.version != scene->InstanceVersion() || batch.objectCount < available)
+    RebuildBatch(available, frame.stats);
+
+  size_t count = std::min(frame.objectCount, batch.objectCount);
+  if (count == 0)
+    return;
 
-  for (int i = 0; i < maxObjects; i++) {
-    glm::vec3 pos(dist(rng), dist(rng), dist(rng));
+  // Sorting reorders whole objects, so it only needs a new index buffer
+  if (scene->FrontToBack())
+    count = RebuildOrder(count, frame.stats);
 
-    positions.push_back(pos);
+  Shader &active = scene->UseProgram(programs, frame.stats);
+  active.setUniform("projection", frame.projection);
+  active.setUniform("view", frame.view);
+
+  glBindVertexArray(VAO);
+  if (scene->FrontToBack())
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(count * CubeVertexCount),
+                   GL_UNSIGNED_INT, nullptr);
+  else
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(count * CubeVertexCount));
+
+  if (frame.stats) {
+    frame.stats->drawCalls += 1;
+    frame.stats->instances += count;
+    frame.stats->triangles += count * (CubeVertexCount / 3);
+    frame.stats->vertices += count * CubeVertexCount;
+    frame.stats->stateChanges += 3; // VAO, projection and view
   }
 }
 
-void BatchRenderer::Render(int objectCount, Camera &camera,
-                           GLFWwindow *window) {
-  // Render here
-  for (int i = 0; i < objectCount && i < positions.size(); i++) {
-    cube.Position = positions[i];
-    cube.render(camera, window);
+size_t BatchRenderer::RebuildOrder(size_t count, RenderCounters *stats) {
+  SceneStore::DerivedBuffer &order = scene->GetDerived("batch order");
+  if (order.version == scene->DrawOrderVersion())
+    return order.objectCount;
+
+  PROFILE_SCOPE("Batch Order");
+  const std::vector<uint32_t> &drawOrder = scene->DrawOrder();
+  size_t objects = 0;
+  for (uint32_t object : drawOrder)
+    objects += object < count;
+  order.objectCount = 0;
+  size_t bytes = objects * CubeVertexCount * sizeof(uint32_t);
+  if (bytes == 0) {
+    order.version = scene->DrawOrderVersion();
+    return 0;
+  }
+
+  // Not through GL_ELEMENT_ARRAY_BUFFER, which would change the bound VAO
+  uint32_t *indices = static_cast<uint32_t *>(
+      mapForRewrite(GL_COPY_WRITE_BUFFER, order, bytes));
+  if (!indices) {
+    std::cerr << "ERROR::BATCH::MAP_FAILED::" << bytes << " bytes" << std::endl;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return 0;
+  }
+  objects = 0;
+  for (uint32_t object : drawOrder) {
+    if (object >= count)
+      continue;
+    uint32_t first = object * CubeVertexCount;
+    uint32_t *out = indices + objects++ * CubeVertexCount;
+    for (int v = 0; v < CubeVertexCount; v++)
+      out[v] = first + v;
+  }
+
+  bool written = glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_TRUE;
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  if (!written)
+    return 0;
+  order.objectCount = objects;
+  order.version = scene->DrawOrderVersion();
+  if (stats) {
+    stats->uploadBytes += order.bytes;
+    stats->stateChanges += 2;
   }
+  return objects;
 }
 
 void BatchRenderer::Cleanup() {
+  VAO.Reset();
 }
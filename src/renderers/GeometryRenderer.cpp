@@ -0,0 +1,58 @@
+#include <glad/glad.h>
+#include "renderers/GeometryRenderer.h"
+#include "core/SceneStore.h"
+#include "core/Shader.h"
+#include "tools/Profiler.h"
+
+#include <algorithm>
+
+void GeometryRenderer::Init()
+{
+  PROFILE_SCOPE("Geometry Init");
+  programs = scene->GetPrograms("pointcube.vs", "pointcube.gs");
+
+  // Instance attributes read once per point instead of once per instance
+  for (int sorted = 0; sorted < 2; sorted++) {
+    GlVertexArray &vao = sorted ? sortedVAO : VAO;
+    vao.Create(GetName());
+    glBindVertexArray(vao);
+    scene->BindInstanceAttributes(0, sorted != 0);
+    for (GLuint location = 0; location < 5; location++)
+      glVertexAttribDivisor(location, 0);
+  }
+  glBindVertexArray(0);
+}
+
+void GeometryRenderer::Render(const FrameContext &frame)
+{
+  PROFILE_SCOPE("Geometry Render");
+  size_t count = std::min(frame.objectCount, scene->GpuCount());
+  bool sorted = scene->FrontToBack();
+  if (sorted)
+    count = std::min(count, scene->DrawOrder().size());
+  if (count == 0)
+    return;
+
+  Shader &active = scene->UseProgram(programs, frame.stats);
+  active.setUniform("projection", frame.projection);
+  active.setUniform("view", frame.view);
+  active.setUniform("cameraPosition", frame.cameraPosition);
+
+  glBindVertexArray(sorted ? sortedVAO : VAO);
+  glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(count));
+
+  if (frame.stats) {
+    frame.stats->drawCalls += 1;
+    frame.stats->instances += count;
+    // At most three faces of a cube face the camera
+    frame.stats->triangles += count * 6;
+    frame.stats->vertices += count;
+    frame.stats->stateChanges += 4; // VAO, projection, view and camera
+  }
+}
+
+void GeometryRenderer::Cleanup()
+{
+  VAO.Reset();
+  sortedVAO.Reset();
+}
@@ -1,19 +1,61 @@
 #include <glad/glad.h>
-#include <GLFW/glfw3.h>
 #include "renderers/InstancedRenderer.h"
+#include "core/Cube.h"
+#include "core/SceneStore.h"
 #include "core/Shader.h"
+#include "tools/Profiler.h"
+
+#include <algorithm>
 
 void InstancedRenderer::Init() 
 {
-  //init system
+  PROFILE_SCOPE("Instanced Init");
+  programs = scene->GetPrograms("instancedcube.vs");
+
+  VAO.Create(GetName());
+  glBindVertexArray(VAO);
+  scene->BindCubeAttributes();
+  scene->BindInstanceAttributes(3);
+
+  sortedVAO.Create(GetName());
+  glBindVertexArray(sortedVAO);
+  scene->BindCubeAttributes();
+  scene->BindInstanceAttributes(3, true);
+  glBindVertexArray(0);
 }
 
-void InstancedRenderer::Render(int objectCount, Camera& camera, GLFWwindow *window) 
+void InstancedRenderer::Render(const FrameContext &frame) 
 {
-  //Render here
+  PROFILE_SCOPE("Instanced Render");
+  size_t count = std::min(frame.objectCount, scene->GpuCount());
+  if (count == 0)
+    return;
+
+  Shader &active = scene->UseProgram(programs, frame.stats);
+  active.setUniform("projection", frame.projection);
+  active.setUniform("view", frame.view);
+
+  // The sorted copy holds exactly the drawn objects, nearest first
+  if (scene->FrontToBack()) {
+    count = std::min(count, scene->DrawOrder().size());
+    glBindVertexArray(sortedVAO);
+  } else {
+    glBindVertexArray(VAO);
+  }
+  glDrawArraysInstanced(GL_TRIANGLES, 0, CubeVertexCount,
+                        static_cast<GLsizei>(count));
+
+  if (frame.stats) {
+    frame.stats->drawCalls += 1;
+    frame.stats->instances += count;
+    frame.stats->triangles += count * (CubeVertexCount / 3);
+    frame.stats->vertices += count * CubeVertexCount;
+    frame.stats->stateChanges += 3; // VAO, projection and view
+  }
 }
 
 void InstancedRenderer::Cleanup() 
 {
-  //Clean stuff here
+  VAO.Reset();
+  sortedVAO.Reset();
 }
@@ -0,0 +1,131 @@
+#include <glad/glad.h>
+#include "renderers/LayeredRenderer.h"
+#include "core/Cube.h"
+#include "core/SceneStore.h"
+#include "core/Shader.h"
+#include "tools/JobSystem.h"
+#include "tools/MultiView.h"
+#include "tools/Profiler.h"
+
+#include <algorithm>
+
+static constexpr size_t CullGrain = 1024;
+
+void LayeredRenderer::Init()
+{
+  PROFILE_SCOPE("Layered Init");
+  programs = scene->GetPrograms("layeredcube.vs", "layeredcube.gs");
+
+  instanceBuffer.Create("Layered");
+  VAO.Create("Layered");
+  glBindVertexArray(VAO);
+  scene->BindCubeAttributes();
+  glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+  glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void *)0);
+  glEnableVertexAttribArray(3);
+  glVertexAttribDivisor(3, 1);
+  glBindVertexArray(0);
+
+  matrixTexture.Create("Layered");
+  glBindTexture(GL_TEXTURE_BUFFER, matrixTexture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, scene->InstanceBuffer());
+  materialTexture.Create("Layered");
+  glBindTexture(GL_TEXTURE_BUFFER, materialTexture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, scene->MaterialBuffer());
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void LayeredRenderer::Render(const FrameContext *views, int viewCount,
+                             RenderCounters *stats)
+{
+  PROFILE_SCOPE("Layered Render");
+  viewCount = std::clamp(viewCount, 1, MultiViewSettings::MaxViews);
+  const FrameContext &frame = views[0];
+  size_t count = std::min(frame.objectCount, scene->GpuCount());
+  const auto &models = scene->ModelMatrices();
+
+  // Front to back reorders within each view; the instances still name the
+  // object, so the unsorted buffers serve both
+  const uint32_t *order = nullptr;
+  if (scene->FrontToBack()) {
+    order = scene->DrawOrder().data();
+    count = std::min(count, scene->DrawOrder().size());
+  }
+
+  // Blocks keep their own lists, so the submission order does not depend on
+  // which thread culled what
+  size_t blocks = (count + CullGrain - 1) / CullGrain;
+  if (blockInstances.size() < blocks)
+    blockInstances.resize(blocks);
+  {
+    PROFILE_SCOPE("Layered Cull");
+    JobSystem::Shared().ParallelFor(count, CullGrain, [&](size_t begin, size_t end) {
+      std::vector<uint32_t> &out = blockInstances[begin / CullGrain];
+      out.clear();
+      for (size_t k = begin; k < end; k++) {
+        uint32_t i = order ? order[k] : static_cast<uint32_t>(k);
+        const glm::mat4 &model = models[i];
+        float scale = std::max({glm::length(glm::vec3(model[0])),
+                                glm::length(glm::vec3(model[1])),
+                                glm::length(glm::vec3(model[2]))});
+        glm::vec3 center(model[3]);
+        for (int v = 0; v < viewCount; v++) {
+          if (views[v].SphereVisible(center, 0.8661f * scale))
+            out.push_back(i << 3 | static_cast<uint32_t>(v));
+        }
+      }
+    });
+  }
+  instances.clear();
+  for (size_t block = 0; block < blocks; block++)
+    instances.insert(instances.end(), blockInstances[block].begin(),
+                     blockInstances[block].end());
+  if (stats)
+    stats->instances += instances.size();
+  if (instances.empty())
+    return;
+
+  size_t bytes = instances.size() * sizeof(uint32_t);
+  glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+  glBufferData(GL_ARRAY_BUFFER, bytes, instances.data(), GL_STREAM_DRAW);
+  instanceBuffer.SetBytes(bytes);
+
+  glm::mat4 viewProjections[MultiViewSettings::MaxViews];
+  for (int v = 0; v < MultiViewSettings::MaxViews; v++)
+    viewProjections[v] = views[std::min(v, viewCount - 1)].viewProjection;
+
+  Shader &active = scene->UseProgram(programs, stats);
+  active.setUniform("view", frame.view);
+  glUniformMatrix4fv(glGetUniformLocation(active.ID, "viewProjections"),
+                     MultiViewSettings::MaxViews, GL_FALSE, &viewProjections[0][0][0]);
+
+  glActiveTexture(GL_TEXTURE0 + MatrixUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, matrixTexture);
+  active.setUniform("instanceMatrices", MatrixUnit);
+  glActiveTexture(GL_TEXTURE0 + MaterialUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, materialTexture);
+  active.setUniform("instanceMaterials", MaterialUnit);
+  glActiveTexture(GL_TEXTURE0);
+
+  glBindVertexArray(VAO);
+  glDrawArraysInstanced(GL_TRIANGLES, 0, CubeVertexCount,
+                        static_cast<GLsizei>(instances.size()));
+
+  if (stats) {
+    stats->drawCalls += 1;
+    stats->triangles += instances.size() * (CubeVertexCount / 3);
+    stats->vertices += instances.size() * CubeVertexCount;
+    stats->uploadBytes += bytes;
+    stats->textureBinds += 2;
+    // Instance buffer, VAO, view, the view matrices and two sampler uniforms
+    stats->stateChanges += 6;
+  }
+}
+
+void LayeredRenderer::Cleanup()
+{
+  VAO.Reset();
+  instanceBuffer.Reset();
+  matrixTexture.Reset();
+  materialTexture.Reset();
+}
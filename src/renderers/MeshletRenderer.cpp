@@ -0,0 +1,252 @@
+#include <glad/glad.h>
+#include "renderers/MeshletRenderer.h"
+#include "core/SceneStore.h"
+#include "core/Shader.h"
+#include "tools/JobSystem.h"
+#include "tools/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MESHLET_CULL_SSE2 1
+#endif
+
+static_assert(sizeof(MeshVertex) == 8 * sizeof(float));
+
+// Objects per culling job
+static constexpr size_t CullGrain = 256;
+
+void MeshletRenderer::Init()
+{
+  PROFILE_SCOPE("Meshlet Init");
+  // 48 x 96 quads: about 9000 triangles in ~100 meshlets
+  mesh = Mesh::Sphere(48, 96);
+  programs = scene->GetPrograms("instancedcube.vs");
+
+  VAO.Create(GetName());
+  vertexBuffer.Create(GetName());
+  indexBuffer.Create(GetName());
+  indirectBuffer.Create(GetName());
+
+  glBindVertexArray(VAO);
+  glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+  glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(MeshVertex),
+               mesh.vertices.data(), GL_STATIC_DRAW);
+  vertexBuffer.SetBytes(mesh.vertices.size() * sizeof(MeshVertex));
+  GLsizei stride = sizeof(MeshVertex);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride,
+                        (void *)offsetof(MeshVertex, position));
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
+                        (void *)offsetof(MeshVertex, normal));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
+                        (void *)offsetof(MeshVertex, texCoord));
+  glEnableVertexAttribArray(2);
+  scene->BindInstanceAttributes(3);
+
+  // Element buffer binding is VAO state
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(uint32_t),
+               mesh.indices.data(), GL_STATIC_DRAW);
+  indexBuffer.SetBytes(mesh.indices.size() * sizeof(uint32_t));
+  glBindVertexArray(0);
+
+  multiDrawIndirect = GLAD_GL_VERSION_4_3 != 0;
+}
+
+void MeshletRenderer::CullObject(const FrameContext &frame, const glm::mat4 &model,
+                                   uint32_t object, std::vector<DrawCommand> &out) const
+{
+  glm::vec3 axisX(model[0]), axisY(model[1]), axisZ(model[2]), origin(model[3]);
+  float scaleX2 = glm::dot(axisX, axisX);
+  float scaleY2 = glm::dot(axisY, axisY);
+  float scaleZ2 = glm::dot(axisZ, axisZ);
+  float maxScale = std::sqrt(std::max({scaleX2, scaleY2, scaleZ2}));
+
+  glm::vec3 worldCenter = origin + axisX * mesh.center.x + axisY * mesh.center.y +
+                          axisZ * mesh.center.z;
+  if (!frame.SphereVisible(worldCenter, mesh.radius * maxScale))
+    return;
+
+  // Camera in mesh space. Columns are rotation times scale, so the inverse
+  // is each column over its squared length, transposed. The cone test holds
+  // in mesh space even under non-uniform scale.
+  glm::vec3 toCamera = frame.cameraPosition - origin;
+  glm::vec3 camera(glm::dot(axisX, toCamera) / scaleX2,
+                   glm::dot(axisY, toCamera) / scaleY2,
+                   glm::dot(axisZ, toCamera) / scaleZ2);
+
+  const MeshletBounds &b = mesh.meshletBounds;
+  size_t count = b.Size();
+  auto emit = [&](size_t m) {
+    const Meshlet &meshlet = mesh.meshlets[m];
+    // Neighbouring clusters are neighbouring index ranges: merge them
+    if (!out.empty() && out.back().baseInstance == object &&
+        out.back().firstIndex + out.back().count == meshlet.firstIndex) {
+      out.back().count += meshlet.triangleCount * 3;
+      return;
+    }
+    out.push_back({meshlet.triangleCount * 3, 1, meshlet.firstIndex, 0, object});
+  };
+
+  size_t m = 0;
+#ifdef MESHLET_CULL_SSE2
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y),
+               oz = _mm_set1_ps(origin.z);
+  const __m128 cx = _mm_set1_ps(camera.x), cy = _mm_set1_ps(camera.y),
+               cz = _mm_set1_ps(camera.z);
+  const __m128 scale = _mm_set1_ps(maxScale);
+  auto dot3 = [](__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz) {
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)),
+                      _mm_mul_ps(az, bz));
+  };
+  for (; m + 4 <= count; m += 4) {
+    __m128 x = _mm_loadu_ps(&b.centerX[m]);
+    __m128 y = _mm_loadu_ps(&b.centerY[m]);
+    __m128 z = _mm_loadu_ps(&b.centerZ[m]);
+    __m128 r = _mm_loadu_ps(&b.radius[m]);
+
+    // Normal cone, in mesh space
+    __m128 dx = _mm_sub_ps(x, cx), dy = _mm_sub_ps(y, cy), dz = _mm_sub_ps(z, cz);
+    __m128 distance = _mm_sqrt_ps(dot3(dx, dy, dz, dx, dy, dz));
+    __m128 facing = dot3(dx, dy, dz, _mm_loadu_ps(&b.axisX[m]),
+                         _mm_loadu_ps(&b.axisY[m]), _mm_loadu_ps(&b.axisZ[m]));
+    __m128 backfacing = _mm_cmpge_ps(
+        facing, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&b.cutoff[m]), distance), r));
+    if (_mm_movemask_ps(backfacing) == 0xF)
+      continue;
+
+    // Bounding sphere against the frustum, in world space
+    __m128 wx = _mm_add_ps(ox, dot3(_mm_set1_ps(axisX.x), _mm_set1_ps(axisY.x),
+                                    _mm_set1_ps(axisZ.x), x, y, z));
+    __m128 wy = _mm_add_ps(oy, dot3(_mm_set1_ps(axisX.y), _mm_set1_ps(axisY.y),
+                                    _mm_set1_ps(axisZ.y), x, y, z));
+    __m128 wz = _mm_add_ps(oz, dot3(_mm_set1_ps(axisX.z), _mm_set1_ps(axisY.z),
+                                    _mm_set1_ps(axisZ.z), x, y, z));
+    __m128 negRadius = _mm_sub_ps(zero, _mm_mul_ps(r, scale));
+    __m128 outside = zero;
+    for (const glm::vec4 &plane : frame.frustumPlanes) {
+      __m128 d = _mm_add_ps(dot3(_mm_set1_ps(plane.x), _mm_set1_ps(plane.y),
+                                 _mm_set1_ps(plane.z), wx, wy, wz),
+                            _mm_set1_ps(plane.w));
+      outside = _mm_or_ps(outside, _mm_cmplt_ps(d, negRadius));
+    }
+
+    int culled = _mm_movemask_ps(_mm_or_ps(backfacing, outside));
+    for (int lane = 0; lane < 4; lane++) {
+      if (!(culled & (1 << lane)))
+        emit(m + lane);
+    }
+  }
+#endif
+
+  for (; m < count; m++) {
+    glm::vec3 c(b.centerX[m], b.centerY[m], b.centerZ[m]);
+    glm::vec3 d = c - camera;
+    if (glm::dot(d, glm::vec3(b.axisX[m], b.axisY[m], b.axisZ[m])) >=
+        b.cutoff[m] * glm::length(d) + b.radius[m])
+      continue;
+    glm::vec3 world = origin + axisX * c.x + axisY * c.y + axisZ * c.z;
+    if (!frame.SphereVisible(world, b.radius[m] * maxScale))
+      continue;
+    emit(m);
+  }
+}
+
+void MeshletRenderer::Render(const FrameContext &frame)
+{
+  PROFILE_SCOPE("Meshlet Render");
+  size_t count = std::min(frame.objectCount, scene->GpuCount());
+  const auto &models = scene->ModelMatrices();
+
+  // Front to back culls and draws the same objects, only reordered
+  const uint32_t *order = nullptr;
+  if (scene->FrontToBack()) {
+    order = scene->DrawOrder().data();
+    count = std::min(count, scene->DrawOrder().size());
+  }
+
+  // Blocks keep their own lists, so the draw order does not depend on which
+  // thread culled what
+  size_t blocks = (count + CullGrain - 1) / CullGrain;
+  if (blockCommands.size() < blocks)
+    blockCommands.resize(blocks);
+  {
+    PROFILE_SCOPE("Meshlet Cull");
+    JobSystem::Shared().ParallelFor(count, CullGrain, [&](size_t begin, size_t end) {
+      size_t block = begin / CullGrain;
+      std::vector<DrawCommand> &out = blockCommands[block];
+      out.clear();
+      for (size_t k = begin; k < end; k++) {
+        uint32_t i = order ? order[k] : static_cast<uint32_t>(k);
+        CullObject(frame, models[i], i, out);
+      }
+    });
+  }
+
+  commands.clear();
+  for (size_t block = 0; block < blocks; block++)
+    commands.insert(commands.end(), blockCommands[block].begin(),
+                    blockCommands[block].end());
+  size_t indicesDrawn = 0;
+  for (const DrawCommand &command : commands)
+    indicesDrawn += command.count;
+
+  if (frame.stats) {
+    frame.stats->sceneTriangles += count * mesh.TriangleCount();
+    frame.stats->triangles += indicesDrawn / 3;
+    frame.stats->vertices += indicesDrawn;
+  }
+  if (commands.empty())
+    return;
+
+  Shader &active = scene->UseProgram(programs, frame.stats);
+  active.setUniform("projection", frame.projection);
+  active.setUniform("view", frame.view);
+  glBindVertexArray(VAO);
+
+  GLsizei drawCount = static_cast<GLsizei>(commands.size());
+  if (multiDrawIndirect) {
+    // Orphaned every frame; the driver hands out fresh storage
+    size_t bytes = commands.size() * sizeof(DrawCommand);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, bytes, commands.data(), GL_STREAM_DRAW);
+    indirectBuffer.SetBytes(bytes);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, drawCount, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  } else {
+    for (const DrawCommand &command : commands)
+      glDrawElementsInstancedBaseVertexBaseInstance(
+          GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+          (void *)(size_t(command.firstIndex) * sizeof(uint32_t)),
+          command.instanceCount, command.baseVertex, command.baseInstance);
+  }
+  glBindVertexArray(0);
+
+  if (frame.stats) {
+    frame.stats->drawCalls += multiDrawIndirect ? 1 : commands.size();
+    // VAO, projection and view, plus binding the indirect buffer
+    frame.stats->stateChanges += multiDrawIndirect ? 5 : 3;
+    if (multiDrawIndirect)
+      frame.stats->uploadBytes += commands.size() * sizeof(DrawCommand);
+    // Objects with at least one cluster left
+    size_t objects = 0;
+    for (size_t c = 0; c < commands.size(); c++)
+      objects += c == 0 || commands[c].baseInstance != commands[c - 1].baseInstance;
+    frame.stats->instances += objects;
+  }
+}
+
+void MeshletRenderer::Cleanup()
+{
+  VAO.Reset();
+  vertexBuffer.Reset();
+  indexBuffer.Reset();
+  indirectBuffer.Reset();
+  blockCommands.clear();
+  commands.clear();
+}
@@ -1,19 +1,60 @@
 #include <glad/glad.h>
-#include <GLFW/glfw3.h>
 #include "renderers/NaiveRenderer.h"
+#include "core/Cube.h"
+#include "core/SceneStore.h"
 #include "core/Shader.h"
+#include "tools/Profiler.h"
+
+#include <algorithm>
 
 void NaiveRenderer::Init() 
 {
-  //init system
+  PROFILE_SCOPE("Naive Init");
+  programs = scene->GetPrograms("naivecube.vs");
+
+  // Only the attribute layout is per strategy; the vertex data is shared
+  VAO.Create(GetName());
+  glBindVertexArray(VAO);
+  scene->BindCubeAttributes();
+  glBindVertexArray(0);
 }
 
-void NaiveRenderer::Render(int objectCount, Camera& camera, GLFWwindow *window) 
+void NaiveRenderer::Render(const FrameContext &frame) 
 {
-  //Render here
+  PROFILE_SCOPE("Naive Render");
+  size_t count = std::min(frame.objectCount, scene->GpuCount());
+  const auto &models = scene->ModelMatrices();
+
+  Shader &active = scene->UseProgram(programs, frame.stats);
+  active.setUniform("projection", frame.projection);
+  active.setUniform("view", frame.view);
+
+  // Front to back draws the same objects, only reordered
+  const uint32_t *order = nullptr;
+  if (scene->FrontToBack()) {
+    order = scene->DrawOrder().data();
+    count = std::min(count, scene->DrawOrder().size());
+  }
+
+  glBindVertexArray(VAO);
+  for (size_t k = 0; k < count; k++) {
+    size_t i = order ? order[k] : k;
+    active.setUniform("model", models[i]);
+    active.setUniform("materialIndex", static_cast<int>(scene->ObjectMaterial(i)));
+    glDrawArrays(GL_TRIANGLES, 0, CubeVertexCount);
+  }
+
+  if (frame.stats) {
+    frame.stats->drawCalls += count;
+    frame.stats->instances += count;
+    frame.stats->triangles += count * (CubeVertexCount / 3);
+    frame.stats->vertices += count * CubeVertexCount;
+    // VAO, projection and view, then model and material per object
+    frame.stats->stateChanges += 3 + 2 * count;
+  }
 }
 
 void NaiveRenderer::Cleanup() 
 {
-  //Clean stuff here
+  VAO.Reset();
 }
@@ -0,0 +1,191 @@
+#include <glad/glad.h>
+#include "renderers/PackedRenderer.h"
+#include "core/Cube.h"
+#include "core/SceneStore.h"
+#include "core/Shader.h"
+#include "tools/FrameArena.h"
+#include "tools/JobSystem.h"
+#include "tools/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+static_assert(sizeof(PackedRenderer::PackedInstance) == 16);
+
+static constexpr size_t PackGrain = 4096;
+
+static uint32_t quantize(float value, float scale, uint32_t max) {
+  float q = std::round(value * scale);
+  return static_cast<uint32_t>(std::clamp(q, 0.0f, float(max)));
+}
+
+static uint32_t packSnorm8(float value) {
+  return static_cast<uint32_t>(
+             static_cast<int32_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 127.0f))) &
+         0xffu;
+}
+
+PackedRenderer::PackedInstance
+PackedRenderer::PackInstance(const glm::mat4 &model, uint32_t material,
+                             const glm::vec3 &boundsMin,
+                             const glm::vec3 &inverseExtent) {
+  glm::vec3 columns[3] = {glm::vec3(model[0]), glm::vec3(model[1]),
+                          glm::vec3(model[2])};
+  float scale[3];
+  for (int c = 0; c < 3; c++) {
+    scale[c] = std::max(glm::length(columns[c]), 1e-8f);
+    columns[c] = columns[c] / scale[c];
+  }
+
+  // Rotation matrix to quaternion; r(row, column)
+  auto r = [&](int row, int column) { return columns[column][row]; };
+  float trace = r(0, 0) + r(1, 1) + r(2, 2);
+  float qx, qy, qz, qw;
+  if (trace > 0.0f) {
+    float s = std::sqrt(trace + 1.0f) * 2.0f;
+    qw = 0.25f * s;
+    qx = (r(2, 1) - r(1, 2)) / s;
+    qy = (r(0, 2) - r(2, 0)) / s;
+    qz = (r(1, 0) - r(0, 1)) / s;
+  } else if (r(0, 0) > r(1, 1) && r(0, 0) > r(2, 2)) {
+    float s = std::sqrt(1.0f + r(0, 0) - r(1, 1) - r(2, 2)) * 2.0f;
+    qw = (r(2, 1) - r(1, 2)) / s;
+    qx = 0.25f * s;
+    qy = (r(0, 1) + r(1, 0)) / s;
+    qz = (r(0, 2) + r(2, 0)) / s;
+  } else if (r(1, 1) > r(2, 2)) {
+    float s = std::sqrt(1.0f + r(1, 1) - r(0, 0) - r(2, 2)) * 2.0f;
+    qw = (r(0, 2) - r(2, 0)) / s;
+    qx = (r(0, 1) + r(1, 0)) / s;
+    qy = 0.25f * s;
+    qz = (r(1, 2) + r(2, 1)) / s;
+  } else {
+    float s = std::sqrt(1.0f + r(2, 2) - r(0, 0) - r(1, 1)) * 2.0f;
+    qw = (r(1, 0) - r(0, 1)) / s;
+    qx = (r(0, 2) + r(2, 0)) / s;
+    qy = (r(1, 2) + r(2, 1)) / s;
+    qz = 0.25f * s;
+  }
+
+  glm::vec3 position(model[3]);
+  PackedInstance out;
+  out.x = quantize((position.x - boundsMin.x) * inverseExtent.x, 65535.0f, 65535) |
+          quantize((position.y - boundsMin.y) * inverseExtent.y, 65535.0f, 65535) << 16;
+  out.y = quantize((position.z - boundsMin.z) * inverseExtent.z, 65535.0f, 65535) |
+          std::min(material, 0xffffu) << 16;
+  out.z = packSnorm8(qx) | packSnorm8(qy) << 8 | packSnorm8(qz) << 16 |
+          packSnorm8(qw) << 24;
+  out.w = 0;
+  for (int c = 0; c < 3; c++)
+    out.w |= quantize(std::log2(scale[c]) + 8.0f, 16.0f, 255) << (8 * c);
+  return out;
+}
+
+void PackedRenderer::Init()
+{
+  PROFILE_SCOPE("Packed Init");
+  programs = scene->GetPrograms("packedcube.vs");
+  VAO.Create(GetName());
+
+  instanceTexture.Create(GetName());
+  glBindTexture(GL_TEXTURE_BUFFER, instanceTexture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, scene->GetDerived("packed").buffer);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  packedOrder = ~uint64_t(0);
+}
+
+void PackedRenderer::Repack(size_t count, bool sorted, LinearArena &arena,
+                            RenderCounters *stats)
+{
+  PROFILE_SCOPE("Packed Rebuild");
+  SceneStore::DerivedBuffer &packed = scene->GetDerived("packed");
+  const auto &models = scene->ModelMatrices();
+  const uint32_t *order = sorted ? scene->DrawOrder().data() : nullptr;
+
+  glm::vec3 boundsMax(0.0f);
+  boundsMin = glm::vec3(0.0f);
+  for (size_t k = 0; k < count; k++) {
+    glm::vec3 p(models[order ? order[k] : k][3]);
+    boundsMin = k ? glm::min(boundsMin, p) : p;
+    boundsMax = k ? glm::max(boundsMax, p) : p;
+  }
+  boundsExtent = boundsMax - boundsMin;
+  glm::vec3 inverseExtent(boundsExtent.x > 0.0f ? 1.0f / boundsExtent.x : 0.0f,
+                          boundsExtent.y > 0.0f ? 1.0f / boundsExtent.y : 0.0f,
+                          boundsExtent.z > 0.0f ? 1.0f / boundsExtent.z : 0.0f);
+
+  PackedInstance *instances = arena.AllocateArray<PackedInstance>(count);
+  JobSystem::Shared().ParallelFor(count, PackGrain, [&](size_t begin, size_t end) {
+    for (size_t k = begin; k < end; k++) {
+      size_t i = order ? order[k] : k;
+      instances[k] = PackInstance(models[i], scene->ObjectMaterial(i), boundsMin,
+                                  inverseExtent);
+    }
+  });
+
+  packed.bytes = count * sizeof(PackedInstance);
+  glBindBuffer(GL_TEXTURE_BUFFER, packed.buffer);
+  glBufferData(GL_TEXTURE_BUFFER, packed.bytes, instances, GL_STREAM_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  packed.buffer.SetBytes(packed.bytes);
+  packed.objectCount = count;
+  packed.version = scene->InstanceVersion();
+  packedOrder = sorted ? scene->DrawOrderVersion() : 0;
+  if (stats) {
+    stats->uploadBytes += packed.bytes;
+    stats->stateChanges += 1;
+  }
+}
+
+void PackedRenderer::Render(const FrameContext &frame)
+{
+  PROFILE_SCOPE("Packed Render");
+  LinearArena &arena =
+      (frame.arenas ? *frame.arenas : FrameArenas::Shared()).Local();
+  // Sorted, only the drawn objects are packed, nearest first
+  bool sorted = scene->FrontToBack();
+  size_t available = sorted ? scene->DrawOrder().size() : scene->GpuCount();
+  uint64_t order = sorted ? scene->DrawOrderVersion() : 0;
+  SceneStore::DerivedBuffer &packed = scene->GetDerived("packed");
+  if (packed.version != scene->InstanceVersion() ||
+      packed.objectCount != available || packedOrder != order)
+    Repack(available, sorted, arena, frame.stats);
+
+  size_t count = std::min(frame.objectCount, packed.objectCount);
+  if (count == 0)
+    return;
+
+  Shader &active = scene->UseProgram(programs, frame.stats);
+  active.setUniform("projection", frame.projection);
+  active.setUniform("view", frame.view);
+  active.setUniform("boundsMin", boundsMin);
+  active.setUniform("boundsExtent", boundsExtent);
+
+  glActiveTexture(GL_TEXTURE0 + CubeUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, scene->CubeVertexTexture());
+  active.setUniform("cubeVertices", CubeUnit);
+  glActiveTexture(GL_TEXTURE0 + InstanceUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, instanceTexture);
+  active.setUniform("packedInstances", InstanceUnit);
+  glActiveTexture(GL_TEXTURE0);
+
+  glBindVertexArray(VAO);
+  glDrawArraysInstanced(GL_TRIANGLES, 0, CubeVertexCount,
+                        static_cast<GLsizei>(count));
+
+  if (frame.stats) {
+    frame.stats->drawCalls += 1;
+    frame.stats->instances += count;
+    frame.stats->triangles += count * (CubeVertexCount / 3);
+    frame.stats->vertices += count * CubeVertexCount;
+    frame.stats->textureBinds += 2;
+    // VAO, projection, view, bounds and the two sampler uniforms
+    frame.stats->stateChanges += 7;
+  }
+}
+
+void PackedRenderer::Cleanup()
+{
+  VAO.Reset();
+  instanceTexture.Reset();
+}
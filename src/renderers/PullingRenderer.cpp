@@ -0,0 +1,76 @@
+#include <glad/glad.h>
+#include "renderers/PullingRenderer.h"
+#include "core/Cube.h"
+#include "core/SceneStore.h"
+#include "core/Shader.h"
+#include "tools/Profiler.h"
+
+#include <algorithm>
+
+void PullingRenderer::Init()
+{
+  PROFILE_SCOPE("Pulling Init");
+  programs = scene->GetPrograms("pulledcube.vs");
+  VAO.Create(GetName());
+
+  // The views follow the buffers through reallocation, so they are set once
+  for (int sorted = 0; sorted < 2; sorted++) {
+    matrixTexture[sorted].Create(GetName());
+    glBindTexture(GL_TEXTURE_BUFFER, matrixTexture[sorted]);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, scene->InstanceBuffer(sorted));
+    materialTexture[sorted].Create(GetName());
+    glBindTexture(GL_TEXTURE_BUFFER, materialTexture[sorted]);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, scene->MaterialBuffer(sorted));
+  }
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void PullingRenderer::Render(const FrameContext &frame)
+{
+  PROFILE_SCOPE("Pulling Render");
+  size_t count = std::min(frame.objectCount, scene->GpuCount());
+  // The sorted copy holds exactly the drawn objects, nearest first
+  int sorted = scene->FrontToBack() ? 1 : 0;
+  if (sorted)
+    count = std::min(count, scene->DrawOrder().size());
+  if (count == 0)
+    return;
+
+  Shader &active = scene->UseProgram(programs, frame.stats);
+  active.setUniform("projection", frame.projection);
+  active.setUniform("view", frame.view);
+
+  glActiveTexture(GL_TEXTURE0 + CubeUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, scene->CubeVertexTexture());
+  active.setUniform("cubeVertices", CubeUnit);
+  glActiveTexture(GL_TEXTURE0 + MatrixUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, matrixTexture[sorted]);
+  active.setUniform("instanceMatrices", MatrixUnit);
+  glActiveTexture(GL_TEXTURE0 + MaterialUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, materialTexture[sorted]);
+  active.setUniform("instanceMaterials", MaterialUnit);
+  glActiveTexture(GL_TEXTURE0);
+
+  glBindVertexArray(VAO);
+  glDrawArraysInstanced(GL_TRIANGLES, 0, CubeVertexCount,
+                        static_cast<GLsizei>(count));
+
+  if (frame.stats) {
+    frame.stats->drawCalls += 1;
+    frame.stats->instances += count;
+    frame.stats->triangles += count * (CubeVertexCount / 3);
+    frame.stats->vertices += count * CubeVertexCount;
+    frame.stats->textureBinds += 3;
+    // VAO, projection, view and the three sampler uniforms
+    frame.stats->stateChanges += 6;
+  }
+}
+
+void PullingRenderer::Cleanup()
+{
+  VAO.Reset();
+  for (int sorted = 0; sorted < 2; sorted++) {
+    matrixTexture[sorted].Reset();
+    materialTexture[sorted].Reset();
+  }
+}
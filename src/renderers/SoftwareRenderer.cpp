@@ -0,0 +1,453 @@
+#include <glad/glad.h>
+#include "renderers/SoftwareRenderer.h"
+#include "core/Cube.h"
+#include "core/SceneStore.h"
+#include "tools/FrameArena.h"
+#include "tools/JobSystem.h"
+#include "tools/TextureBatcher.h"
+#include "tools/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SOFTWARE_RASTER_SSE2 1
+#endif
+
+// Objects per setup job; a cube is 12 triangles
+static constexpr size_t SetupGrain = 64;
+
+// Same clear colour as the frame loop, as packed RGBA8
+static constexpr uint32_t ClearColor = 26u | (26u << 8) | (26u << 16) | (255u << 24);
+
+// Used when the scene has no textures yet
+static const unsigned char whiteTexel[4] = {255, 255, 255, 255};
+
+static float snapToSubpixel(float value) {
+  return std::nearbyint(value * SoftwareRenderer::SubpixelSteps) /
+         SoftwareRenderer::SubpixelSteps;
+}
+
+#ifndef SOFTWARE_RASTER_SSE2
+// Pixels exactly on an edge go to the triangle that owns it, so two triangles
+// sharing an edge never both draw (or both skip) those pixels
+static bool insideEdge(float e, bool owned) {
+  return e > 0.0f || (e == 0.0f && owned);
+}
+#endif
+
+static uint32_t shadeTexel(const unsigned char *texels, int texWidth,
+                           int texHeight, const glm::vec4 &tint, float u,
+                           float v) {
+  // Nearest texel, clamped to the edge
+  int tx = std::clamp(static_cast<int>(std::floor(u * texWidth)), 0, texWidth - 1);
+  int ty = std::clamp(static_cast<int>(std::floor(v * texHeight)), 0, texHeight - 1);
+  const unsigned char *t = texels + (size_t(ty) * texWidth + tx) * 4;
+
+  auto channel = [](unsigned char value, float scale) {
+    return static_cast<uint32_t>(std::min(value * scale + 0.5f, 255.0f));
+  };
+  return channel(t[0], tint.x) | (channel(t[1], tint.y) << 8) |
+         (channel(t[2], tint.z) << 16) | (channel(t[3], tint.w) << 24);
+}
+
+void SoftwareRenderer::Init()
+{
+  PROFILE_SCOPE("Software Init");
+  colorTexture.Create(GetName());
+  readFramebuffer.Create(GetName());
+  threadBins.resize(JobSystem::Shared().ThreadCount());
+}
+
+void SoftwareRenderer::Resize(int newWidth, int newHeight)
+{
+  width = newWidth;
+  height = newHeight;
+  tilesX = (width + TileSize - 1) / TileSize;
+  tilesY = (height + TileSize - 1) / TileSize;
+  stride = tilesX * TileSize;
+  paddedHeight = tilesY * TileSize;
+
+  color.assign(size_t(stride) * paddedHeight, ClearColor);
+  depth.assign(size_t(stride) * paddedHeight, 1.0f);
+  for (ThreadBins &bins : threadBins)
+    bins.tiles.assign(size_t(tilesX) * tilesY, {});
+
+  glBindTexture(GL_TEXTURE_2D, colorTexture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  colorTexture.SetBytes(size_t(width) * height * 4);
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+  glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                         GL_TEXTURE_2D, colorTexture, 0);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+void SoftwareRenderer::Render(const FrameContext &frame)
+{
+  PROFILE_SCOPE("Software Render");
+  if (frame.viewportWidth != width || frame.viewportHeight != height)
+    Resize(frame.viewportWidth, frame.viewportHeight);
+
+  size_t count = std::min(frame.objectCount, scene->GpuCount());
+  JobSystem &jobs = JobSystem::Shared();
+
+  // Setup: transform, clip and bin. Each thread appends to its own bins and
+  // claims object blocks in increasing order, so every per-tile list is
+  // already sorted by triangle id.
+  auto setupStart = std::chrono::steady_clock::now();
+  for (ThreadBins &bins : threadBins) {
+    bins.triangles.clear();
+    for (auto &tile : bins.tiles)
+      tile.clear();
+  }
+  jobs.ParallelFor(count, SetupGrain, [&](size_t begin, size_t end) {
+    PROFILE_SCOPE("Software Setup");
+    ThreadBins &bins = threadBins[JobSystem::ThreadIndex()];
+    for (size_t i = begin; i < end; i++)
+      SetupObject(i, frame, bins);
+  });
+
+  lastTriangles = 0;
+  for (const ThreadBins &bins : threadBins)
+    lastTriangles += bins.triangles.size();
+
+  // Raster: tiles are independent, one tile per job
+  auto rasterStart = std::chrono::steady_clock::now();
+  FrameArenas &arenas = frame.arenas ? *frame.arenas : FrameArenas::Shared();
+  jobs.ParallelFor(size_t(tilesX) * tilesY, 1, [&](size_t begin, size_t end) {
+    for (size_t tile = begin; tile < end; tile++)
+      RasterTile(static_cast<int>(tile), arenas);
+  });
+  auto rasterEnd = std::chrono::steady_clock::now();
+  lastSetupMs = std::chrono::duration<double, std::milli>(rasterStart - setupStart).count();
+  lastRasterMs = std::chrono::duration<double, std::milli>(rasterEnd - rasterStart).count();
+
+  // Blit
+  PROFILE_SCOPE("Software Blit");
+  glBindTexture(GL_TEXTURE_2D, colorTexture);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, stride);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA,
+                  GL_UNSIGNED_BYTE, color.data());
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+  // Into whatever target the frame is drawn to (window or scaled target)
+  GLint target = 0;
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+  glBlitFramebuffer(0, 0, width, height, 0, 0, width, height,
+                    GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(target));
+
+  if (frame.stats) {
+    frame.stats->drawCalls += 1;
+    frame.stats->instances += count;
+    frame.stats->triangles += lastTriangles;
+    frame.stats->vertices += count * CubeVertexCount; // transformed on the CPU
+    frame.stats->textureBinds += 1;
+    frame.stats->stateChanges += 2; // framebuffer binds for the blit
+    frame.stats->uploadBytes += size_t(width) * height * sizeof(uint32_t);
+  }
+}
+
+void SoftwareRenderer::SetupObject(size_t object, const FrameContext& frame,
+                                   ThreadBins& bins)
+{
+  // Whole cubes outside the frustum skip the per-vertex transform
+  const glm::mat4 &model = scene->ModelMatrices()[object];
+  float scale = std::max({glm::length(glm::vec3(model[0])),
+                          glm::length(glm::vec3(model[1])),
+                          glm::length(glm::vec3(model[2]))});
+  if (!frame.SphereVisible(glm::vec3(model[3]), 0.8661f * scale))
+    return;
+
+  glm::mat4 mvp = frame.viewProjection * model;
+  const MaterialRecord &material =
+      scene->Materials().Record(scene->ObjectMaterial(object));
+  TextureImage image{1, 1, whiteTexel};
+  if (material.diffuseSlot < scene->Textures().SlotCount())
+    image = scene->Textures().Image(material.diffuseSlot);
+
+  for (int t = 0; t < CubeVertexCount / 3; t++) {
+    ClipVertex v[3];
+    for (int k = 0; k < 3; k++) {
+      const float *src = &cubeVertices[(t * 3 + k) * CubeVertexStride];
+      v[k].position = mvp * glm::vec4(src[0], src[1], src[2], 1.0f);
+      v[k].uv = glm::vec2(src[6], src[7]);
+    }
+
+    // Trivially outside one frustum plane
+    bool outside = false;
+    for (int axis = 0; axis < 3 && !outside; axis++) {
+      bool allBelow = true, allAbove = true;
+      for (const ClipVertex &c : v) {
+        allBelow &= c.position[axis] < -c.position.w;
+        allAbove &= c.position[axis] > c.position.w;
+      }
+      outside = allBelow || allAbove;
+    }
+    if (outside)
+      continue;
+
+    uint32_t id = static_cast<uint32_t>(object * (CubeVertexCount / 3) + t);
+    bool crossesNear = false;
+    for (const ClipVertex &c : v)
+      crossesNear |= c.position.z < -c.position.w;
+    if (!crossesNear) {
+      SetupTriangle(v, id, material.baseColor, image, bins);
+      continue;
+    }
+
+    // Clip against the near plane (z >= -w). Intersections are always
+    // computed from the inside vertex, so an edge shared by two triangles is
+    // cut at exactly the same point in both.
+    ClipVertex polygon[4];
+    int polygonSize = 0;
+    for (int k = 0; k < 3; k++) {
+      const ClipVertex &a = v[k];
+      const ClipVertex &b = v[(k + 1) % 3];
+      float da = a.position.z + a.position.w;
+      float db = b.position.z + b.position.w;
+      if (da >= 0.0f)
+        polygon[polygonSize++] = a;
+      if ((da >= 0.0f) != (db >= 0.0f)) {
+        const ClipVertex &in = da >= 0.0f ? a : b;
+        const ClipVertex &out = da >= 0.0f ? b : a;
+        float dIn = da >= 0.0f ? da : db;
+        float dOut = da >= 0.0f ? db : da;
+        float s = dIn / (dIn - dOut);
+        polygon[polygonSize].position = in.position + (out.position - in.position) * s;
+        polygon[polygonSize].uv = in.uv + (out.uv - in.uv) * s;
+        polygonSize++;
+      }
+    }
+    for (int k = 1; k + 1 < polygonSize; k++) {
+      ClipVertex fan[3] = {polygon[0], polygon[k], polygon[k + 1]};
+      SetupTriangle(fan, id, material.baseColor, image, bins);
+    }
+  }
+}
+
+void SoftwareRenderer::SetupTriangle(const ClipVertex* v, uint32_t id,
+                                     const glm::vec4& tint,
+                                     const TextureImage& image, ThreadBins& bins)
+{
+  float sx[3], sy[3], z[3], invW[3], u[3], w[3];
+  for (int k = 0; k < 3; k++) {
+    invW[k] = 1.0f / v[k].position.w;
+    sx[k] = snapToSubpixel((v[k].position.x * invW[k] * 0.5f + 0.5f) * width);
+    sy[k] = snapToSubpixel((v[k].position.y * invW[k] * 0.5f + 0.5f) * height);
+    z[k] = v[k].position.z * invW[k] * 0.5f + 0.5f;
+    u[k] = v[k].uv.x * invW[k];
+    w[k] = v[k].uv.y * invW[k];
+  }
+
+  // Two-sided like the GL strategies: clockwise triangles are flipped
+  float area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sx[2] - sx[0]) * (sy[1] - sy[0]);
+  if (area == 0.0f || !std::isfinite(area))
+    return;
+  int order[3] = {0, 1, 2};
+  if (area < 0.0f) {
+    std::swap(order[1], order[2]);
+    area = -area;
+  }
+
+  // Pixel centres (x + 0.5) inside the bounds, clamped to the screen
+  float minSx = std::min({sx[0], sx[1], sx[2]}), maxSx = std::max({sx[0], sx[1], sx[2]});
+  float minSy = std::min({sy[0], sy[1], sy[2]}), maxSy = std::max({sy[0], sy[1], sy[2]});
+  if (maxSx < 0.0f || maxSy < 0.0f || minSx > width || minSy > height)
+    return;
+  Triangle tri;
+  tri.minX = std::max(static_cast<int>(std::ceil(minSx - 0.5f)), 0);
+  tri.minY = std::max(static_cast<int>(std::ceil(minSy - 0.5f)), 0);
+  tri.maxX = std::min(static_cast<int>(std::floor(std::min(maxSx, float(width)) - 0.5f)), width - 1);
+  tri.maxY = std::min(static_cast<int>(std::floor(std::min(maxSy, float(height)) - 0.5f)), height - 1);
+  if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+    return;
+
+  tri.ownedEdges = 0;
+  for (int e = 0; e < 3; e++) {
+    int a = order[(e + 1) % 3];
+    int b = order[(e + 2) % 3];
+    tri.edgeA[e] = sy[a] - sy[b];
+    tri.edgeB[e] = sx[b] - sx[a];
+    tri.edgeC[e] = sx[a] * sy[b] - sy[a] * sx[b];
+    if (tri.edgeA[e] > 0.0f || (tri.edgeA[e] == 0.0f && tri.edgeB[e] > 0.0f))
+      tri.ownedEdges |= 1u << e;
+  }
+  tri.invArea = 1.0f / area;
+
+  int i0 = order[0], i1 = order[1], i2 = order[2];
+  auto deltas = [&](float *out, const float *values) {
+    out[0] = values[i0];
+    out[1] = values[i1] - values[i0];
+    out[2] = values[i2] - values[i0];
+  };
+  deltas(tri.z, z);
+  deltas(tri.invW, invW);
+  deltas(tri.uOverW, u);
+  deltas(tri.vOverW, w);
+  tri.tint = tint;
+  tri.texels = image.rgba;
+  tri.texWidth = image.width;
+  tri.texHeight = image.height;
+  tri.id = id;
+
+  uint32_t index = static_cast<uint32_t>(bins.triangles.size());
+  bins.triangles.push_back(tri);
+  for (int ty = tri.minY / TileSize; ty <= tri.maxY / TileSize; ty++) {
+    for (int tx = tri.minX / TileSize; tx <= tri.maxX / TileSize; tx++)
+      bins.tiles[size_t(ty) * tilesX + tx].push_back(index);
+  }
+}
+
+void SoftwareRenderer::RasterTile(int tile, FrameArenas& arenas)
+{
+  PROFILE_SCOPE("Software Tile");
+  int x0 = (tile % tilesX) * TileSize;
+  int y0 = (tile / tilesX) * TileSize;
+  int x1 = x0 + TileSize - 1;
+  int y1 = y0 + TileSize - 1;
+
+  for (int y = y0; y <= y1; y++) {
+    std::fill_n(&color[size_t(y) * stride + x0], TileSize, ClearColor);
+    std::fill_n(&depth[size_t(y) * stride + x0], TileSize, 1.0f);
+  }
+
+  // Merge the per-thread lists back into scene order
+  size_t threads = threadBins.size();
+  size_t *cursor = arenas.Local().AllocateArray<size_t>(threads);
+  std::fill_n(cursor, threads, 0);
+  for (;;) {
+    const Triangle *next = nullptr;
+    size_t nextThread = 0;
+    for (size_t t = 0; t < threads; t++) {
+      const std::vector<uint32_t> &list = threadBins[t].tiles[tile];
+      if (cursor[t] == list.size())
+        continue;
+      const Triangle &candidate = threadBins[t].triangles[list[cursor[t]]];
+      if (!next || candidate.id < next->id) {
+        next = &candidate;
+        nextThread = t;
+      }
+    }
+    if (!next)
+      break;
+    cursor[nextThread]++;
+    RasterTriangle(*next, x0, y0, x1, y1);
+  }
+}
+
+void SoftwareRenderer::RasterTriangle(const Triangle& tri, int x0, int y0,
+                                      int x1, int y1)
+{
+  // Four pixel columns per step; tiles are multiples of four wide and the
+  // buffers are padded to whole tiles, so a step never leaves the tile
+  int minX = std::max(tri.minX, x0) & ~3;
+  int maxX = std::min(tri.maxX, x1);
+  int minY = std::max(tri.minY, y0);
+  int maxY = std::min(tri.maxY, y1);
+
+  bool owned[3] = {(tri.ownedEdges & 1u) != 0, (tri.ownedEdges & 2u) != 0,
+                   (tri.ownedEdges & 4u) != 0};
+
+  for (int y = minY; y <= maxY; y++) {
+    float py = static_cast<float>(y) + 0.5f;
+    float rowE[3];
+    for (int e = 0; e < 3; e++)
+      rowE[e] = tri.edgeB[e] * py + tri.edgeC[e];
+    uint32_t *colorRow = &color[size_t(y) * stride];
+    float *depthRow = &depth[size_t(y) * stride];
+
+    for (int x = minX; x <= maxX; x += 4) {
+      float u[4], v[4];
+      int covered = 0;
+
+#ifdef SOFTWARE_RASTER_SSE2
+      const __m128 zero = _mm_setzero_ps();
+      __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)),
+                             _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+      __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+      __m128 edge[3];
+      for (int e = 0; e < 3; e++) {
+        edge[e] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.edgeA[e]), px),
+                             _mm_set1_ps(rowE[e]));
+        __m128 pass = _mm_cmpgt_ps(edge[e], zero);
+        if (owned[e])
+          pass = _mm_or_ps(pass, _mm_cmpeq_ps(edge[e], zero));
+        inside = _mm_and_ps(inside, pass);
+      }
+      if (_mm_movemask_ps(inside) == 0)
+        continue;
+
+      __m128 invArea = _mm_set1_ps(tri.invArea);
+      __m128 b1 = _mm_mul_ps(edge[1], invArea);
+      __m128 b2 = _mm_mul_ps(edge[2], invArea);
+      auto interpolate = [&](const float *a) {
+        return _mm_add_ps(
+            _mm_add_ps(_mm_set1_ps(a[0]), _mm_mul_ps(b1, _mm_set1_ps(a[1]))),
+            _mm_mul_ps(b2, _mm_set1_ps(a[2])));
+      };
+
+      __m128 z = interpolate(tri.z);
+      __m128 stored = _mm_loadu_ps(depthRow + x);
+      __m128 pass = _mm_and_ps(inside, _mm_cmplt_ps(z, stored));
+      covered = _mm_movemask_ps(pass);
+      if (covered == 0)
+        continue;
+      _mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(pass, z),
+                                            _mm_andnot_ps(pass, stored)));
+
+      __m128 invW = interpolate(tri.invW);
+      _mm_storeu_ps(u, _mm_div_ps(interpolate(tri.uOverW), invW));
+      _mm_storeu_ps(v, _mm_div_ps(interpolate(tri.vOverW), invW));
+#else
+      for (int k = 0; k < 4; k++) {
+        float px = static_cast<float>(x + k) + 0.5f;
+        float edge[3];
+        bool inside = true;
+        for (int e = 0; e < 3; e++) {
+          edge[e] = tri.edgeA[e] * px + rowE[e];
+          inside &= insideEdge(edge[e], owned[e]);
+        }
+        if (!inside)
+          continue;
+
+        float b1 = edge[1] * tri.invArea;
+        float b2 = edge[2] * tri.invArea;
+        auto interpolate = [&](const float *a) {
+          return (a[0] + b1 * a[1]) + b2 * a[2];
+        };
+        float z = interpolate(tri.z);
+        if (!(z < depthRow[x + k]))
+          continue;
+        depthRow[x + k] = z;
+        covered |= 1 << k;
+
+        float invW = interpolate(tri.invW);
+        u[k] = interpolate(tri.uOverW) / invW;
+        v[k] = interpolate(tri.vOverW) / invW;
+      }
+#endif
+
+      for (int k = 0; k < 4; k++) {
+        if (covered & (1 << k))
+          colorRow[x + k] = shadeTexel(tri.texels, tri.texWidth, tri.texHeight,
+                                       tri.tint, u[k], v[k]);
+      }
+    }
+  }
+}
+
+void SoftwareRenderer::Cleanup()
+{
+  colorTexture.Reset();
+  readFramebuffer.Reset();
+  color.clear();
+  depth.clear();
+  threadBins.clear();
+  width = height = 0;
+}
@@ -0,0 +1,97 @@
+#include "tools/AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> allocationCount{0};
+std::atomic<uint64_t> allocationBytes{0};
+
+void *countedAlloc(std::size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  allocationBytes.fetch_add(size, std::memory_order_relaxed);
+  return std::malloc(size ? size : 1);
+}
+
+void *countedAlignedAlloc(std::size_t size, std::align_val_t alignment) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  allocationBytes.fetch_add(size, std::memory_order_relaxed);
+  std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+  return _aligned_malloc(size ? size : 1, align);
+#else
+  // aligned_alloc wants the size to be a multiple of the alignment
+  std::size_t rounded = ((size ? size : 1) + align - 1) / align * align;
+  return std::aligned_alloc(align, rounded);
+#endif
+}
+
+void alignedFree(void *ptr) {
+#ifdef _WIN32
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+} // namespace
+
+namespace AllocationCounter {
+
+uint64_t Count() { return allocationCount.load(std::memory_order_relaxed); }
+uint64_t Bytes() { return allocationBytes.load(std::memory_order_relaxed); }
+
+} // namespace AllocationCounter
+
+// --------------------------------------------------------
+// Global operator new/delete replacements
+// --------------------------------------------------------
+
+void *operator new(std::size_t size) {
+  if (void *ptr = countedAlloc(size))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+  if (void *ptr = countedAlloc(size))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return countedAlloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return countedAlloc(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  if (void *ptr = countedAlignedAlloc(size, alignment))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  if (void *ptr = countedAlignedAlloc(size, alignment))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { alignedFree(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { alignedFree(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+  alignedFree(ptr);
+}
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+  alignedFree(ptr);
+}
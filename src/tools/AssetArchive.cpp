@@ -0,0 +1,370 @@
+#include "tools/AssetArchive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+namespace fs = std::filesystem;
+
+static_assert(std::is_trivially_copyable_v<AssetArchive::Header>);
+static_assert(std::is_trivially_copyable_v<AssetArchive::Entry>);
+
+namespace {
+
+// LZ4 block constraints: the last 5 bytes are always literals and the last
+// match starts at least 12 bytes before the end
+constexpr size_t MinMatch = 4;
+constexpr size_t LastLiterals = 5;
+constexpr size_t MatchFindLimit = 12;
+constexpr size_t MaxOffset = 65535;
+constexpr int HashBits = 14;
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// count items of stride bytes at offset lie inside size bytes, written as
+// subtractions so values read from the archive cannot wrap past the check
+bool fitsIn(uint64_t offset, uint64_t count, uint64_t stride, uint64_t size) {
+  return offset <= size && count <= (size - offset) / stride;
+}
+
+uint32_t read32(const uint8_t *p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+void writeLength(std::vector<uint8_t> &out, size_t length) {
+  while (length >= 255) {
+    out.push_back(255);
+    length -= 255;
+  }
+  out.push_back(static_cast<uint8_t>(length));
+}
+
+void emitSequence(std::vector<uint8_t> &out, const uint8_t *literals,
+                  size_t literalLength, size_t offset, size_t matchLength) {
+  size_t matchCode = matchLength >= MinMatch ? matchLength - MinMatch : 0;
+  uint8_t token = static_cast<uint8_t>(std::min<size_t>(literalLength, 15) << 4);
+  if (matchLength >= MinMatch)
+    token |= static_cast<uint8_t>(std::min<size_t>(matchCode, 15));
+  out.push_back(token);
+  if (literalLength >= 15)
+    writeLength(out, literalLength - 15);
+  out.insert(out.end(), literals, literals + literalLength);
+
+  // The final sequence is literals only
+  if (matchLength < MinMatch)
+    return;
+  out.push_back(static_cast<uint8_t>(offset & 0xff));
+  out.push_back(static_cast<uint8_t>(offset >> 8));
+  if (matchCode >= 15)
+    writeLength(out, matchCode - 15);
+}
+
+bool readLength(const uint8_t *src, size_t srcSize, size_t &ip, size_t &length) {
+  uint8_t b;
+  do {
+    if (ip >= srcSize)
+      return false;
+    b = src[ip++];
+    length += b;
+  } while (b == 255);
+  return true;
+}
+
+std::string normalizePath(std::string_view path) {
+  std::string out(path);
+  std::replace(out.begin(), out.end(), '\\', '/');
+  while (out.rfind("./", 0) == 0)
+    out.erase(0, 2);
+  return out;
+}
+
+} // namespace
+
+uint64_t AssetArchive::HashPath(std::string_view path) {
+  uint64_t hash = 1469598103934665603ull;
+  for (char c : path) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+void AssetArchive::Lz4Compress(const uint8_t *src, size_t size,
+                               std::vector<uint8_t> &out) {
+  out.clear();
+  out.reserve(size + size / 255 + 16);
+
+  // Greedy single-probe matcher; positions are stored +1 so 0 means empty
+  std::vector<uint32_t> table(size_t(1) << HashBits, 0);
+  size_t anchor = 0;
+  size_t i = 0;
+  while (i + MatchFindLimit <= size) {
+    uint32_t sequence = read32(src + i);
+    uint32_t h = (sequence * 2654435761u) >> (32 - HashBits);
+    size_t candidate = table[h];
+    table[h] = static_cast<uint32_t>(i + 1);
+
+    if (candidate == 0 || i - (candidate - 1) > MaxOffset ||
+        read32(src + candidate - 1) != sequence) {
+      i++;
+      continue;
+    }
+
+    size_t ref = candidate - 1;
+    size_t length = MinMatch;
+    while (i + length < size - LastLiterals && src[ref + length] == src[i + length])
+      length++;
+
+    emitSequence(out, src + anchor, i - anchor, i - ref, length);
+    i += length;
+    anchor = i;
+  }
+  emitSequence(out, src + anchor, size - anchor, 0, 0);
+}
+
+bool AssetArchive::Lz4Decompress(const uint8_t *src, size_t srcSize,
+                                 uint8_t *dst, size_t dstSize) {
+  size_t ip = 0, op = 0;
+  while (ip < srcSize) {
+    uint8_t token = src[ip++];
+
+    size_t literals = token >> 4;
+    if (literals == 15 && !readLength(src, srcSize, ip, literals))
+      return false;
+    if (literals > srcSize - ip || literals > dstSize - op)
+      return false;
+    if (literals > 0)
+      std::memcpy(dst + op, src + ip, literals);
+    ip += literals;
+    op += literals;
+    if (ip == srcSize)
+      break;
+
+    if (srcSize - ip < 2)
+      return false;
+    size_t offset = size_t(src[ip]) | size_t(src[ip + 1]) << 8;
+    ip += 2;
+    if (offset == 0 || offset > op)
+      return false;
+
+    size_t length = token & 15;
+    if (length == 15 && !readLength(src, srcSize, ip, length))
+      return false;
+    length += MinMatch;
+    if (length > dstSize - op)
+      return false;
+
+    // Matches may overlap their own output, so copy forwards bytewise
+    const uint8_t *match = dst + op - offset;
+    for (size_t k = 0; k < length; k++)
+      dst[op + k] = match[k];
+    op += length;
+  }
+  return op == dstSize;
+}
+
+bool AssetArchive::Build(const std::string &path, const std::string &root,
+                         bool compress) {
+  struct Pending {
+    std::string path;
+    std::vector<uint8_t> blob;
+    Entry entry{};
+  };
+
+  std::error_code ec;
+  if (!fs::is_directory(root, ec)) {
+    std::cerr << "Asset root is not a directory: " << root << "\n";
+    return false;
+  }
+
+  // The archive may be written inside the root; never pack an old copy of it
+  fs::path output = fs::weakly_canonical(path, ec);
+
+  std::vector<Pending> files;
+  std::vector<uint8_t> raw, packed;
+  uint64_t rawTotal = 0;
+  for (const fs::directory_entry &item : fs::recursive_directory_iterator(root)) {
+    if (!item.is_regular_file())
+      continue;
+    if (fs::weakly_canonical(item.path(), ec) == output)
+      continue;
+
+    std::ifstream in(item.path(), std::ios::binary);
+    if (!in.is_open()) {
+      std::cerr << "Could not read asset: " << item.path().string() << "\n";
+      return false;
+    }
+    if (item.file_size() > MaxEntrySize) {
+      std::cerr << "Asset is too large to pack: " << item.path().string() << "\n";
+      return false;
+    }
+    raw.resize(static_cast<size_t>(item.file_size()));
+    in.read(reinterpret_cast<char *>(raw.data()),
+            static_cast<std::streamsize>(raw.size()));
+
+    Pending file;
+    file.path = normalizePath(fs::relative(item.path(), root).generic_string());
+    file.entry.pathHash = HashPath(file.path);
+    file.entry.size = raw.size();
+    if (compress && raw.size() >= 64) {
+      Lz4Compress(raw.data(), raw.size(), packed);
+      if (packed.size() <= raw.size() - raw.size() / 8) {
+        file.blob = packed;
+        file.entry.flags |= Compressed;
+      }
+    }
+    if (file.blob.empty())
+      file.blob = raw;
+    file.entry.storedSize = file.blob.size();
+    rawTotal += raw.size();
+    files.push_back(std::move(file));
+  }
+
+  std::sort(files.begin(), files.end(), [](const Pending &a, const Pending &b) {
+    return a.entry.pathHash != b.entry.pathHash ? a.entry.pathHash < b.entry.pathHash
+                                                : a.path < b.path;
+  });
+
+  Header header{};
+  header.magic = Magic;
+  header.version = Version;
+  header.entryCount = static_cast<uint32_t>(files.size());
+  header.entryTableOffset = sizeof(Header);
+  header.stringsOffset = header.entryTableOffset + files.size() * sizeof(Entry);
+
+  uint64_t offset = 0;
+  for (Pending &file : files) {
+    file.entry.pathOffset = static_cast<uint32_t>(offset);
+    file.entry.pathLength = static_cast<uint32_t>(file.path.size());
+    offset += file.path.size();
+  }
+  header.stringsSize = offset;
+
+  offset = header.stringsOffset + header.stringsSize;
+  for (Pending &file : files) {
+    offset = alignUp(offset, BlobAlignment);
+    file.entry.offset = offset;
+    offset += file.entry.storedSize;
+  }
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    std::cerr << "Could not write asset archive: " << path << "\n";
+    return false;
+  }
+
+  uint64_t written = 0;
+  auto write = [&](const void *data, uint64_t size) {
+    out.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    written += size;
+  };
+  auto padTo = [&](uint64_t target) {
+    static const char zeros[BlobAlignment] = {};
+    while (written < target)
+      write(zeros, std::min<uint64_t>(target - written, sizeof(zeros)));
+  };
+
+  write(&header, sizeof(header));
+  for (const Pending &file : files)
+    write(&file.entry, sizeof(Entry));
+  for (const Pending &file : files)
+    write(file.path.data(), file.path.size());
+  for (const Pending &file : files) {
+    padTo(file.entry.offset);
+    write(file.blob.data(), file.blob.size());
+  }
+
+  if (!out.good()) {
+    std::cerr << "Failed while writing asset archive: " << path << "\n";
+    return false;
+  }
+
+  std::cout << "SUCCESS::ASSETS::PACKED::" << path << " (" << files.size()
+            << " files, " << rawTotal << " -> " << written << " bytes)"
+            << std::endl;
+  return true;
+}
+
+// --------------------------------------------------------
+// ArchiveReader
+// --------------------------------------------------------
+
+bool ArchiveReader::Open(const std::string &path) {
+  using namespace AssetArchive;
+  Close();
+  if (!file.Open(path))
+    return false;
+
+  auto reject = [&](const char *reason) {
+    std::cerr << "Asset archive " << path << ": " << reason << "\n";
+    file.Close();
+    return false;
+  };
+
+  if (file.Size() < sizeof(Header))
+    return reject("too small");
+  const Header *h = reinterpret_cast<const Header *>(file.Data());
+  if (h->magic != Magic || h->version != Version)
+    return reject("not a supported archive");
+  if (!fitsIn(h->entryTableOffset, h->entryCount, sizeof(Entry), file.Size()) ||
+      !fitsIn(h->stringsOffset, h->stringsSize, 1, file.Size()))
+    return reject("index is truncated");
+
+  const Entry *table =
+      reinterpret_cast<const Entry *>(file.Data() + h->entryTableOffset);
+  for (uint32_t i = 0; i < h->entryCount; i++) {
+    const Entry &e = table[i];
+    if (!fitsIn(e.offset, e.storedSize, 1, file.Size()) ||
+        !fitsIn(e.pathOffset, e.pathLength, 1, h->stringsSize))
+      return reject("entry points outside the file");
+    // size becomes an allocation when the entry is opened
+    if (e.size > MaxEntrySize || e.size / MaxExpansion > e.storedSize)
+      return reject("entry has an implausible size");
+    if (i > 0 && e.pathHash < table[i - 1].pathHash)
+      return reject("index is not sorted");
+    if (!(e.flags & Compressed) && e.storedSize != e.size)
+      return reject("stored entry has the wrong size");
+  }
+
+  header = h;
+  entries = table;
+  strings = reinterpret_cast<const char *>(file.Data() + h->stringsOffset);
+  std::cout << "SUCCESS::ASSETS::MOUNTED::" << path << " (" << h->entryCount
+            << " files)" << std::endl;
+  return true;
+}
+
+void ArchiveReader::Close() {
+  file.Close();
+  header = nullptr;
+  entries = nullptr;
+  strings = nullptr;
+}
+
+std::string_view ArchiveReader::Path(const AssetArchive::Entry &entry) const {
+  return {strings + entry.pathOffset, entry.pathLength};
+}
+
+const AssetArchive::Entry *ArchiveReader::Find(std::string_view path) const {
+  if (!header)
+    return nullptr;
+
+  std::string key = normalizePath(path);
+  uint64_t hash = AssetArchive::HashPath(key);
+  const AssetArchive::Entry *end = entries + header->entryCount;
+  const AssetArchive::Entry *it = std::lower_bound(
+      entries, end, hash,
+      [](const AssetArchive::Entry &e, uint64_t h) { return e.pathHash < h; });
+  for (; it != end && it->pathHash == hash; ++it) {
+    if (Path(*it) == key)
+      return it;
+  }
+  return nullptr;
+}
@@ -0,0 +1,270 @@
+#include "tools/AutoStrategy.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// --------------------------------------------------------
+// StrategyCostModel
+// --------------------------------------------------------
+
+void StrategyCostModel::Add(double count, double costMs, double decay) {
+  weight = weight * decay + 1.0;
+  sumN = sumN * decay + count;
+  sumC = sumC * decay + costMs;
+  sumNN = sumNN * decay + count * count;
+  sumNC = sumNC * decay + count * costMs;
+  minCount = weight > 1.0 ? std::min(minCount, count) : count;
+  maxCount = weight > 1.0 ? std::max(maxCount, count) : count;
+}
+
+bool StrategyCostModel::Covers(double count, double tolerance) const {
+  return !Empty() && count >= minCount * (1.0 - tolerance) &&
+         count <= maxCount * (1.0 + tolerance);
+}
+
+double StrategyCostModel::Predict(double count) const {
+  if (Empty())
+    return -1.0;
+  double meanN = sumN / weight;
+  double meanC = sumC / weight;
+  double variance = sumNN / weight - meanN * meanN;
+
+  // A slope needs counts at least 10% apart; a negative one is noise
+  double spread = 0.1 * meanN;
+  if (variance > spread * spread) {
+    double slope = (sumNC / weight - meanN * meanC) / variance;
+    if (slope >= 0.0)
+      return std::max(meanC + slope * (count - meanN), 0.0);
+  }
+  return meanN > 0.0 ? meanC * count / meanN : meanC;
+}
+
+// --------------------------------------------------------
+// AutoStrategy
+// --------------------------------------------------------
+
+void AutoStrategy::Start(const AutoStrategySettings &newSettings,
+                         const std::vector<int> &strategyIndices,
+                         const char *const *strategyNames, int current,
+                         int objectCount) {
+  settings = newSettings;
+  candidates = strategyIndices;
+  names.clear();
+  int maxIndex = 0;
+  for (int index : candidates)
+    maxIndex = std::max(maxIndex, index);
+  maxIndex = std::max(maxIndex, current);
+  for (int i = 0; i <= maxIndex; i++)
+    names.emplace_back(strategyNames[i]);
+  models.assign(candidates.size(), StrategyCostModel{});
+  decisions.clear();
+
+  running = !candidates.empty();
+  if (!running)
+    return;
+  reviewCount = 0;
+  recentMs = 0.0;
+  strategy = current;
+  // Measure the current strategy first if it is a candidate
+  pending = candidates;
+  auto at = std::find(pending.begin(), pending.end(), current);
+  if (at != pending.end())
+    std::rotate(pending.begin(), at, at + 1);
+  if (pending.front() != current) {
+    SwitchTo(pending.front(), 0, objectCount, "explore");
+    return;
+  }
+  skip = 0;
+  dwell = 0;
+  sinceReview = 0;
+}
+
+int AutoStrategy::CandidateSlot(int strategyIndex) const {
+  for (size_t i = 0; i < candidates.size(); i++) {
+    if (candidates[i] == strategyIndex)
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+void AutoStrategy::SwitchTo(int next, uint64_t frame, int objectCount,
+                            const char *reason) {
+  AutoDecision decision;
+  decision.frame = frame;
+  decision.objectCount = objectCount;
+  decision.from = strategy;
+  decision.to = next;
+  decision.reason = reason;
+  decision.measuredMs = recentMs;
+  for (const StrategyCostModel &model : models)
+    decision.predictedMs.push_back(model.Predict(objectCount));
+
+  std::cout << "AUTO::" << reason << "::" << names[strategy] << " -> "
+            << names[next] << " at " << objectCount << " objects (measured "
+            << recentMs << " ms";
+  for (size_t i = 0; i < candidates.size(); i++) {
+    if (decision.predictedMs[i] >= 0.0)
+      std::cout << ", " << names[candidates[i]] << " " << decision.predictedMs[i];
+  }
+  std::cout << ")" << std::endl;
+  decisions.push_back(std::move(decision));
+
+  skip = next != strategy ? settings.warmupFrames : 0;
+  strategy = next;
+  dwell = 0;
+  sinceReview = 0;
+  recentMs = 0.0;
+}
+
+void AutoStrategy::Update(uint64_t frame, int drawnStrategy, int objectCount,
+                          double cpuMs, double gpuMs) {
+  // Frames still in flight from before a switch do not count
+  if (!running || drawnStrategy != strategy)
+    return;
+  if (skip > 0) {
+    skip--;
+    return;
+  }
+
+  // The slower side bounds a pipelined frame
+  double cost = std::max(cpuMs, gpuMs);
+  int slot = CandidateSlot(strategy);
+  if (slot >= 0)
+    models[slot].Add(objectCount, cost, settings.decay);
+  recentMs = dwell == 0 ? cost : recentMs * 0.9 + cost * 0.1;
+  dwell++;
+  sinceReview++;
+
+  if (!pending.empty()) {
+    if (dwell < settings.exploreFrames)
+      return;
+    pending.erase(pending.begin());
+    if (!pending.empty()) {
+      SwitchTo(pending.front(), frame, objectCount, "explore");
+      return;
+    }
+    // Straight to the cheapest of what was just measured
+    reviewCount = objectCount;
+    sinceReview = 0;
+    int best = Cheapest(objectCount);
+    if (best >= 0)
+      SwitchTo(best, frame, objectCount, "choose");
+    return;
+  }
+
+  // Compare only when the workload moved or the review timer ran out, and
+  // never before the dwell time
+  bool moved = std::abs(objectCount - reviewCount) >
+               settings.workloadChange * std::max(reviewCount, 1);
+  if (!moved && sinceReview < settings.reviewFrames)
+    return;
+  if (dwell < settings.minDwellFrames)
+    return;
+  reviewCount = objectCount;
+  sinceReview = 0;
+
+  // A model only extrapolates so far; strategies never measured near this
+  // count are measured again before anything is compared
+  for (size_t i = 0; i < candidates.size(); i++) {
+    if (candidates[i] != strategy &&
+        !models[i].Covers(objectCount, settings.workloadChange))
+      pending.push_back(candidates[i]);
+  }
+  if (!pending.empty()) {
+    pending.push_back(strategy); // measured last so the round ends where it began
+    SwitchTo(pending.front(), frame, objectCount, "explore");
+    return;
+  }
+
+  int best = Cheapest(objectCount);
+  double currentMs = slot >= 0 ? models[slot].Predict(objectCount) : recentMs;
+  if (best >= 0 && best != strategy &&
+      models[CandidateSlot(best)].Predict(objectCount) <
+          currentMs * (1.0 - settings.hysteresis))
+    SwitchTo(best, frame, objectCount, "cheaper");
+}
+
+int AutoStrategy::Cheapest(int objectCount) const {
+  int best = -1;
+  double bestMs = 0.0;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    double predicted = models[i].Predict(objectCount);
+    if (predicted >= 0.0 && (best < 0 || predicted < bestMs)) {
+      best = candidates[i];
+      bestMs = predicted;
+    }
+  }
+  return best;
+}
+
+void AutoStrategy::DrawImGui() const {
+  if (running)
+    ImGui::Text("Auto: %s%s, %.3f ms recent", names[strategy].c_str(),
+                Exploring() ? " (exploring)" : "", recentMs);
+  if (!candidates.empty() &&
+      ImGui::BeginTable("##models", 3,
+                        ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+    ImGui::TableSetupColumn("Strategy");
+    ImGui::TableSetupColumn("Predicted");
+    ImGui::TableSetupColumn("Counts seen");
+    ImGui::TableHeadersRow();
+    int count = reviewCount > 0 ? reviewCount : 1;
+    for (size_t i = 0; i < candidates.size(); i++) {
+      const StrategyCostModel &model = models[i];
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(names[candidates[i]].c_str());
+      ImGui::TableNextColumn();
+      if (model.Empty()) {
+        ImGui::TextDisabled("-");
+        ImGui::TableNextColumn();
+        continue;
+      }
+      ImGui::Text("%.3f ms", model.Predict(count));
+      ImGui::TableNextColumn();
+      ImGui::Text("%.0f - %.0f", model.MinCount(), model.MaxCount());
+    }
+    ImGui::EndTable();
+  }
+
+  if (decisions.empty() || !ImGui::TreeNode("Decisions", "Decisions (%zu)",
+                                            decisions.size()))
+    return;
+  // Newest first
+  for (size_t i = decisions.size(); i-- > 0;) {
+    const AutoDecision &d = decisions[i];
+    ImGui::Text("#%llu %s: %s -> %s at %d objects, %.3f ms",
+                static_cast<unsigned long long>(d.frame), d.reason,
+                names[d.from].c_str(), names[d.to].c_str(), d.objectCount,
+                d.measuredMs);
+  }
+  ImGui::TreePop();
+}
+
+void AutoStrategy::WriteJson(std::ostream &os) const {
+  os << "{\n    \"hysteresis\": " << settings.hysteresis
+     << ",\n    \"minDwellFrames\": " << settings.minDwellFrames
+     << ",\n    \"workloadChange\": " << settings.workloadChange
+     << ",\n    \"current\": \"" << (names.empty() ? "" : names[strategy])
+     << "\",\n    \"decisions\": [";
+  for (size_t i = 0; i < decisions.size(); i++) {
+    const AutoDecision &d = decisions[i];
+    os << (i ? "," : "") << "\n      {\"frame\": " << d.frame
+       << ", \"reason\": \"" << d.reason << "\", \"from\": \"" << names[d.from]
+       << "\", \"to\": \"" << names[d.to] << "\", \"objectCount\": " << d.objectCount
+       << ", \"measuredMs\": " << d.measuredMs << ", \"predictedMs\": {";
+    bool first = true;
+    for (size_t c = 0; c < candidates.size() && c < d.predictedMs.size(); c++) {
+      if (d.predictedMs[c] < 0.0)
+        continue;
+      os << (first ? "" : ", ") << "\"" << names[candidates[c]]
+         << "\": " << d.predictedMs[c];
+      first = false;
+    }
+    os << "}}";
+  }
+  os << (decisions.empty() ? "]" : "\n    ]") << "\n  }";
+}
@@ -0,0 +1,252 @@
+#include "tools/BottleneckClassifier.h"
+#include "tools/FrameStats.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+const char *const ProbeNames[BottleneckResult::ProbeCount] = {
+    "Baseline", "Low resolution", "Vertex load", "Fewer objects"};
+
+float median(std::vector<float> &samples) {
+  return ComputePercentiles(samples).p50;
+}
+
+} // namespace
+
+const char *BottleneckName(Bottleneck bottleneck) {
+  switch (bottleneck) {
+  case Bottleneck::Submission:
+    return "submission-bound";
+  case Bottleneck::Vertex:
+    return "vertex-bound";
+  case Bottleneck::Fragment:
+    return "fragment-bound";
+  default:
+    return "unclear";
+  }
+}
+
+void BottleneckClassifier::Start(const BottleneckSettings &newSettings,
+                                 const std::vector<int> &strategyIndices,
+                                 const char *const *strategyNames, int count,
+                                 int windowWidth, int windowHeight) {
+  settings = newSettings;
+  settings.measureFrames = std::max(settings.measureFrames, 8);
+  settings.lowScale = std::clamp(settings.lowScale, 0.1f, 0.9f);
+  strategies = strategyIndices;
+  names.clear();
+  for (int index : strategies)
+    names.emplace_back(strategyNames[index]);
+  objectCount = std::max(count, 2);
+  width = windowWidth;
+  height = windowHeight;
+
+  current = 0;
+  running = !strategies.empty();
+  if (!running)
+    return;
+  results.emplace_back();
+  results.back().strategy = names[current];
+  BeginProbe(BottleneckResult::Baseline, settings.switchWarmupFrames);
+}
+
+void BottleneckClassifier::Stop() {
+  // A half-measured result says nothing
+  if (running && !results.empty())
+    results.pop_back();
+  running = false;
+}
+
+void BottleneckClassifier::BeginProbe(int newProbe, int warmup) {
+  probe = newProbe;
+  skip = warmup;
+  frameSamples.clear();
+  cpuSamples.clear();
+  gpuSamples.clear();
+}
+
+int BottleneckClassifier::Count() const {
+  if (running && probe == BottleneckResult::Objects)
+    return std::max(1, static_cast<int>(std::lround(objectCount * settings.countFraction)));
+  return objectCount;
+}
+
+float BottleneckClassifier::RenderScale() const {
+  return running && probe == BottleneckResult::Resolution ? settings.lowScale : 1.0f;
+}
+
+int BottleneckClassifier::VertexWork() const {
+  return running && probe == BottleneckResult::VertexLoad ? settings.vertexWork : 0;
+}
+
+void BottleneckClassifier::Update(float frameMs, float cpuMs, float gpuMs) {
+  if (!running)
+    return;
+  if (skip > 0) {
+    skip--;
+    return;
+  }
+  frameSamples.push_back(frameMs);
+  cpuSamples.push_back(cpuMs);
+  gpuSamples.push_back(gpuMs);
+  if (frameSamples.size() >= static_cast<size_t>(settings.measureFrames))
+    FinishProbe();
+}
+
+void BottleneckClassifier::FinishProbe() {
+  BottleneckResult &result = results.back();
+  BottleneckSample &sample = result.probes[probe];
+  sample.frameMs = median(frameSamples);
+  sample.cpuMs = median(cpuSamples);
+  sample.gpuMs = median(gpuSamples);
+
+  if (probe + 1 < BottleneckResult::ProbeCount) {
+    BeginProbe(probe + 1, settings.warmupFrames);
+    return;
+  }
+
+  result.objectCount = objectCount;
+  result.width = width;
+  result.height = height;
+  Classify(result);
+  std::cout << "BOTTLENECK::" << result.strategy << "::" << BottleneckName(result.label)
+            << " (submission " << result.submission << ", vertex " << result.vertex
+            << ", fragment " << result.fragment << ")" << std::endl;
+
+  current++;
+  if (current >= strategies.size()) {
+    running = false;
+    return;
+  }
+  results.emplace_back();
+  results.back().strategy = names[current];
+  BeginProbe(BottleneckResult::Baseline, settings.switchWarmupFrames);
+}
+
+void BottleneckClassifier::Classify(BottleneckResult &result) const {
+  const BottleneckSample &base = result.probes[BottleneckResult::Baseline];
+  const BottleneckSample &lowRes = result.probes[BottleneckResult::Resolution];
+  const BottleneckSample &heavy = result.probes[BottleneckResult::VertexLoad];
+  const BottleneckSample &fewer = result.probes[BottleneckResult::Objects];
+  auto unit = [](float v) { return std::isfinite(v) ? std::clamp(v, 0.0f, 1.0f) : 0.0f; };
+
+  float gpu = std::max(base.gpuMs, 1e-3f);
+  result.submission = unit(base.cpuMs / gpu);
+  // Fragment work scales with the pixel count, so a fully fragment-bound
+  // scene would lose 1 - scale^2 of its GPU time
+  float pixelDrop = 1.0f - settings.lowScale * settings.lowScale;
+  result.fragment = unit((base.gpuMs - lowRes.gpuMs) / (pixelDrop * gpu));
+  result.vertex = unit((heavy.gpuMs - base.gpuMs) / gpu);
+
+  // CPU submission at least as long as the GPU's work: the GPU waits on
+  // draws. Only trusted if the frame got shorter along with the submission
+  // when objects were removed; otherwise something else (the main thread,
+  // presentation) sets the pace.
+  float cpuSaved = base.cpuMs - fewer.cpuMs;
+  float frameSaved = base.frameMs - fewer.frameMs;
+  if (result.submission >= 1.0f) {
+    result.label = cpuSaved > 0.0f && frameSaved >= 0.5f * cpuSaved
+                       ? Bottleneck::Submission
+                       : Bottleneck::Unknown;
+    return;
+  }
+
+  if (std::max(result.fragment, result.vertex) < settings.threshold)
+    result.label = Bottleneck::Unknown;
+  else
+    result.label = result.fragment >= result.vertex ? Bottleneck::Fragment
+                                                    : Bottleneck::Vertex;
+}
+
+const char *BottleneckClassifier::Phase() const {
+  if (!running)
+    return "Idle";
+  if (skip > 0)
+    return "Warm-up";
+  return ProbeNames[probe];
+}
+
+float BottleneckClassifier::Progress() const {
+  if (strategies.empty())
+    return 0.0f;
+  return (current * BottleneckResult::ProbeCount + (running ? probe : 0)) /
+         static_cast<float>(strategies.size() * BottleneckResult::ProbeCount);
+}
+
+const BottleneckResult *BottleneckClassifier::Latest(const char *strategy) const {
+  size_t finished = running ? results.size() - 1 : results.size();
+  for (size_t i = finished; i-- > 0;) {
+    if (results[i].strategy == strategy)
+      return &results[i];
+  }
+  return nullptr;
+}
+
+void BottleneckClassifier::DrawImGui() const {
+  size_t finished = running ? results.size() - 1 : results.size();
+  for (size_t i = 0; i < finished; i++) {
+    const BottleneckResult &result = results[i];
+    ImGui::PushID(static_cast<int>(i));
+    if (!ImGui::TreeNode("##result", "%s, %d objects at %dx%d: %s",
+                         result.strategy.c_str(), result.objectCount, result.width,
+                         result.height, BottleneckName(result.label))) {
+      ImGui::PopID();
+      continue;
+    }
+
+    ImGui::Text("Scores: submission %.2f, vertex %.2f, fragment %.2f",
+                result.submission, result.vertex, result.fragment);
+    if (ImGui::BeginTable("##probes", 4,
+                          ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+      ImGui::TableSetupColumn("Probe");
+      ImGui::TableSetupColumn("Frame ms");
+      ImGui::TableSetupColumn("Submit CPU ms");
+      ImGui::TableSetupColumn("Scene GPU ms");
+      ImGui::TableHeadersRow();
+      for (int p = 0; p < BottleneckResult::ProbeCount; p++) {
+        const BottleneckSample &s = result.probes[p];
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(ProbeNames[p]);
+        for (float v : {s.frameMs, s.cpuMs, s.gpuMs}) {
+          ImGui::TableNextColumn();
+          ImGui::Text("%.3f", v);
+        }
+      }
+      ImGui::EndTable();
+    }
+    ImGui::TreePop();
+    ImGui::PopID();
+  }
+}
+
+void BottleneckClassifier::WriteJson(std::ostream &os) const {
+  static const char *const keys[BottleneckResult::ProbeCount] = {
+      "baseline", "lowResolution", "vertexLoad", "fewerObjects"};
+
+  os << "{\n    \"lowScale\": " << settings.lowScale
+     << ",\n    \"vertexWork\": " << settings.vertexWork
+     << ",\n    \"countFraction\": " << settings.countFraction
+     << ",\n    \"results\": [";
+  size_t finished = running ? results.size() - 1 : results.size();
+  for (size_t i = 0; i < finished; i++) {
+    const BottleneckResult &r = results[i];
+    os << (i ? "," : "") << "\n      {\"strategy\": \"" << r.strategy
+       << "\", \"objectCount\": " << r.objectCount << ", \"width\": " << r.width
+       << ", \"height\": " << r.height << ", \"label\": \"" << BottleneckName(r.label)
+       << "\", \"submission\": " << r.submission << ", \"vertex\": " << r.vertex
+       << ", \"fragment\": " << r.fragment << ", \"probes\": {";
+    for (int p = 0; p < BottleneckResult::ProbeCount; p++) {
+      const BottleneckSample &s = r.probes[p];
+      os << (p ? ", " : "") << "\"" << keys[p] << "\": {\"frameMs\": " << s.frameMs
+         << ", \"cpuMs\": " << s.cpuMs << ", \"gpuMs\": " << s.gpuMs << "}";
+    }
+    os << "}}";
+  }
+  os << (finished == 0 ? "]" : "\n    ]") << "\n  }";
+}
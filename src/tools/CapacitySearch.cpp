@@ -0,0 +1,241 @@
+#include "tools/CapacitySearch.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+void CapacitySearch::Start(const CapacitySettings &newSettings,
+                           const std::vector<int> &strategyIndices,
+                           const char *const *strategyNames, int sceneSize) {
+  settings = newSettings;
+  settings.measureFrames = std::max(settings.measureFrames, 8);
+  strategies = strategyIndices;
+  names.clear();
+  for (int index : strategies)
+    names.emplace_back(strategyNames[index]);
+  maxCount = std::max(sceneSize, 1);
+  results.clear();
+
+  current = 0;
+  running = !strategies.empty();
+  if (running)
+    BeginStrategy();
+}
+
+void CapacitySearch::Stop() {
+  running = false;
+  state = State::Idle;
+}
+
+void CapacitySearch::BeginStrategy() {
+  results.emplace_back();
+  results.back().strategy = names[current];
+  state = State::Ramp;
+  low = 0;
+  high = 0;
+  BeginStep(std::clamp(settings.startCount, 1, maxCount),
+            settings.switchWarmupFrames);
+}
+
+void CapacitySearch::BeginStep(int stepCount, int warmup) {
+  count = stepCount;
+  skip = warmup;
+  retries = 0;
+  samples.clear();
+}
+
+void CapacitySearch::Update(float frameMs) {
+  if (!running)
+    return;
+  if (skip > 0) {
+    skip--;
+    return;
+  }
+  samples.push_back(frameMs);
+  if (samples.size() >= static_cast<size_t>(settings.measureFrames))
+    FinishStep();
+}
+
+float CapacitySearch::Measure(const Percentiles &p) const {
+  if (settings.percentile <= 50)
+    return p.p50;
+  if (settings.percentile >= 99)
+    return p.p99;
+  return p.p95;
+}
+
+void CapacitySearch::FinishStep() {
+  scratch = samples;
+  Percentiles all = ComputePercentiles(scratch);
+
+  // Both halves of the window should tell the same story
+  size_t half = samples.size() / 2;
+  scratch.assign(samples.begin(), samples.begin() + half);
+  float first = Measure(ComputePercentiles(scratch));
+  scratch.assign(samples.begin() + half, samples.end());
+  float second = Measure(ComputePercentiles(scratch));
+  bool stable = std::fabs(first - second) <=
+                settings.stabilityTolerance * std::max(first, second);
+  if (!stable && retries < settings.maxRetries) {
+    retries++;
+    samples.clear();
+    return;
+  }
+
+  CapacityPoint point;
+  point.count = count;
+  point.frame = all;
+  point.withinBudget = Measure(all) <= settings.budgetMs;
+  point.stable = stable;
+
+  std::vector<CapacityPoint> &curve = results.back().curve;
+  auto at = std::lower_bound(curve.begin(), curve.end(), count,
+                             [](const CapacityPoint &p, int c) { return p.count < c; });
+  if (at != curve.end() && at->count == count)
+    *at = point;
+  else
+    curve.insert(at, point);
+
+  if (point.withinBudget)
+    low = std::max(low, count);
+  else
+    high = high == 0 ? count : std::min(high, count);
+
+  if (state == State::Ramp) {
+    if (point.withinBudget) {
+      if (count >= maxCount) {
+        results.back().hitMax = true;
+        FinishStrategy();
+      } else {
+        BeginStep(std::min(count * 2, maxCount), settings.warmupFrames);
+      }
+      return;
+    }
+    state = State::Bisect;
+  }
+
+  int gap = high - low;
+  if (gap <= std::max(1, static_cast<int>(low * settings.precision))) {
+    FinishStrategy();
+    return;
+  }
+  BeginStep(low + gap / 2, settings.warmupFrames);
+}
+
+void CapacitySearch::FinishStrategy() {
+  results.back().capacity = low;
+  std::cout << "CAPACITY::" << results.back().strategy << "::" << low
+            << (results.back().hitMax ? " (scene limit)" : "") << std::endl;
+
+  current++;
+  if (current >= strategies.size()) {
+    Stop();
+    return;
+  }
+  BeginStrategy();
+}
+
+const char *CapacitySearch::Phase() const {
+  if (!running)
+    return "Idle";
+  if (skip > 0)
+    return "Warm-up";
+  if (retries > 0)
+    return "Re-measure";
+  return state == State::Ramp ? "Ramp" : "Binary search";
+}
+
+float CapacitySearch::Progress() const {
+  if (strategies.empty())
+    return 0.0f;
+  return static_cast<float>(current) / strategies.size();
+}
+
+void CapacitySearch::DrawImGui() const {
+  for (const CapacityResult &result : results) {
+    bool finished = !running || &result != &results.back();
+    if (!ImGui::TreeNode(result.strategy.c_str(), "%s: %s%d objects%s",
+                         result.strategy.c_str(), finished ? "" : "searching, ",
+                         finished ? result.capacity : low,
+                         result.hitMax ? " (scene limit)" : ""))
+      continue;
+
+    plotValues.clear();
+    for (const CapacityPoint &p : result.curve)
+      plotValues.push_back(Measure(p.frame));
+    if (!plotValues.empty()) {
+      char overlay[48];
+      std::snprintf(overlay, sizeof(overlay), "p%d ms by count, budget %.1f",
+                    settings.percentile, settings.budgetMs);
+      ImGui::PlotLines("##curve", plotValues.data(),
+                       static_cast<int>(plotValues.size()), 0, overlay, 0.0f,
+                       settings.budgetMs * 2.0f, ImVec2(0, 60));
+    }
+
+    if (ImGui::BeginTable("##points", 6,
+                          ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+      ImGui::TableSetupColumn("Count");
+      ImGui::TableSetupColumn("p50");
+      ImGui::TableSetupColumn("p95");
+      ImGui::TableSetupColumn("p99");
+      ImGui::TableSetupColumn("Budget");
+      ImGui::TableSetupColumn("Stable");
+      ImGui::TableHeadersRow();
+      for (const CapacityPoint &p : result.curve) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text("%d", p.count);
+        for (float v : {p.frame.p50, p.frame.p95, p.frame.p99}) {
+          ImGui::TableNextColumn();
+          ImGui::Text("%.2f", v);
+        }
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(p.withinBudget ? "within" : "over");
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(p.stable ? "yes" : "no");
+      }
+      ImGui::EndTable();
+    }
+    ImGui::TreePop();
+  }
+}
+
+void CapacitySearch::WriteJson(std::ostream &os) const {
+  os << "{\n    \"budgetMs\": " << settings.budgetMs
+     << ",\n    \"percentile\": " << settings.percentile
+     << ",\n    \"measureFrames\": " << settings.measureFrames
+     << ",\n    \"strategies\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    const CapacityResult &r = results[i];
+    os << (i ? "," : "") << "\n      {\"strategy\": \"" << r.strategy
+       << "\", \"capacity\": " << r.capacity
+       << ", \"hitMax\": " << (r.hitMax ? "true" : "false") << ", \"curve\": [";
+    for (size_t j = 0; j < r.curve.size(); j++) {
+      const CapacityPoint &p = r.curve[j];
+      os << (j ? ", " : "") << "{\"count\": " << p.count << ", \"frameMs\": ";
+      WritePercentiles(os, p.frame);
+      os << ", \"withinBudget\": " << (p.withinBudget ? "true" : "false")
+         << ", \"stable\": " << (p.stable ? "true" : "false") << "}";
+    }
+    os << "]}";
+  }
+  os << (results.empty() ? "]" : "\n    ]") << "\n  }";
+}
+
+bool CapacitySearch::Export(const std::string &path) const {
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    std::cerr << "Could not write capacity results: " << path << "\n";
+    return false;
+  }
+  file << "{\n  \"capacity\": ";
+  WriteJson(file);
+  file << "\n}\n";
+
+  std::cout << "SUCCESS::CAPACITY::EXPORTED::" << path << std::endl;
+  return true;
+}
@@ -1,34 +1,17 @@
 #include "tools/EngineConfig.h"
-#include "tools/filemanager.h"
 
 #define GLFW_INCLUDE_NONE
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-// Safe, lazy-initialized VFS
-static VirtualFileSystem& GetVirtualFileSystem() {
-    static VirtualFileSystem vfs("../assets");
-    return vfs;
-}
-
-// Asset paths
-std::string EngineConfig::TextureDirectory =
-    GetVirtualFileSystem().getFullPath("Textures/");
-
-std::string EngineConfig::ShaderDirectory =
-    GetVirtualFileSystem().getFullPath("Shaders/");
-
-std::string EngineConfig::CubemapDirectory =
-    GetVirtualFileSystem().getFullPath("Cubemap/");
-
-std::string EngineConfig::CubemapTestDirectory =
-    GetVirtualFileSystem().getFullPath("Cubemap/test/");
-
-std::string EngineConfig::FontDirectory =
-    GetVirtualFileSystem().getFullPath("Fonts/");
-
-std::string EngineConfig::ModelDirectory =
-    GetVirtualFileSystem().getFullPath("Models/");
+// Asset directories, relative to the asset root. They are only prefixes;
+// VirtualFileSystem::shared() resolves them when something is opened.
+std::string EngineConfig::TextureDirectory = "Textures/";
+std::string EngineConfig::ShaderDirectory = "Shaders/";
+std::string EngineConfig::CubemapDirectory = "Cubemap/";
+std::string EngineConfig::CubemapTestDirectory = "Cubemap/test/";
+std::string EngineConfig::FontDirectory = "Fonts/";
+std::string EngineConfig::ModelDirectory = "Models/";
 
 // Default window size
 unsigned int EngineConfig::WindowWidth  = 800;
@@ -0,0 +1,82 @@
+#include "tools/FrameArena.h"
+#include "tools/JobSystem.h"
+
+#include <algorithm>
+
+static size_t alignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// --------------------------------------------------------
+// LinearArena
+// --------------------------------------------------------
+
+LinearArena::LinearArena(size_t initialCapacity)
+    : block(new std::byte[initialCapacity]), capacity(initialCapacity) {}
+
+void *LinearArena::Allocate(size_t bytes, size_t alignment) {
+  // new[] only guarantees max_align_t, so align the address, not the offset
+  uintptr_t base = reinterpret_cast<uintptr_t>(block.get());
+  size_t start = alignUp(base + offset, alignment) - base;
+  if (start + bytes <= capacity) {
+    offset = start + bytes;
+    highWater = std::max(highWater, Used());
+    return block.get() + start;
+  }
+
+  // Out of room this frame: fall back to a dedicated block
+  overflow.emplace_back(new std::byte[bytes + alignment]);
+  overflowBytes += bytes + alignment;
+  highWater = std::max(highWater, Used());
+  uintptr_t raw = reinterpret_cast<uintptr_t>(overflow.back().get());
+  return reinterpret_cast<void *>(alignUp(raw, alignment));
+}
+
+void LinearArena::Reset() {
+  if (!overflow.empty()) {
+    overflow.clear();
+    // Room for the worst frame so far, plus slack for alignment padding
+    capacity = highWater + highWater / 8;
+    block.reset(new std::byte[capacity]);
+  }
+  offset = 0;
+  overflowBytes = 0;
+}
+
+// --------------------------------------------------------
+// FrameArenas
+// --------------------------------------------------------
+
+FrameArenas::FrameArenas(int threadCount) {
+  for (int i = 0; i < std::max(threadCount, 1); i++)
+    arenas.push_back(std::make_unique<LinearArena>());
+}
+
+LinearArena &FrameArenas::Local() {
+  int index = JobSystem::ThreadIndex();
+  return *arenas[std::min(index, ThreadCount() - 1)];
+}
+
+void FrameArenas::Reset() {
+  for (auto &arena : arenas)
+    arena->Reset();
+}
+
+size_t FrameArenas::Used() const {
+  size_t used = 0;
+  for (const auto &arena : arenas)
+    used += arena->Used();
+  return used;
+}
+
+size_t FrameArenas::Capacity() const {
+  size_t total = 0;
+  for (const auto &arena : arenas)
+    total += arena->Capacity();
+  return total;
+}
+
+FrameArenas &FrameArenas::Shared() {
+  static FrameArenas shared(JobSystem::Shared().ThreadCount());
+  return shared;
+}
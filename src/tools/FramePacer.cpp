@@ -0,0 +1,100 @@
+#include "tools/FramePacer.h"
+#include "tools/Profiler.h"
+
+void FramePacer::Init() {
+  slots.resize(RingSize);
+  for (Slot &slot : slots)
+    slot.query.Create("FramePacer");
+  oldest = 0;
+  count = 0;
+  Calibrate();
+}
+
+void FramePacer::Shutdown() {
+  if (slots.empty())
+    return;
+  std::vector<FrameTimeline> discarded;
+  Drain(discarded);
+  // Handles delete their queries
+  slots.clear();
+}
+
+void FramePacer::Calibrate() {
+  GLint64 gpuNow = 0;
+  glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+  gpuToCpuNs = static_cast<int64_t>(Profiler::Now()) - static_cast<int64_t>(gpuNow);
+}
+
+bool FramePacer::Retire(bool wait, std::vector<FrameTimeline> &done) {
+  Slot &slot = slots[oldest];
+  if (wait) {
+    // Flush once so the fence can signal at all, then keep waiting
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    for (;;) {
+      GLenum status = glClientWaitSync(slot.fence, flags, 1000000000);
+      if (status != GL_TIMEOUT_EXPIRED)
+        break;
+      flags = 0;
+    }
+  } else {
+    GLenum status = glClientWaitSync(slot.fence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+      return false;
+  }
+
+  // Everything before the fence is done, so the query result is there
+  GLuint64 gpuNs = 0;
+  glGetQueryObjectui64v(slot.query, GL_QUERY_RESULT, &gpuNs);
+  slot.timeline.gpuDoneNs =
+      static_cast<uint64_t>(static_cast<int64_t>(gpuNs) + gpuToCpuNs);
+  done.push_back(slot.timeline);
+
+  glDeleteSync(slot.fence);
+  slot.fence = nullptr;
+  oldest = (oldest + 1) % slots.size();
+  count--;
+  return true;
+}
+
+uint64_t FramePacer::Throttle(int limit, std::vector<FrameTimeline> &done) {
+  if (slots.empty())
+    return 0;
+  Poll(done);
+
+  // The ring bounds the queue even with the limit off
+  size_t allowed = limit > 0 ? static_cast<size_t>(limit) : slots.size();
+  if (count < allowed)
+    return 0;
+
+  uint64_t start = Profiler::Now();
+  while (count >= allowed)
+    Retire(true, done);
+  return Profiler::Now() - start;
+}
+
+void FramePacer::Fence(const FrameTimeline &timeline) {
+  if (slots.empty())
+    return;
+  if (count == slots.size()) {
+    std::vector<FrameTimeline> done;
+    Retire(true, done);
+  }
+
+  Slot &slot = slots[(oldest + count) % slots.size()];
+  glQueryCounter(slot.query, GL_TIMESTAMP);
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot.timeline = timeline;
+  count++;
+}
+
+uint64_t FramePacer::Drain(std::vector<FrameTimeline> &done) {
+  uint64_t start = Profiler::Now();
+  while (count > 0)
+    Retire(true, done);
+  return Profiler::Now() - start;
+}
+
+void FramePacer::Poll(std::vector<FrameTimeline> &done) {
+  while (count > 0 && Retire(false, done)) {
+  }
+}
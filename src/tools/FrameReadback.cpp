@@ -0,0 +1,266 @@
+#include "tools/FrameReadback.h"
+#include "tools/PngWriter.h"
+#include "tools/Profiler.h"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+FrameReadback::~FrameReadback() { Shutdown(); }
+
+void FrameReadback::Init() {
+  slots.resize(RingSize);
+  for (Slot &slot : slots)
+    slot.buffer.Create("Readback");
+
+  stopping = false;
+  worker = std::thread(&FrameReadback::Run, this);
+}
+
+void FrameReadback::Shutdown() {
+  if (!worker.joinable())
+    return;
+
+  // Finish what the GPU already has; blocking is fine at shutdown
+  for (Slot &slot : slots) {
+    if (slot.fence) {
+      glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, ~GLuint64(0));
+      Submit(slot, slot.frame);
+    }
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [&] { return jobs.empty() && !busy; });
+    stopping = true;
+  }
+  wake.notify_all();
+  worker.join();
+  slots.clear();
+}
+
+bool FrameReadback::Capture(uint64_t frame, int width, int height,
+                            const ReadbackRequest &request) {
+  auto free = std::find_if(slots.begin(), slots.end(),
+                           [](const Slot &s) { return s.fence == nullptr; });
+  if (free == slots.end() || width <= 0 || height <= 0) {
+    dropped++;
+    return false;
+  }
+
+  Slot &slot = *free;
+  size_t bytes = size_t(width) * height * 4;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  if (bytes > slot.capacity) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    slot.capacity = bytes;
+    slot.buffer.SetBytes(bytes);
+  }
+  // Into the buffer, so this only queues the copy
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot.frame = frame;
+  slot.width = width;
+  slot.height = height;
+  slot.request = request;
+  return true;
+}
+
+void FrameReadback::Poll(uint64_t frame) {
+  for (Slot &slot : slots) {
+    if (!slot.fence)
+      continue;
+    // Zero timeout: just ask whether the copy has landed
+    GLenum status = glClientWaitSync(slot.fence, 0, 0);
+    if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+      Submit(slot, frame);
+  }
+}
+
+void FrameReadback::Submit(Slot &slot, uint64_t frame) {
+  Job job;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!spare.empty()) {
+      job.pixels = std::move(spare.back());
+      spare.pop_back();
+    }
+  }
+
+  size_t bytes = size_t(slot.width) * slot.height * 4;
+  job.pixels.resize(bytes);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+  if (mapped) {
+    std::memcpy(job.pixels.data(), mapped, bytes);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  glDeleteSync(slot.fence);
+  slot.fence = nullptr;
+
+  if (!mapped) {
+    std::cerr << "ERROR::READBACK::MAP_FAILED::frame " << slot.frame << std::endl;
+    return;
+  }
+
+  job.frame = slot.frame;
+  job.width = slot.width;
+  job.height = slot.height;
+  job.latencyFrames = static_cast<double>(frame - slot.frame);
+  job.request = std::move(slot.request);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back(std::move(job));
+  }
+  wake.notify_one();
+}
+
+bool FrameReadback::PopResult(ReadbackResult &out) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (results.empty())
+    return false;
+  out = std::move(results.front());
+  results.pop_front();
+  return true;
+}
+
+size_t FrameReadback::InFlight() const {
+  return std::count_if(slots.begin(), slots.end(),
+                       [](const Slot &s) { return s.fence != nullptr; });
+}
+
+size_t FrameReadback::Queued() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return jobs.size() + (busy ? 1 : 0);
+}
+
+void FrameReadback::Run() {
+  PROFILE_THREAD("Readback");
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    wake.wait(lock, [&] { return stopping || !jobs.empty(); });
+    if (jobs.empty())
+      return;
+
+    Job job = std::move(jobs.front());
+    jobs.pop_front();
+    busy = true;
+    lock.unlock();
+
+    ReadbackResult result;
+    Process(job, result);
+
+    lock.lock();
+    results.push_back(std::move(result));
+    spare.push_back(std::move(job.pixels));
+    busy = false;
+    idle.notify_all();
+  }
+}
+
+static std::string diffPath(const std::string &path) {
+  size_t dot = path.rfind('.');
+  return (dot == std::string::npos ? path : path.substr(0, dot)) + "_diff.png";
+}
+
+void FrameReadback::Process(Job &job, ReadbackResult &result) {
+  PROFILE_SCOPE("Readback Process");
+  result.frame = job.frame;
+  result.label = job.request.label;
+  result.width = job.width;
+  result.height = job.height;
+  result.latencyFrames = job.latencyFrames;
+
+  // GL rows are bottom-up; everything below works on top-down images
+  size_t rowBytes = size_t(job.width) * 4;
+  for (int y = 0; y < job.height / 2; y++) {
+    unsigned char *top = &job.pixels[y * rowBytes];
+    std::swap_ranges(top, top + rowBytes,
+                     &job.pixels[(job.height - 1 - y) * rowBytes]);
+  }
+
+  uint64_t hash = 1469598103934665603ull;
+  for (unsigned char byte : job.pixels) {
+    hash ^= byte;
+    hash *= 1099511628211ull;
+  }
+  result.hash = hash;
+
+  const ReadbackRequest &request = job.request;
+  if (!request.savePath.empty()) {
+    result.saved = PngWriter::Write(request.savePath, job.width, job.height,
+                                    job.pixels.data());
+    if (result.saved)
+      std::cout << "SUCCESS::READBACK::SAVED::" << request.savePath << std::endl;
+  }
+
+  if (request.goldenPath.empty())
+    return;
+
+  result.compared = true;
+  int goldenWidth, goldenHeight, channels;
+  // The loader is also used on the main thread; keep the flip setting local
+  stbi_set_flip_vertically_on_load_thread(0);
+  unsigned char *golden = stbi_load(request.goldenPath.c_str(), &goldenWidth,
+                                    &goldenHeight, &channels, 4);
+  if (!golden) {
+    std::cerr << "WARNING::READBACK::GOLDEN_MISSING::" << request.goldenPath
+              << std::endl;
+    result.differingPixels = size_t(job.width) * job.height;
+    return;
+  }
+  if (goldenWidth != job.width || goldenHeight != job.height) {
+    std::cerr << "WARNING::READBACK::GOLDEN_SIZE_MISMATCH::" << request.goldenPath
+              << " is " << goldenWidth << "x" << goldenHeight << ", frame is "
+              << job.width << "x" << job.height << std::endl;
+    result.differingPixels = size_t(job.width) * job.height;
+    stbi_image_free(golden);
+    return;
+  }
+
+  // Differing pixels in red over a dimmed copy of the frame
+  std::vector<unsigned char> diff;
+  size_t pixelCount = size_t(job.width) * job.height;
+  for (size_t i = 0; i < pixelCount; i++) {
+    int delta = 0;
+    for (int c = 0; c < 4; c++)
+      delta = std::max(delta, std::abs(int(job.pixels[i * 4 + c]) - int(golden[i * 4 + c])));
+    result.maxDelta = std::max(result.maxDelta, delta);
+    if (delta <= request.tolerance)
+      continue;
+    if (result.differingPixels++ == 0 && !request.savePath.empty()) {
+      diff.resize(pixelCount * 4);
+      for (size_t p = 0; p < pixelCount; p++) {
+        for (int c = 0; c < 3; c++)
+          diff[p * 4 + c] = job.pixels[p * 4 + c] / 4;
+        diff[p * 4 + 3] = 255;
+      }
+    }
+    if (!diff.empty()) {
+      diff[i * 4 + 0] = 255;
+      diff[i * 4 + 1] = 0;
+      diff[i * 4 + 2] = 0;
+    }
+  }
+  stbi_image_free(golden);
+
+  result.matched = result.differingPixels == 0;
+  if (result.matched) {
+    std::cout << "SUCCESS::READBACK::GOLDEN_MATCH::" << result.label
+              << "::" << request.goldenPath << std::endl;
+  } else {
+    std::cerr << "WARNING::READBACK::GOLDEN_MISMATCH::" << result.label
+              << "::" << result.differingPixels << " pixels differ (max delta "
+              << result.maxDelta << ")" << std::endl;
+    if (!diff.empty())
+      PngWriter::Write(diffPath(request.savePath), job.width, job.height, diff.data());
+  }
+}
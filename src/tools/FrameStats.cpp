@@ -0,0 +1,448 @@
+#include "tools/FrameStats.h"
+#include "tools/AllocationCounter.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+
+// --------------------------------------------------------
+// FrameSampleRing
+// --------------------------------------------------------
+
+void FrameSampleRing::Write(Slot &slot, const FrameSample &sample) {
+  // Odd sequence = write in progress. Readers retry until they see the same
+  // even value before and after their copy.
+  uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+  slot.seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.sample = sample;
+  slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+void FrameSampleRing::Push(const FrameSample &sample) {
+  uint64_t index = head.load(std::memory_order_relaxed);
+  Write(slots[index % Capacity], sample);
+  head.store(index + 1, std::memory_order_release);
+}
+
+bool FrameSampleRing::SetGpuTime(uint64_t frameIndex, float gpuMs) {
+  Slot &slot = slots[frameIndex % Capacity];
+  if (slot.sample.frameIndex != frameIndex)
+    return false;
+
+  FrameSample sample = slot.sample;
+  sample.gpuMs = gpuMs;
+  Write(slot, sample);
+  return true;
+}
+
+bool FrameSampleRing::Read(uint64_t frameIndex, FrameSample &out) const {
+  uint64_t count = Count();
+  if (frameIndex >= count || count - frameIndex > Capacity)
+    return false;
+
+  const Slot &slot = slots[frameIndex % Capacity];
+  for (;;) {
+    uint32_t before = slot.seq.load(std::memory_order_acquire);
+    if (before & 1u)
+      continue;
+    out = slot.sample;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) == before)
+      break;
+  }
+  return out.frameIndex == frameIndex;
+}
+
+size_t FrameSampleRing::Snapshot(FrameSample *out, size_t maxCount) const {
+  uint64_t count = Count();
+  uint64_t n = std::min<uint64_t>({maxCount, count, Capacity});
+
+  size_t written = 0;
+  for (uint64_t i = count - n; i < count; i++) {
+    if (Read(i, out[written]))
+      written++;
+  }
+  return written;
+}
+
+// --------------------------------------------------------
+// Helpers
+// --------------------------------------------------------
+
+const char *HitchReasonName(HitchReason reason) {
+  switch (reason) {
+  case HitchReason::Cpu:
+    return "CPU";
+  case HitchReason::Gpu:
+    return "GPU";
+  case HitchReason::Present:
+    return "Present";
+  case HitchReason::Event:
+    return "Event";
+  default:
+    return "Unknown";
+  }
+}
+
+static float msBetween(FrameStats::Clock::time_point a,
+                       FrameStats::Clock::time_point b) {
+  return std::chrono::duration<float, std::milli>(b - a).count();
+}
+
+Percentiles ComputePercentiles(std::vector<float> &values) {
+  Percentiles p;
+  if (values.empty())
+    return p;
+
+  auto rank = [&](float q) {
+    size_t idx = static_cast<size_t>(std::ceil(q * values.size()));
+    return std::min(values.size() - 1, idx > 0 ? idx - 1 : 0);
+  };
+
+  // Each nth_element leaves everything below the rank in front of it, so the
+  // lower percentiles only need to look at the front part.
+  size_t i99 = rank(0.99f), i95 = rank(0.95f), i50 = rank(0.50f);
+  p.max = *std::max_element(values.begin(), values.end());
+  std::nth_element(values.begin(), values.begin() + i99, values.end());
+  p.p99 = values[i99];
+  std::nth_element(values.begin(), values.begin() + i95, values.begin() + i99);
+  p.p95 = values[i95];
+  std::nth_element(values.begin(), values.begin() + i50, values.begin() + i95);
+  p.p50 = values[i50];
+  return p;
+}
+
+void WritePercentiles(std::ostream &os, const Percentiles &p) {
+  os << "{\"p50\": " << p.p50 << ", \"p95\": " << p.p95
+     << ", \"p99\": " << p.p99 << ", \"max\": " << p.max << "}";
+}
+
+// --------------------------------------------------------
+// FrameStats
+// --------------------------------------------------------
+
+FrameStats::FrameStats() {
+  // Sized once so the per-frame summary never allocates.
+  window.resize(FrameSampleRing::Capacity);
+  scratch.reserve(FrameSampleRing::Capacity);
+  hitches.reserve(MaxHitchRecords);
+  lastFrameEnd = Clock::now();
+}
+
+void FrameStats::BeginFrame() {
+  frameStart = Clock::now();
+  frameStartAllocations = AllocationCounter::Count();
+}
+
+void FrameStats::EndSubmit() { submitEnd = Clock::now(); }
+
+void FrameStats::EndFrame() {
+  Clock::time_point now = Clock::now();
+
+  FrameSample sample;
+  sample.frameIndex = frameIndex;
+  // Present-to-present interval: this is what the user actually sees.
+  sample.frameMs = msBetween(lastFrameEnd, now);
+  sample.cpuMs = msBetween(frameStart, submitEnd);
+  sample.presentMs = msBetween(submitEnd, now);
+  sample.allocations =
+      static_cast<uint32_t>(AllocationCounter::Count() - frameStartAllocations);
+  sample.event = pendingEvent;
+  ring.Push(sample);
+
+  framesSinceEvent = pendingEvent ? 0 : framesSinceEvent + 1;
+  if (sample.allocations > 0 &&
+      framesSinceEvent > static_cast<uint64_t>(steadyStateFrames)) {
+    steadyAllocationFrames++;
+    if (assertZeroAllocations) {
+      std::cerr << "Frame " << frameIndex << ": " << sample.allocations
+                << " heap allocations in steady state\n";
+      assert(sample.allocations == 0 && "heap allocation in a steady-state frame");
+    }
+  }
+
+  lastFrameEnd = now;
+  pendingEvent = nullptr;
+  frameIndex++;
+
+  UpdateSummary();
+  EvaluateHitches();
+}
+
+void FrameStats::SetGpuTime(uint64_t index, float gpuMs) {
+  ring.SetGpuTime(index, gpuMs);
+}
+
+void FrameStats::Annotate(const char *event) { pendingEvent = event; }
+
+void FrameStats::ResetHitches() {
+  hitches.clear();
+  hitchCount = 0;
+  reasonCounts.fill(0);
+  eventCounts.clear();
+}
+
+void FrameStats::UpdateSummary() {
+  size_t n = std::clamp<size_t>(static_cast<size_t>(windowSize), 1,
+                                FrameSampleRing::Capacity);
+  size_t count = ring.Snapshot(window.data(), n);
+
+  summary = FrameStatsSummary{};
+  summary.sampleCount = count;
+  if (count == 0)
+    return;
+
+  auto gather = [&](auto member, bool resolvedOnly) {
+    scratch.clear();
+    for (size_t i = 0; i < count; i++) {
+      float v = window[i].*member;
+      if (!resolvedOnly || v >= 0.0f)
+        scratch.push_back(v);
+    }
+    return ComputePercentiles(scratch);
+  };
+
+  double total = 0.0;
+  double allocations = 0.0;
+  for (size_t i = 0; i < count; i++) {
+    total += window[i].frameMs;
+    allocations += window[i].allocations;
+    summary.allocationsMax = std::max(summary.allocationsMax, window[i].allocations);
+  }
+  summary.meanMs = static_cast<float>(total / count);
+  summary.allocationsMean = static_cast<float>(allocations / count);
+
+  summary.frame = gather(&FrameSample::frameMs, false);
+  summary.cpu = gather(&FrameSample::cpuMs, false);
+  summary.gpu = gather(&FrameSample::gpuMs, true);
+  summary.present = gather(&FrameSample::presentMs, false);
+}
+
+void FrameStats::EvaluateHitches() {
+  // GPU times land a few frames late; a frame is only judged once its sample
+  // is complete so the reason breakdown can include the GPU.
+  constexpr uint64_t maxGpuLatency = 8;
+
+  while (lastEvaluated < frameIndex) {
+    FrameSample sample;
+    if (!ring.Read(lastEvaluated, sample)) {
+      lastEvaluated++;
+      continue;
+    }
+    if (gpuTimingEnabled && sample.gpuMs < 0.0f &&
+        frameIndex - lastEvaluated < maxGpuLatency)
+      break;
+
+    ClassifyHitch(sample);
+    lastEvaluated++;
+  }
+}
+
+void FrameStats::ClassifyHitch(const FrameSample &sample) {
+  float median = summary.frame.p50;
+  if (median <= 0.0f || sample.frameMs <= hitchMultiplier * median)
+    return;
+
+  HitchReason reason = HitchReason::Cpu;
+  if (sample.event) {
+    reason = HitchReason::Event;
+  } else {
+    // Blame the component that grew the most over its own median.
+    float cpuExcess = sample.cpuMs - summary.cpu.p50;
+    float gpuExcess =
+        sample.gpuMs >= 0.0f ? sample.gpuMs - summary.gpu.p50 : -1.0f;
+    float presentExcess = sample.presentMs - summary.present.p50;
+
+    float worst = cpuExcess;
+    if (gpuExcess > worst) {
+      worst = gpuExcess;
+      reason = HitchReason::Gpu;
+    }
+    if (presentExcess > worst)
+      reason = HitchReason::Present;
+  }
+
+  hitchCount++;
+  reasonCounts[static_cast<size_t>(reason)]++;
+
+  if (sample.event) {
+    auto it = std::find_if(eventCounts.begin(), eventCounts.end(),
+                           [&](const auto &entry) {
+                             return std::strcmp(entry.first, sample.event) == 0;
+                           });
+    if (it != eventCounts.end())
+      it->second++;
+    else
+      eventCounts.emplace_back(sample.event, 1);
+  }
+
+  HitchRecord record;
+  record.frameIndex = sample.frameIndex;
+  record.frameMs = sample.frameMs;
+  record.medianMs = median;
+  record.reason = reason;
+  record.event = sample.event;
+
+  if (hitches.size() == MaxHitchRecords)
+    hitches.erase(hitches.begin());
+  hitches.push_back(record);
+}
+
+void FrameStats::DrawImGui() {
+  const FrameStatsSummary &s = summary;
+
+  ImGui::Text("Frames: %zu  Mean: %.3f ms", s.sampleCount, s.meanMs);
+  if (ImGui::BeginTable("##percentiles", 5,
+                        ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+    ImGui::TableSetupColumn("ms");
+    ImGui::TableSetupColumn("p50");
+    ImGui::TableSetupColumn("p95");
+    ImGui::TableSetupColumn("p99");
+    ImGui::TableSetupColumn("max");
+    ImGui::TableHeadersRow();
+
+    auto row = [](const char *label, const Percentiles &p) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(label);
+      for (float v : {p.p50, p.p95, p.p99, p.max}) {
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", v);
+      }
+    };
+    row("Frame", s.frame);
+    row("CPU", s.cpu);
+    row("GPU", s.gpu);
+    row("Present", s.present);
+    ImGui::EndTable();
+  }
+
+  // Frame-time graph, oldest on the left.
+  scratch.clear();
+  for (size_t i = 0; i < s.sampleCount; i++)
+    scratch.push_back(window[i].frameMs);
+
+  float graphMax = std::max(s.frame.max * 1.1f, 1.0f);
+  char overlay[64];
+  std::snprintf(overlay, sizeof(overlay), "p99 %.2f ms", s.frame.p99);
+  ImGui::PlotLines("##frametimes", scratch.data(),
+                   static_cast<int>(scratch.size()), 0, overlay, 0.0f,
+                   graphMax, ImVec2(0, 80));
+
+  // Histogram over [0, 2 x p99] so the tail stays visible.
+  constexpr int binCount = 48;
+  float bins[binCount] = {};
+  float histMax = std::max(s.frame.p99 * 2.0f, 1.0f);
+  for (float v : scratch) {
+    int bin = static_cast<int>(v / histMax * binCount);
+    bins[std::clamp(bin, 0, binCount - 1)] += 1.0f;
+  }
+  std::snprintf(overlay, sizeof(overlay), "0 - %.1f ms", histMax);
+  ImGui::PlotHistogram("##framehist", bins, binCount, 0, overlay, 0.0f,
+                       FLT_MAX, ImVec2(0, 60));
+
+  ImGui::SliderInt("Stats Window", &windowSize, 60,
+                   static_cast<int>(FrameSampleRing::Capacity));
+  ImGui::SliderFloat("Hitch x Median", &hitchMultiplier, 1.25f, 5.0f, "%.2f");
+
+  FrameSample latest;
+  if (ring.Count() > 0 && ring.Read(ring.Count() - 1, latest)) {
+    ImGui::Text("Heap allocations: %u this frame, max %u, mean %.1f",
+                latest.allocations, s.allocationsMax, s.allocationsMean);
+  }
+  ImGui::Checkbox("Assert Zero Allocations", &assertZeroAllocations);
+  ImGui::SameLine();
+  ImGui::Text("(%llu steady-state frames allocated)",
+              static_cast<unsigned long long>(steadyAllocationFrames));
+
+  ImGui::Text("Hitches: %llu", static_cast<unsigned long long>(hitchCount));
+  for (size_t i = 0; i < reasonCounts.size(); i++) {
+    if (reasonCounts[i] == 0)
+      continue;
+    ImGui::SameLine();
+    ImGui::Text("%s %llu", HitchReasonName(static_cast<HitchReason>(i)),
+                static_cast<unsigned long long>(reasonCounts[i]));
+  }
+  for (const auto &[event, count] : eventCounts)
+    ImGui::BulletText("%s: %llu", event, static_cast<unsigned long long>(count));
+
+  if (!hitches.empty()) {
+    const HitchRecord &last = hitches.back();
+    ImGui::Text("Last: frame %llu, %.2f ms (%.1fx median), %s",
+                static_cast<unsigned long long>(last.frameIndex), last.frameMs,
+                last.frameMs / last.medianMs, HitchReasonName(last.reason));
+  }
+  if (ImGui::Button("Reset Hitches"))
+    ResetHitches();
+  ImGui::SameLine();
+  if (ImGui::Button("Export CSV"))
+    ExportCsv("frame_stats.csv");
+}
+
+void FrameStats::WriteJson(std::ostream &os) const {
+  const FrameStatsSummary &s = summary;
+
+  os << "{\n";
+  os << "    \"sampleCount\": " << s.sampleCount << ",\n";
+  os << "    \"meanMs\": " << s.meanMs << ",\n";
+  os << "    \"frameMs\": ";
+  WritePercentiles(os, s.frame);
+  os << ",\n    \"cpuMs\": ";
+  WritePercentiles(os, s.cpu);
+  os << ",\n    \"gpuMs\": ";
+  WritePercentiles(os, s.gpu);
+  os << ",\n    \"presentMs\": ";
+  WritePercentiles(os, s.present);
+
+  os << ",\n    \"allocationsMax\": " << s.allocationsMax;
+  os << ",\n    \"allocationsMean\": " << s.allocationsMean;
+  os << ",\n    \"steadyAllocationFrames\": " << steadyAllocationFrames;
+  os << ",\n    \"hitchMultiplier\": " << hitchMultiplier;
+  os << ",\n    \"hitchCount\": " << hitchCount;
+  os << ",\n    \"hitchReasons\": {";
+  for (size_t i = 0; i < reasonCounts.size(); i++) {
+    os << (i ? ", " : "") << "\"" << HitchReasonName(static_cast<HitchReason>(i))
+       << "\": " << reasonCounts[i];
+  }
+  os << "},\n    \"hitchEvents\": {";
+  for (size_t i = 0; i < eventCounts.size(); i++) {
+    os << (i ? ", " : "") << "\"" << eventCounts[i].first
+       << "\": " << eventCounts[i].second;
+  }
+  os << "},\n    \"hitches\": [";
+  for (size_t i = 0; i < hitches.size(); i++) {
+    const HitchRecord &h = hitches[i];
+    os << (i ? ", " : "") << "{\"frame\": " << h.frameIndex
+       << ", \"ms\": " << h.frameMs << ", \"reason\": \""
+       << HitchReasonName(h.reason) << "\"}";
+  }
+  os << "]\n  }";
+}
+
+bool FrameStats::ExportCsv(const std::string &path) const {
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    std::cerr << "Could not write frame stats: " << path << "\n";
+    return false;
+  }
+
+  file << "frame,frame_ms,cpu_ms,gpu_ms,present_ms,allocations,event\n";
+  for (size_t i = 0; i < summary.sampleCount; i++) {
+    const FrameSample &f = window[i];
+    file << f.frameIndex << "," << f.frameMs << "," << f.cpuMs << ","
+         << f.gpuMs << "," << f.presentMs << "," << f.allocations << ","
+         << (f.event ? f.event : "")
+         << "\n";
+  }
+  std::cout << "SUCCESS::FRAMESTATS::EXPORTED::" << path << std::endl;
+  return true;
+}
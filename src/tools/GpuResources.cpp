@@ -0,0 +1,235 @@
+#include "tools/GpuResources.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <ostream>
+
+const char *GpuResourceTypeName(GpuResourceType type) {
+  switch (type) {
+  case GpuResourceType::Buffer:
+    return "Buffer";
+  case GpuResourceType::Texture:
+    return "Texture";
+  case GpuResourceType::VertexArray:
+    return "VAO";
+  case GpuResourceType::Query:
+    return "Query";
+  case GpuResourceType::Program:
+    return "Program";
+  case GpuResourceType::Framebuffer:
+    return "FBO";
+  default:
+    return "Unknown";
+  }
+}
+
+GLuint CreateGpuResource(GpuResourceType type) {
+  GLuint id = 0;
+  switch (type) {
+  case GpuResourceType::Buffer:
+    glGenBuffers(1, &id);
+    break;
+  case GpuResourceType::Texture:
+    glGenTextures(1, &id);
+    break;
+  case GpuResourceType::VertexArray:
+    glGenVertexArrays(1, &id);
+    break;
+  case GpuResourceType::Query:
+    glGenQueries(1, &id);
+    break;
+  case GpuResourceType::Program:
+    id = glCreateProgram();
+    break;
+  case GpuResourceType::Framebuffer:
+    glGenFramebuffers(1, &id);
+    break;
+  default:
+    break;
+  }
+  return id;
+}
+
+void DestroyGpuResource(GpuResourceType type, GLuint id) {
+  switch (type) {
+  case GpuResourceType::Buffer:
+    glDeleteBuffers(1, &id);
+    break;
+  case GpuResourceType::Texture:
+    glDeleteTextures(1, &id);
+    break;
+  case GpuResourceType::VertexArray:
+    glDeleteVertexArrays(1, &id);
+    break;
+  case GpuResourceType::Query:
+    glDeleteQueries(1, &id);
+    break;
+  case GpuResourceType::Program:
+    glDeleteProgram(id);
+    break;
+  case GpuResourceType::Framebuffer:
+    glDeleteFramebuffers(1, &id);
+    break;
+  default:
+    break;
+  }
+}
+
+static bool sameOwner(const char *a, const char *b) {
+  return a == b || (a && b && std::strcmp(a, b) == 0);
+}
+
+// Strips the directories so reports stay readable
+static const char *fileName(const char *path) {
+  if (!path)
+    return "?";
+  const char *name = path;
+  for (const char *p = path; *p; p++) {
+    if (*p == '/' || *p == '\\')
+      name = p + 1;
+  }
+  return name;
+}
+
+// --------------------------------------------------------
+// GpuResourceTracker
+// --------------------------------------------------------
+
+GpuResourceTracker &GpuResourceTracker::Get() {
+  static GpuResourceTracker tracker;
+  return tracker;
+}
+
+void GpuResourceTracker::Track(GpuResourceType type, GLuint id,
+                               const char *owner,
+                               const std::source_location &site) {
+  if (id == 0)
+    return;
+
+  GpuResourceRecord record;
+  record.type = type;
+  record.id = id;
+  record.owner = owner ? owner : "Unowned";
+  record.file = site.file_name();
+  record.line = site.line();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  record.serial = nextSerial++;
+  live[Key(type, id)] = record;
+}
+
+void GpuResourceTracker::Untrack(GpuResourceType type, GLuint id) {
+  std::lock_guard<std::mutex> lock(mutex);
+  live.erase(Key(type, id));
+}
+
+void GpuResourceTracker::SetBytes(GpuResourceType type, GLuint id,
+                                  size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = live.find(Key(type, id));
+  if (it != live.end())
+    it->second.bytes = bytes;
+}
+
+size_t GpuResourceTracker::LiveCount() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return live.size();
+}
+
+size_t GpuResourceTracker::TotalBytes() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  size_t total = 0;
+  for (const auto &[key, record] : live)
+    total += record.bytes;
+  return total;
+}
+
+void GpuResourceTracker::Breakdown(std::vector<OwnerUsage> &usage) const {
+  usage.clear();
+  std::lock_guard<std::mutex> lock(mutex);
+  for (const auto &[key, record] : live) {
+    auto it = std::find_if(usage.begin(), usage.end(), [&](const OwnerUsage &u) {
+      return sameOwner(u.owner, record.owner);
+    });
+    if (it == usage.end()) {
+      usage.emplace_back();
+      it = usage.end() - 1;
+      it->owner = record.owner;
+    }
+    it->counts[static_cast<size_t>(record.type)]++;
+    it->bytes += record.bytes;
+  }
+
+  std::sort(usage.begin(), usage.end(),
+            [](const OwnerUsage &a, const OwnerUsage &b) { return a.bytes > b.bytes; });
+}
+
+size_t GpuResourceTracker::ReportLeaks(const char *owner, std::ostream &os) const {
+  std::vector<GpuResourceRecord> leaks;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &[key, record] : live) {
+      if (!owner || sameOwner(owner, record.owner))
+        leaks.push_back(record);
+    }
+  }
+  if (leaks.empty())
+    return 0;
+
+  std::sort(leaks.begin(), leaks.end(),
+            [](const GpuResourceRecord &a, const GpuResourceRecord &b) {
+              return a.serial < b.serial;
+            });
+
+  os << "WARNING::GPU_RESOURCES::LEAKED::" << leaks.size() << " object(s)"
+     << (owner ? " owned by " : "") << (owner ? owner : "") << "\n";
+  for (const GpuResourceRecord &r : leaks) {
+    os << "  " << GpuResourceTypeName(r.type) << " " << r.id << " [" << r.owner
+       << "] " << r.bytes << " bytes, created at " << fileName(r.file) << ":"
+       << r.line << "\n";
+  }
+  return leaks.size();
+}
+
+void GpuResourceTracker::DrawImGui() {
+  Breakdown(breakdown);
+  const std::vector<OwnerUsage> &usage = breakdown;
+  size_t totalBytes = 0, totalCount = 0;
+  for (const OwnerUsage &u : usage) {
+    totalBytes += u.bytes;
+    for (size_t c : u.counts)
+      totalCount += c;
+  }
+
+  ImGui::Text("Live GL objects: %zu, %.2f MB", totalCount,
+              totalBytes / (1024.0 * 1024.0));
+
+  constexpr int typeCount = static_cast<int>(GpuResourceType::Count);
+  if (ImGui::BeginTable("##gpuresources", typeCount + 2,
+                        ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+    ImGui::TableSetupColumn("Owner");
+    for (int t = 0; t < typeCount; t++)
+      ImGui::TableSetupColumn(GpuResourceTypeName(static_cast<GpuResourceType>(t)));
+    ImGui::TableSetupColumn("MB");
+    ImGui::TableHeadersRow();
+
+    for (const OwnerUsage &u : usage) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(u.owner);
+      for (size_t c : u.counts) {
+        ImGui::TableNextColumn();
+        ImGui::Text("%zu", c);
+      }
+      ImGui::TableNextColumn();
+      ImGui::Text("%.2f", u.bytes / (1024.0 * 1024.0));
+    }
+    ImGui::EndTable();
+  }
+
+  if (ImGui::Button("Report Live Objects"))
+    ReportLeaks(nullptr, std::cout);
+}
@@ -0,0 +1,80 @@
+#include "tools/GpuTimer.h"
+
+#include <chrono>
+
+void GpuTimer::Init(int latency) {
+  slots.resize(latency > 1 ? latency : 2);
+  for (auto &slot : slots) {
+    slot.queries[0].Create("GpuTimer");
+    slot.queries[1].Create("GpuTimer");
+  }
+  writeSlot = 0;
+  readSlot = 0;
+  Calibrate();
+}
+
+void GpuTimer::Calibrate() {
+  // GL_TIMESTAMP is the GPU clock "now"; pair it with the CPU clock read
+  // right after it returns
+  GLint64 gpuNow = 0;
+  glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+  int64_t cpuNow = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                       .count();
+  gpuToCpuNs = cpuNow - static_cast<int64_t>(gpuNow);
+}
+
+void GpuTimer::Shutdown() {
+  // Handles delete their queries
+  slots.clear();
+}
+
+void GpuTimer::Begin(uint64_t frameIndex) {
+  if (slots.empty())
+    return;
+
+  Slot &slot = slots[writeSlot];
+  // The ring is full: drop the oldest result rather than stall on it.
+  if (slot.pending) {
+    slot.pending = false;
+    readSlot = (readSlot + 1) % slots.size();
+  }
+  slot.frameIndex = frameIndex;
+  glQueryCounter(slot.queries[0], GL_TIMESTAMP);
+}
+
+void GpuTimer::End() {
+  if (slots.empty())
+    return;
+
+  Slot &slot = slots[writeSlot];
+  glQueryCounter(slot.queries[1], GL_TIMESTAMP);
+  slot.pending = true;
+  writeSlot = (writeSlot + 1) % slots.size();
+}
+
+bool GpuTimer::Poll(uint64_t &frameIndex, float &ms) {
+  if (slots.empty())
+    return false;
+
+  Slot &slot = slots[readSlot];
+  if (!slot.pending)
+    return false;
+
+  GLint available = 0;
+  glGetQueryObjectiv(slot.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available)
+    return false;
+
+  GLuint64 start = 0, end = 0;
+  glGetQueryObjectui64v(slot.queries[0], GL_QUERY_RESULT, &start);
+  glGetQueryObjectui64v(slot.queries[1], GL_QUERY_RESULT, &end);
+
+  frameIndex = slot.frameIndex;
+  ms = static_cast<float>(static_cast<double>(end - start) / 1.0e6);
+  lastStartNs = static_cast<uint64_t>(static_cast<int64_t>(start) + gpuToCpuNs);
+  lastEndNs = static_cast<uint64_t>(static_cast<int64_t>(end) + gpuToCpuNs);
+  slot.pending = false;
+  readSlot = (readSlot + 1) % slots.size();
+  return true;
+}
@@ -0,0 +1,109 @@
+#include "tools/JobSystem.h"
+#include "tools/Profiler.h"
+
+#include <algorithm>
+#include <string>
+
+static thread_local int currentThreadIndex = 0;
+
+JobSystem::JobSystem(int threads) {
+  if (threads <= 0)
+    threads = static_cast<int>(std::thread::hardware_concurrency());
+  threads = std::max(threads, 1);
+
+  for (int i = 1; i < threads; i++)
+    workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto &worker : workers)
+    worker.join();
+}
+
+int JobSystem::ThreadIndex() { return currentThreadIndex; }
+
+JobSystem &JobSystem::Shared() {
+  static JobSystem shared;
+  return shared;
+}
+
+void JobSystem::Run(size_t itemCount, size_t blockSize, void *jobBody,
+                    BlockFn jobInvoke) {
+  if (itemCount == 0)
+    return;
+  blockSize = std::max<size_t>(blockSize, 1);
+  size_t blockCount = (itemCount + blockSize - 1) / blockSize;
+  if (blockCount == 1 || workers.empty()) {
+    // Same block boundaries as the parallel path, so callers can keep
+    // per-block state
+    for (size_t begin = 0; begin < itemCount; begin += blockSize)
+      jobInvoke(jobBody, begin, std::min(begin + blockSize, itemCount));
+    return;
+  }
+
+  std::lock_guard<std::mutex> serial(submit);
+  {
+    // A worker that woke late for the previous job may still be leaving
+    // RunBlocks; let it finish before the counters are reset
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return active == 0; });
+    body = jobBody;
+    invoke = jobInvoke;
+    count = itemCount;
+    grain = blockSize;
+    blocks = blockCount;
+    nextBlock.store(0, std::memory_order_relaxed);
+    doneBlocks.store(0, std::memory_order_relaxed);
+    generation++;
+  }
+  wake.notify_all();
+
+  RunBlocks();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  finished.wait(lock, [&] {
+    return doneBlocks.load(std::memory_order_acquire) == blocks && active == 0;
+  });
+  body = nullptr;
+}
+
+void JobSystem::WorkerLoop(int index) {
+  currentThreadIndex = index;
+  PROFILE_THREAD(("Worker " + std::to_string(index)).c_str());
+  uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [&] { return stopping || generation != seen; });
+      if (stopping)
+        return;
+      seen = generation;
+      active++;
+    }
+
+    RunBlocks();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      active--;
+    }
+    finished.notify_all();
+  }
+}
+
+void JobSystem::RunBlocks() {
+  PROFILE_SCOPE("Job Blocks");
+  for (;;) {
+    size_t block = nextBlock.fetch_add(1, std::memory_order_relaxed);
+    if (block >= blocks)
+      break;
+    size_t begin = block * grain;
+    invoke(body, begin, std::min(begin + grain, count));
+    doneBlocks.fetch_add(1, std::memory_order_acq_rel);
+  }
+}
@@ -0,0 +1,128 @@
+#include "tools/LatencyStats.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+
+static float msBetween(uint64_t fromNs, uint64_t toNs) {
+  return toNs > fromNs ? static_cast<float>((toNs - fromNs) / 1.0e6) : 0.0f;
+}
+
+void LatencyStats::Add(const FrameTimeline &timeline) {
+  // Frames sampled before the instrumentation started carry no input time
+  if (timeline.inputNs == 0 || timeline.swapNs == 0)
+    return;
+
+  auto it = std::find_if(series.begin(), series.end(), [&](const Series &s) {
+    return std::strcmp(s.renderer, timeline.renderer) == 0;
+  });
+  if (it == series.end()) {
+    series.emplace_back();
+    it = series.end() - 1;
+    it->renderer = timeline.renderer;
+    it->frames.reserve(windowSize);
+  }
+
+  if (it->frames.size() < windowSize) {
+    it->frames.push_back(timeline);
+  } else {
+    it->frames[it->next] = timeline;
+    it->next = (it->next + 1) % windowSize;
+  }
+  it->dirty = true;
+}
+
+void LatencyStats::Update() {
+  for (Series &s : series) {
+    if (s.dirty)
+      Summarize(s);
+  }
+}
+
+void LatencyStats::Summarize(Series &s) {
+  LatencySummary &out = s.summary;
+  out.renderer = s.renderer;
+  out.sampleCount = s.frames.size();
+  s.dirty = false;
+  if (s.frames.empty())
+    return;
+
+  auto percentiles = [&](auto stage) {
+    scratch.clear();
+    for (const FrameTimeline &t : s.frames)
+      scratch.push_back(stage(t));
+    return ComputePercentiles(scratch);
+  };
+  out.queue = percentiles(
+      [](const FrameTimeline &t) { return msBetween(t.inputNs, t.submitBeginNs); });
+  out.submit = percentiles(
+      [](const FrameTimeline &t) { return msBetween(t.submitBeginNs, t.swapNs); });
+  out.present = percentiles(
+      [](const FrameTimeline &t) { return msBetween(t.inputNs, t.swapNs); });
+  out.gpu = percentiles(
+      [](const FrameTimeline &t) { return msBetween(t.inputNs, t.gpuDoneNs); });
+
+  // Throughput from the swaps the window covers
+  auto [first, last] = std::minmax_element(
+      s.frames.begin(), s.frames.end(),
+      [](const FrameTimeline &a, const FrameTimeline &b) { return a.swapNs < b.swapNs; });
+  float spanMs = msBetween(first->swapNs, last->swapNs);
+  out.fps = spanMs > 0.0f ? (s.frames.size() - 1) * 1000.0f / spanMs : 0.0f;
+}
+
+void LatencyStats::DrawImGui() const {
+  if (series.empty()) {
+    ImGui::TextUnformatted("No frames finished yet");
+    return;
+  }
+
+  if (ImGui::BeginTable("##latency", 8,
+                        ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+    ImGui::TableSetupColumn("Strategy");
+    ImGui::TableSetupColumn("FPS");
+    ImGui::TableSetupColumn("Queue p50");
+    ImGui::TableSetupColumn("Present p50");
+    ImGui::TableSetupColumn("Present p99");
+    ImGui::TableSetupColumn("GPU p50");
+    ImGui::TableSetupColumn("GPU p95");
+    ImGui::TableSetupColumn("GPU p99");
+    ImGui::TableHeadersRow();
+
+    for (const Series &s : series) {
+      const LatencySummary &l = s.summary;
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(l.renderer);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", l.fps);
+      for (float v : {l.queue.p50, l.present.p50, l.present.p99, l.gpu.p50,
+                      l.gpu.p95, l.gpu.p99}) {
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", v);
+      }
+    }
+    ImGui::EndTable();
+  }
+  ImGui::TextDisabled("ms from input sampling; GPU = GPU past the swap");
+}
+
+void LatencyStats::WriteJson(std::ostream &os) const {
+  os << "[";
+  for (size_t i = 0; i < series.size(); i++) {
+    const LatencySummary &l = series[i].summary;
+    os << (i ? ",\n" : "\n") << "    {\"renderer\": \"" << l.renderer
+       << "\", \"samples\": " << l.sampleCount << ", \"fps\": " << l.fps;
+    os << ", \"queueMs\": ";
+    WritePercentiles(os, l.queue);
+    os << ", \"submitMs\": ";
+    WritePercentiles(os, l.submit);
+    os << ", \"inputToPresentMs\": ";
+    WritePercentiles(os, l.present);
+    os << ", \"inputToGpuDoneMs\": ";
+    WritePercentiles(os, l.gpu);
+    os << "}";
+  }
+  os << (series.empty() ? "]" : "\n  ]");
+}
@@ -0,0 +1,136 @@
+#include "tools/MappedFile.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() { Close(); }
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string &path) {
+  Close();
+
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    std::cerr << "Could not open file for mapping: " << path << "\n";
+    return false;
+  }
+
+  LARGE_INTEGER fileSize;
+  GetFileSizeEx(file, &fileSize);
+  if (fileSize.QuadPart == 0) {
+    CloseHandle(file);
+    std::cerr << "Cannot map empty file: " << path << "\n";
+    return false;
+  }
+
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  void *view =
+      mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (!view) {
+    if (mapping)
+      CloseHandle(mapping);
+    CloseHandle(file);
+    std::cerr << "Could not map file: " << path << "\n";
+    return false;
+  }
+
+  fileHandle = file;
+  mappingHandle = mapping;
+  data = static_cast<const uint8_t *>(view);
+  size = static_cast<size_t>(fileSize.QuadPart);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data)
+    UnmapViewOfFile(data);
+  if (mappingHandle)
+    CloseHandle(mappingHandle);
+  if (fileHandle)
+    CloseHandle(fileHandle);
+  data = nullptr;
+  size = 0;
+  fileHandle = nullptr;
+  mappingHandle = nullptr;
+}
+
+void MappedFile::Prefetch(size_t offset, size_t length) const {
+  if (!data || offset >= size)
+    return;
+  if (offset + length > size)
+    length = size - offset;
+
+  WIN32_MEMORY_RANGE_ENTRY range;
+  range.VirtualAddress = const_cast<uint8_t *>(data + offset);
+  range.NumberOfBytes = length;
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+#else
+
+bool MappedFile::Open(const std::string &path) {
+  Close();
+
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "Could not open file for mapping: " << path << "\n";
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    std::cerr << "Cannot map empty file: " << path << "\n";
+    return false;
+  }
+
+  void *view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                    MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file.
+  close(fd);
+  if (view == MAP_FAILED) {
+    std::cerr << "Could not map file: " << path << "\n";
+    return false;
+  }
+
+  data = static_cast<const uint8_t *>(view);
+  size = static_cast<size_t>(st.st_size);
+  madvise(view, size, MADV_SEQUENTIAL);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data)
+    munmap(const_cast<uint8_t *>(data), size);
+  data = nullptr;
+  size = 0;
+}
+
+void MappedFile::Prefetch(size_t offset, size_t length) const {
+  if (!data || offset >= size)
+    return;
+  if (offset + length > size)
+    length = size - offset;
+
+  // madvise wants a page-aligned start address.
+  size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t alignedOffset = offset & ~(page - 1);
+  madvise(const_cast<uint8_t *>(data + alignedOffset),
+          length + (offset - alignedOffset), MADV_WILLNEED);
+}
+
+#endif
@@ -0,0 +1,214 @@
+#include "tools/MultiView.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <imgui.h>
+
+#include <algorithm>
+#include <iostream>
+#include <ostream>
+
+const char *MultiViewModeName(MultiViewMode mode) {
+  switch (mode) {
+  case MultiViewMode::Off:
+    return "Off";
+  case MultiViewMode::Repeat:
+    return "Repeat per View";
+  case MultiViewMode::Layered:
+    return "Layered Single Pass";
+  default:
+    return "?";
+  }
+}
+
+void BuildCubeViews(const FrameContext &frame, int count, int size,
+                    FrameContext *views) {
+  // Forward and up per face, the usual cubemap convention
+  static const glm::vec3 faces[MultiViewSettings::MaxViews][2] = {
+      {{1, 0, 0}, {0, -1, 0}},  {{-1, 0, 0}, {0, -1, 0}},
+      {{0, 1, 0}, {0, 0, 1}},   {{0, -1, 0}, {0, 0, -1}},
+      {{0, 0, 1}, {0, -1, 0}},  {{0, 0, -1}, {0, -1, 0}},
+  };
+  const glm::vec3 &eye = frame.cameraPosition;
+  for (int v = 0; v < count; v++) {
+    glm::mat4 view = glm::lookAt(eye, eye + faces[v][0], faces[v][1]);
+    FrameContext &out = views[v];
+    out = FrameContext::FromView(view, eye, glm::radians(90.0f), size, size);
+    out.time = frame.time;
+    out.deltaTime = frame.deltaTime;
+    out.frameIndex = frame.frameIndex;
+    out.objectCount = frame.objectCount;
+  }
+}
+
+// --------------------------------------------------------
+// MultiViewTarget
+// --------------------------------------------------------
+
+void MultiViewTarget::Init() {
+  layered.Create("MultiView");
+  for (GlFramebuffer &framebuffer : single)
+    framebuffer.Create("MultiView");
+  color.Create("MultiView");
+  depth.Create("MultiView");
+  size = layers = 0;
+}
+
+void MultiViewTarget::Shutdown() {
+  layered.Reset();
+  for (GlFramebuffer &framebuffer : single)
+    framebuffer.Reset();
+  color.Reset();
+  depth.Reset();
+  size = layers = 0;
+}
+
+void MultiViewTarget::Resize(int newSize, int newLayers) {
+  size = newSize;
+  layers = newLayers;
+
+  glBindTexture(GL_TEXTURE_2D_ARRAY, color);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size, size, layers, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  color.SetBytes(size_t(size) * size * layers * 4);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, depth);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, size, size, layers,
+               0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  depth.SetBytes(size_t(size) * size * layers * 4);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+  // Attaching the whole array makes the framebuffer layered
+  glBindFramebuffer(GL_FRAMEBUFFER, layered);
+  glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, color, 0);
+  glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depth, 0);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    std::cerr << "ERROR::MULTI_VIEW::INCOMPLETE::" << size << "x" << size << "x"
+              << layers << std::endl;
+  for (int layer = 0; layer < layers; layer++) {
+    glBindFramebuffer(GL_FRAMEBUFFER, single[layer]);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, color, 0, layer);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depth, 0, layer);
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void MultiViewTarget::BeginLayered(int newSize, int newLayers) {
+  if (newSize != size || newLayers != layers)
+    Resize(newSize, newLayers);
+  glBindFramebuffer(GL_FRAMEBUFFER, layered);
+  glViewport(0, 0, size, size);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void MultiViewTarget::BeginLayer(int newSize, int newLayers, int layer) {
+  if (newSize != size || newLayers != layers)
+    Resize(newSize, newLayers);
+  glBindFramebuffer(GL_FRAMEBUFFER, single[layer]);
+  glViewport(0, 0, size, size);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void MultiViewTarget::Present(int windowWidth, int windowHeight) {
+  // Up to three tiles per row, square and as large as the window allows
+  int columns = std::min(layers, 3);
+  int rows = (layers + columns - 1) / columns;
+  int tile = std::min(windowWidth / columns, windowHeight / rows);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  for (int layer = 0; layer < layers; layer++) {
+    int x = (layer % columns) * tile;
+    int y = windowHeight - (layer / columns + 1) * tile;
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, single[layer]);
+    glBlitFramebuffer(0, 0, size, size, x, y, x + tile, y + tile,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(0, 0, windowWidth, windowHeight);
+}
+
+// --------------------------------------------------------
+// MultiViewCost
+// --------------------------------------------------------
+
+void MultiViewCost::Add(MultiViewMode mode, int views,
+                        const RenderCounters &counters, float gpuMs) {
+  int m = static_cast<int>(mode);
+  if (m <= 0 || m >= ModeCount || views <= 0)
+    return;
+
+  Entry &sum = pending[m];
+  if (sum.views != views)
+    sum = Entry{views};
+  sum.frames++;
+  sum.cpuMs += counters.submitMs;
+  sum.gpuMs += gpuMs;
+  sum.drawCalls += static_cast<double>(counters.drawCalls);
+  sum.instances += static_cast<double>(counters.instances);
+  if (sum.frames < Window)
+    return;
+
+  double n = static_cast<double>(sum.frames);
+  Entry &avg = latest[m];
+  avg.views = views;
+  avg.frames = sum.frames;
+  avg.cpuMs = sum.cpuMs / n / views;
+  avg.gpuMs = sum.gpuMs / n / views;
+  avg.drawCalls = sum.drawCalls / n;
+  avg.instances = sum.instances / n;
+  sum = Entry{views};
+}
+
+void MultiViewCost::DrawImGui() const {
+  if (!ImGui::BeginTable("##multiview", 6,
+                         ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit))
+    return;
+  ImGui::TableSetupColumn("Mode");
+  ImGui::TableSetupColumn("Views");
+  ImGui::TableSetupColumn("CPU / view");
+  ImGui::TableSetupColumn("GPU / view");
+  ImGui::TableSetupColumn("Draws");
+  ImGui::TableSetupColumn("Instances");
+  ImGui::TableHeadersRow();
+  for (int m = 1; m < ModeCount; m++) {
+    const Entry &e = latest[m];
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(MultiViewModeName(static_cast<MultiViewMode>(m)));
+    if (e.frames == 0) {
+      ImGui::TableNextColumn();
+      ImGui::TextDisabled("not measured");
+      continue;
+    }
+    ImGui::TableNextColumn();
+    ImGui::Text("%d", e.views);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f ms", e.cpuMs);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f ms", e.gpuMs);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.0f", e.drawCalls);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.0f", e.instances);
+  }
+  ImGui::EndTable();
+}
+
+void MultiViewCost::WriteJson(std::ostream &os) const {
+  os << "[";
+  bool first = true;
+  for (int m = 1; m < ModeCount; m++) {
+    const Entry &e = latest[m];
+    if (e.frames == 0)
+      continue;
+    os << (first ? "" : ",") << "\n    {\"mode\": \""
+       << MultiViewModeName(static_cast<MultiViewMode>(m))
+       << "\", \"views\": " << e.views << ", \"frames\": " << e.frames
+       << ", \"cpuMsPerView\": " << e.cpuMs << ", \"gpuMsPerView\": " << e.gpuMs
+       << ", \"drawCalls\": " << e.drawCalls << ", \"instances\": " << e.instances
+       << "}";
+    first = false;
+  }
+  os << (first ? "]" : "\n  ]");
+}
@@ -0,0 +1,120 @@
+#include "tools/OverdrawMeter.h"
+#include "core/Shader.h"
+
+#include <algorithm>
+
+const char *SubmissionModeName(SubmissionMode mode) {
+  switch (mode) {
+  case SubmissionMode::Unsorted:
+    return "Unsorted";
+  case SubmissionMode::FrontToBack:
+    return "Front to Back";
+  case SubmissionMode::DepthPrepass:
+    return "Depth Pre-pass";
+  default:
+    return "?";
+  }
+}
+
+void OverdrawMeter::Init(int latency) {
+  slots.resize(latency > 1 ? latency : 2);
+  for (auto &slot : slots)
+    slot.query.Create("OverdrawMeter");
+  writeSlot = 0;
+  readSlot = 0;
+  emptyVAO.Create("OverdrawMeter");
+}
+
+void OverdrawMeter::Shutdown() {
+  slots.clear();
+  emptyVAO.Reset();
+}
+
+void OverdrawMeter::Begin(uint64_t frameIndex, bool heatmap) {
+  if (slots.empty())
+    return;
+
+  Slot &slot = slots[writeSlot];
+  // The ring is full: drop the oldest result rather than stall on it.
+  if (slot.pending) {
+    slot.pending = false;
+    readSlot = (readSlot + 1) % slots.size();
+  }
+  slot.frameIndex = frameIndex;
+  glBeginQuery(GL_SAMPLES_PASSED, slot.query);
+
+  stencilActive = heatmap;
+  if (heatmap) {
+    // Counts fragments that pass the depth test; saturates at 255
+    glEnable(GL_STENCIL_TEST);
+    glStencilFunc(GL_ALWAYS, 0, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+  }
+}
+
+void OverdrawMeter::End() {
+  if (slots.empty())
+    return;
+
+  if (stencilActive) {
+    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+    glDisable(GL_STENCIL_TEST);
+  }
+
+  Slot &slot = slots[writeSlot];
+  glEndQuery(GL_SAMPLES_PASSED);
+  slot.pending = true;
+  writeSlot = (writeSlot + 1) % slots.size();
+}
+
+bool OverdrawMeter::Poll(uint64_t &frameIndex, uint64_t &samples) {
+  if (slots.empty())
+    return false;
+
+  Slot &slot = slots[readSlot];
+  if (!slot.pending)
+    return false;
+
+  GLint available = 0;
+  glGetQueryObjectiv(slot.query, GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available)
+    return false;
+
+  GLuint64 result = 0;
+  glGetQueryObjectui64v(slot.query, GL_QUERY_RESULT, &result);
+  frameIndex = slot.frameIndex;
+  samples = result;
+  slot.pending = false;
+  readSlot = (readSlot + 1) % slots.size();
+  return true;
+}
+
+glm::vec4 OverdrawMeter::HeatColor(int level) {
+  if (level <= 0)
+    return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+  // Blue through green and yellow to red, then white for the last band
+  if (level >= HeatLevels)
+    return glm::vec4(1.0f);
+  float t = static_cast<float>(level - 1) / (HeatLevels - 2);
+  return glm::vec4(std::clamp(t * 2.0f - 0.5f, 0.0f, 1.0f),
+                   std::clamp(1.5f - std::abs(t * 3.0f - 1.5f), 0.0f, 1.0f),
+                   std::clamp(1.0f - t * 2.5f, 0.0f, 1.0f), 1.0f);
+}
+
+void OverdrawMeter::DrawHeatmap(const Shader &shader) const {
+  // One full-screen pass per band; each passes where the count reaches its
+  // level, so the highest band a pixel reaches is drawn last
+  glDisable(GL_DEPTH_TEST);
+  glEnable(GL_STENCIL_TEST);
+  glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+  shader.use();
+  glBindVertexArray(emptyVAO);
+  for (int level = 0; level <= HeatLevels; level++) {
+    glStencilFunc(level == 0 ? GL_ALWAYS : GL_LEQUAL, level, 0xFF);
+    shader.setUniform("color", HeatColor(level));
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+  }
+  glBindVertexArray(0);
+  glDisable(GL_STENCIL_TEST);
+  glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,115 @@
+#include "tools/PngWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+static const std::array<uint32_t, 256> &crcTable() {
+  static const std::array<uint32_t, 256> table = [] {
+    std::array<uint32_t, 256> t{};
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; k++)
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      t[n] = c;
+    }
+    return t;
+  }();
+  return table;
+}
+
+static uint32_t crc32(uint32_t crc, const unsigned char *data, size_t size) {
+  const auto &table = crcTable();
+  for (size_t i = 0; i < size; i++)
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return crc;
+}
+
+static void putBigEndian(std::vector<unsigned char> &out, uint32_t value) {
+  out.push_back(static_cast<unsigned char>(value >> 24));
+  out.push_back(static_cast<unsigned char>(value >> 16));
+  out.push_back(static_cast<unsigned char>(value >> 8));
+  out.push_back(static_cast<unsigned char>(value));
+}
+
+static void writeChunk(std::ofstream &file, const char *type,
+                       const std::vector<unsigned char> &data) {
+  std::vector<unsigned char> header;
+  putBigEndian(header, static_cast<uint32_t>(data.size()));
+  header.insert(header.end(), type, type + 4);
+  file.write(reinterpret_cast<const char *>(header.data()), header.size());
+  file.write(reinterpret_cast<const char *>(data.data()), data.size());
+
+  uint32_t crc = crc32(0xFFFFFFFFu, header.data() + 4, 4);
+  crc = crc32(crc, data.data(), data.size()) ^ 0xFFFFFFFFu;
+  std::vector<unsigned char> tail;
+  putBigEndian(tail, crc);
+  file.write(reinterpret_cast<const char *>(tail.data()), tail.size());
+}
+
+bool PngWriter::Write(const std::string &path, int width, int height,
+                      const unsigned char *rgba) {
+  if (width <= 0 || height <= 0 || !rgba)
+    return false;
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    std::cerr << "ERROR::PNG::OPEN_FAILED::" << path << std::endl;
+    return false;
+  }
+
+  static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  file.write(reinterpret_cast<const char *>(signature), sizeof(signature));
+
+  std::vector<unsigned char> ihdr;
+  putBigEndian(ihdr, static_cast<uint32_t>(width));
+  putBigEndian(ihdr, static_cast<uint32_t>(height));
+  ihdr.push_back(8); // bit depth
+  ihdr.push_back(6); // RGBA
+  ihdr.push_back(0); // deflate
+  ihdr.push_back(0); // adaptive filtering
+  ihdr.push_back(0); // no interlace
+  writeChunk(file, "IHDR", ihdr);
+
+  // Scanlines with filter type 0, wrapped in a zlib stream of stored blocks
+  size_t rowBytes = size_t(width) * 4;
+  size_t rawSize = (rowBytes + 1) * height;
+  std::vector<unsigned char> raw(rawSize);
+  for (int y = 0; y < height; y++) {
+    raw[y * (rowBytes + 1)] = 0;
+    std::memcpy(&raw[y * (rowBytes + 1) + 1], rgba + y * rowBytes, rowBytes);
+  }
+
+  constexpr size_t MaxStored = 65535;
+  std::vector<unsigned char> idat;
+  idat.reserve(rawSize + rawSize / MaxStored * 5 + 16);
+  idat.push_back(0x78); // deflate, 32K window
+  idat.push_back(0x01);
+  for (size_t offset = 0;; offset += MaxStored) {
+    size_t size = std::min(MaxStored, rawSize - offset);
+    bool last = offset + size >= rawSize;
+    idat.push_back(last ? 1 : 0);
+    idat.push_back(static_cast<unsigned char>(size));
+    idat.push_back(static_cast<unsigned char>(size >> 8));
+    idat.push_back(static_cast<unsigned char>(~size));
+    idat.push_back(static_cast<unsigned char>(~size >> 8));
+    idat.insert(idat.end(), raw.begin() + offset, raw.begin() + offset + size);
+    if (last)
+      break;
+  }
+
+  uint32_t a = 1, b = 0;
+  for (unsigned char byte : raw) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+  putBigEndian(idat, (b << 16) | a);
+  writeChunk(file, "IDAT", idat);
+  writeChunk(file, "IEND", {});
+
+  return static_cast<bool>(file);
+}
@@ -0,0 +1,299 @@
+#include "tools/Profiler.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#if RENDERBENCH_PROFILE
+thread_local uint32_t profileDepth = 0;
+#endif
+
+thread_local Profiler::LocalHandle Profiler::local;
+
+Profiler::LocalHandle::~LocalHandle() {
+  if (buffer)
+    Profiler::Get().Release(*buffer);
+}
+
+Profiler &Profiler::Get() {
+  static Profiler profiler;
+  return profiler;
+}
+
+uint64_t Profiler::Now() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+Profiler::ThreadBuffer &Profiler::Local() {
+  if (local.buffer)
+    return *local.buffer;
+
+  // A ring whose thread exited is reused before a new one is allocated; its
+  // old events stay until the new owner laps them
+  std::lock_guard<std::mutex> lock(registry);
+  for (const auto &thread : threads) {
+    if (!thread->inUse) {
+      thread->inUse = true;
+      thread->name = "Thread " + std::to_string(thread->index);
+      local.buffer = thread.get();
+      return *thread;
+    }
+  }
+  threads.push_back(std::make_unique<ThreadBuffer>());
+  ThreadBuffer &buffer = *threads.back();
+  buffer.index = static_cast<uint32_t>(threads.size() - 1);
+  buffer.name = "Thread " + std::to_string(buffer.index);
+  local.buffer = &buffer;
+  return buffer;
+}
+
+void Profiler::Release(ThreadBuffer &buffer) {
+  std::lock_guard<std::mutex> lock(registry);
+  buffer.inUse = false;
+}
+
+void Profiler::Record(const char *name, uint64_t startNs, uint64_t endNs,
+                      uint32_t depth) {
+  ThreadBuffer &buffer = Local();
+  uint64_t index = buffer.written.load(std::memory_order_relaxed);
+  Slot &slot = buffer.slots[index % EventsPerThread];
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.startNs.store(startNs, std::memory_order_relaxed);
+  slot.endNs.store(endNs, std::memory_order_relaxed);
+  slot.depth.store(depth, std::memory_order_relaxed);
+  buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::RecordGpu(uint64_t frameIndex, uint64_t startNs, uint64_t endNs) {
+  gpu[gpuCount % FrameHistory] = {frameIndex, startNs, endNs};
+  gpuCount++;
+}
+
+void Profiler::SetThreadName(const char *name) {
+  ThreadBuffer &buffer = Local();
+  std::lock_guard<std::mutex> lock(registry);
+  buffer.name = name;
+}
+
+void Profiler::BeginFrame(uint64_t frameIndex) {
+  frames[frameCount % FrameHistory] = {frameIndex, Now()};
+  frameCount++;
+}
+
+bool Profiler::FrameWindow(size_t framesBack, size_t count, uint64_t &fromNs,
+                           uint64_t &toNs) const {
+  // The newest mark opens the frame still in progress
+  size_t available = static_cast<size_t>(std::min<uint64_t>(frameCount, FrameHistory));
+  if (available < 2)
+    return false;
+  framesBack = std::min(framesBack, available - 2);
+  count = std::clamp<size_t>(count, 1, available - 1 - framesBack);
+
+  uint64_t last = frameCount - 1 - framesBack;
+  toNs = frames[last % FrameHistory].startNs;
+  fromNs = frames[(last - count) % FrameHistory].startNs;
+  return true;
+}
+
+void Profiler::Collect(uint64_t fromNs, uint64_t toNs,
+                       std::vector<ProfileEvent> &out) const {
+  out.clear();
+  for (uint64_t i = gpuCount > FrameHistory ? gpuCount - FrameHistory : 0;
+       i < gpuCount; i++) {
+    const GpuSpan &span = gpu[i % FrameHistory];
+    if (span.endNs > fromNs && span.startNs < toNs)
+      out.push_back({"GPU frame", span.startNs, span.endNs, 0, GpuThread,
+                     span.frameIndex});
+  }
+
+  std::lock_guard<std::mutex> lock(registry);
+  for (const auto &thread : threads) {
+    const ThreadBuffer &buffer = *thread;
+    uint64_t end = buffer.written.load(std::memory_order_acquire);
+    uint64_t begin = end > EventsPerThread ? end - EventsPerThread : 0;
+    size_t first = out.size();
+    for (uint64_t i = begin; i < end; i++) {
+      const Slot &slot = buffer.slots[i % EventsPerThread];
+      ProfileEvent event;
+      // Acquire keeps the write count check below from being hoisted
+      event.name = slot.name.load(std::memory_order_acquire);
+      event.startNs = slot.startNs.load(std::memory_order_acquire);
+      event.endNs = slot.endNs.load(std::memory_order_acquire);
+      event.depth = slot.depth.load(std::memory_order_acquire);
+      event.thread = buffer.index;
+      event.frame = i; // ring index until the lap check below
+      if (event.endNs > fromNs && event.startNs < toNs)
+        out.push_back(event);
+    }
+
+    // Slots the writer has reached again since they were read may be torn;
+    // the margin also covers the one event it may be writing right now
+    uint64_t after = buffer.written.load(std::memory_order_acquire) + 2;
+    uint64_t safeFrom = after > EventsPerThread ? after - EventsPerThread : 0;
+    auto torn = std::remove_if(out.begin() + first, out.end(),
+                               [&](const ProfileEvent &e) { return e.frame < safeFrom; });
+    out.erase(torn, out.end());
+    for (auto it = out.begin() + first; it != out.end(); ++it)
+      it->frame = 0;
+  }
+}
+
+std::string Profiler::ThreadName(uint32_t thread) const {
+  if (thread == GpuThread)
+    return "GPU";
+  std::lock_guard<std::mutex> lock(registry);
+  return thread < threads.size() ? threads[thread]->name : "?";
+}
+
+static void writeJsonString(std::ostream &os, const char *text) {
+  os << '"';
+  for (const char *p = text ? text : ""; *p; p++) {
+    if (*p == '"' || *p == '\\')
+      os << '\\';
+    os << *p;
+  }
+  os << '"';
+}
+
+bool Profiler::ExportChromeTrace(const char *path, size_t frameCountToExport) const {
+  uint64_t fromNs, toNs;
+  if (!FrameWindow(0, frameCountToExport, fromNs, toNs)) {
+    std::cerr << "ERROR::PROFILER::NO_FRAMES" << std::endl;
+    return false;
+  }
+  std::vector<ProfileEvent> events;
+  Collect(fromNs, toNs, events);
+
+  std::ofstream file(path);
+  if (!file) {
+    std::cerr << "ERROR::PROFILER::OPEN_FAILED::" << path << std::endl;
+    return false;
+  }
+
+  // Timestamps are microseconds relative to the window start
+  auto micros = [&](uint64_t ns) { return (static_cast<double>(ns) - fromNs) / 1000.0; };
+
+  file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+  std::vector<uint32_t> named;
+  bool first = true;
+  char number[64];
+  for (const ProfileEvent &e : events) {
+    if (std::find(named.begin(), named.end(), e.thread) == named.end()) {
+      named.push_back(e.thread);
+      file << (first ? "" : ",\n")
+           << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+           << e.thread << ",\"args\":{\"name\":";
+      writeJsonString(file, ThreadName(e.thread).c_str());
+      file << "}}";
+      first = false;
+    }
+
+    file << (first ? "" : ",\n") << "{\"name\":";
+    writeJsonString(file, e.name);
+    std::snprintf(number, sizeof(number), ",\"ts\":%.3f,\"dur\":%.3f",
+                  micros(e.startNs), (e.endNs - e.startNs) / 1000.0);
+    file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread << number;
+    if (e.thread == GpuThread)
+      file << ",\"args\":{\"frame\":" << e.frame << "}";
+    file << "}";
+    first = false;
+  }
+  file << "\n]}\n";
+
+  std::cout << "SUCCESS::PROFILER::TRACE_EXPORTED::" << path << " ("
+            << events.size() << " events)" << std::endl;
+  return static_cast<bool>(file);
+}
+
+// Stable colour per scope name
+static ImU32 scopeColor(const char *name) {
+  uint32_t h = 2166136261u;
+  for (const char *p = name ? name : ""; *p; p++)
+    h = (h ^ static_cast<unsigned char>(*p)) * 16777619u;
+  return IM_COL32(80 + (h & 0x7F), 80 + ((h >> 8) & 0x7F), 80 + ((h >> 16) & 0x7F), 255);
+}
+
+void Profiler::DrawImGui() {
+  bool enabled = Enabled();
+  if (ImGui::Checkbox("Enabled", &enabled))
+    SetEnabled(enabled);
+  ImGui::SameLine();
+  ImGui::Checkbox("Pause", &paused);
+  ImGui::SameLine();
+  if (ImGui::Button("Export Trace"))
+    ExportChromeTrace("profile_trace.json", 120);
+  ImGui::SliderFloat("Zoom", &zoom, 1.0f, 32.0f, "%.1fx", ImGuiSliderFlags_Logarithmic);
+
+  if (!paused && FrameWindow(0, 1, viewFromNs, viewToNs))
+    Collect(viewFromNs, viewToNs, view);
+  if (viewToNs <= viewFromNs) {
+    ImGui::TextUnformatted("No complete frame yet");
+    return;
+  }
+
+  double spanNs = static_cast<double>(viewToNs - viewFromNs);
+  ImGui::Text("Frame: %.3f ms, %zu events", spanNs / 1.0e6, view.size());
+
+  // One lane per nesting level, threads stacked, GPU first
+  std::sort(view.begin(), view.end(), [](const ProfileEvent &a, const ProfileEvent &b) {
+    bool aGpu = a.thread == GpuThread, bGpu = b.thread == GpuThread;
+    if (aGpu != bGpu)
+      return aGpu;
+    if (a.thread != b.thread)
+      return a.thread < b.thread;
+    return a.startNs < b.startNs;
+  });
+
+  const float laneHeight = ImGui::GetTextLineHeight() + 4.0f;
+  const float labelWidth = 110.0f;
+  ImGui::BeginChild("##flame", ImVec2(0.0f, 260.0f), true,
+                    ImGuiWindowFlags_HorizontalScrollbar);
+  float width = (ImGui::GetContentRegionAvail().x - labelWidth) * zoom;
+  ImVec2 origin = ImGui::GetCursorScreenPos();
+  ImDrawList *draw = ImGui::GetWindowDrawList();
+  ImVec2 mouse = ImGui::GetIO().MousePos;
+
+  float y = origin.y;
+  size_t i = 0;
+  while (i < view.size()) {
+    uint32_t thread = view[i].thread;
+    uint32_t maxDepth = 0;
+    size_t end = i;
+    while (end < view.size() && view[end].thread == thread)
+      maxDepth = std::max(maxDepth, view[end++].depth);
+
+    draw->AddText(ImVec2(origin.x, y + 2.0f), IM_COL32(220, 220, 220, 255),
+                  ThreadName(thread).c_str());
+    for (; i < end; i++) {
+      const ProfileEvent &e = view[i];
+      double start = std::max<double>(static_cast<double>(e.startNs) - viewFromNs, 0.0);
+      double stop = std::min<double>(static_cast<double>(e.endNs) - viewFromNs, spanNs);
+      float x0 = origin.x + labelWidth + static_cast<float>(start / spanNs) * width;
+      float x1 = origin.x + labelWidth + static_cast<float>(stop / spanNs) * width;
+      x1 = std::max(x1, x0 + 1.0f);
+      float y0 = y + e.depth * laneHeight;
+      float y1 = y0 + laneHeight - 1.0f;
+
+      draw->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y1), scopeColor(e.name));
+      if (x1 - x0 > 30.0f) {
+        draw->PushClipRect(ImVec2(x0, y0), ImVec2(x1, y1), true);
+        draw->AddText(ImVec2(x0 + 2.0f, y0 + 2.0f), IM_COL32(0, 0, 0, 255), e.name);
+        draw->PopClipRect();
+      }
+      if (mouse.x >= x0 && mouse.x < x1 && mouse.y >= y0 && mouse.y < y1 &&
+          ImGui::IsWindowHovered())
+        ImGui::SetTooltip("%s\n%.3f ms", e.name, (e.endNs - e.startNs) / 1.0e6);
+    }
+    y += (maxDepth + 1) * laneHeight + 6.0f;
+  }
+
+  ImGui::Dummy(ImVec2(labelWidth + width, y - origin.y));
+  ImGui::EndChild();
+}
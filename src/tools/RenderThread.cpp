@@ -0,0 +1,303 @@
+#include "tools/RenderThread.h"
+#include "tools/Profiler.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cstring>
+
+template <typename T>
+static void copyVector(ImVector<T> &to, const ImVector<T> &from) {
+  // resize keeps the capacity, assignment would free it
+  to.resize(from.Size);
+  if (from.Size > 0)
+    std::memcpy(to.Data, from.Data, size_t(from.Size) * sizeof(T));
+}
+
+UiDrawData::~UiDrawData() {
+  for (ImDrawList *list : lists)
+    IM_DELETE(list);
+}
+
+void UiDrawData::Capture(const ImDrawData *source) {
+  if (!source || !source->Valid) {
+    data.Valid = false;
+    return;
+  }
+
+  while (lists.size() < size_t(source->CmdListsCount))
+    lists.push_back(IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData()));
+  for (int i = 0; i < source->CmdListsCount; i++) {
+    const ImDrawList *from = source->CmdLists[i];
+    ImDrawList *to = lists[i];
+    copyVector(to->CmdBuffer, from->CmdBuffer);
+    copyVector(to->IdxBuffer, from->IdxBuffer);
+    copyVector(to->VtxBuffer, from->VtxBuffer);
+    to->Flags = from->Flags;
+  }
+
+  data.Valid = true;
+  data.CmdListsCount = source->CmdListsCount;
+  data.TotalIdxCount = source->TotalIdxCount;
+  data.TotalVtxCount = source->TotalVtxCount;
+  data.CmdLists = lists.data();
+  data.DisplayPos = source->DisplayPos;
+  data.DisplaySize = source->DisplaySize;
+  data.FramebufferScale = source->FramebufferScale;
+  data.OwnerViewport = nullptr;
+}
+
+void RenderReport::MoveInto(RenderReport &target) {
+  target.gpuFrames.insert(target.gpuFrames.end(), gpuFrames.begin(),
+                          gpuFrames.end());
+  gpuFrames.clear();
+  for (ReadbackResult &result : readbacks)
+    target.readbacks.push_back(std::move(result));
+  readbacks.clear();
+  target.timelines.insert(target.timelines.end(), timelines.begin(),
+                          timelines.end());
+  timelines.clear();
+
+  target.rendererName = rendererName;
+  target.rendererIndex = rendererIndex;
+  target.multiViewMode = multiViewMode;
+  target.viewCount = viewCount;
+  target.counters = counters;
+  target.countersFrame = countersFrame;
+  target.objectCount = objectCount;
+  target.sceneGpuMs = sceneGpuMs;
+  target.renderWidth = renderWidth;
+  target.renderHeight = renderHeight;
+  target.shadedSamples = shadedSamples;
+  target.switchMs = switchMs;
+  target.readbackInFlight = readbackInFlight;
+  target.readbackQueued = readbackQueued;
+  target.readbackDropped = readbackDropped;
+  target.arenaUsed = arenaUsed;
+  target.arenaCapacity = arenaCapacity;
+  target.gpuFramesInFlight = gpuFramesInFlight;
+  target.gpuWaitMs = gpuWaitMs;
+}
+
+static uint64_t nsSince(RenderThread::Clock::time_point start) {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   RenderThread::Clock::now() - start)
+                                   .count());
+}
+
+void RenderThread::Start(GLFWwindow *targetWindow, int snapshotCount,
+                         bool runThreaded, DrawFn drawFn) {
+  Stop();
+  window = targetWindow;
+  draw = std::move(drawFn);
+  threaded = runThreaded;
+
+  slots.clear();
+  for (int i = 0; i < std::clamp(snapshotCount, 2, MaxSnapshots); i++)
+    slots.push_back(std::make_unique<FrameSnapshot>());
+  submitted = drawn = sceneReleased = 0;
+  stopping = false;
+
+  mainIdleNs = renderBusyNs = 0;
+  windowStart = Clock::now();
+  windowFrames = windowMainIdleNs = windowRenderBusyNs = 0;
+  load = ThreadLoad{};
+
+  if (threaded) {
+    // A context is current on one thread at a time
+    glfwMakeContextCurrent(nullptr);
+    worker = std::thread(&RenderThread::Run, this);
+  } else {
+    pacer.Init();
+  }
+}
+
+void RenderThread::Stop() {
+  if (worker.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+    glfwMakeContextCurrent(window);
+  }
+  // Unthreaded, the pacer lives on this thread; threaded, Run already shut
+  // it down
+  pacer.Shutdown();
+}
+
+FrameSnapshot &RenderThread::Acquire() {
+  // EndFrame already waited for this slot to be drawn
+  FrameSnapshot &snapshot = *slots[submitted % slots.size()];
+  snapshot.commands.clear();
+  return snapshot;
+}
+
+void RenderThread::Submit() {
+  if (!threaded) {
+    FrameSnapshot &snapshot = *slots[submitted % slots.size()];
+    submitted++;
+    Draw(snapshot);
+    drawn++;
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    submitted++;
+  }
+  wake.notify_one();
+}
+
+void RenderThread::EndFrame() {
+  if (submitted == 0)
+    return;
+  FrameSnapshot &last = *slots[(submitted - 1) % slots.size()];
+  if (!threaded) {
+    Present(last);
+    return;
+  }
+
+  PROFILE_SCOPE("Wait Render");
+  Clock::time_point start = Clock::now();
+  // Settings are only read on the render thread, so this read is safe
+  bool lowLatency = last.settings.lowLatency;
+  std::unique_lock<std::mutex> lock(mutex);
+  progress.wait(lock, [&] {
+    return lowLatency ? drawn == submitted : submitted - drawn < slots.size();
+  });
+  mainIdleNs += nsSince(start);
+}
+
+void RenderThread::WaitForScene() {
+  if (!threaded)
+    return;
+  PROFILE_SCOPE("Wait Scene");
+  Clock::time_point start = Clock::now();
+  std::unique_lock<std::mutex> lock(mutex);
+  progress.wait(lock, [&] { return sceneReleased == submitted; });
+  mainIdleNs += nsSince(start);
+}
+
+void RenderThread::ReleaseScene() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    // The snapshot being drawn is number drawn + 1
+    sceneReleased = drawn + 1;
+  }
+  progress.notify_all();
+}
+
+void RenderThread::TakeReport(RenderReport &out) {
+  out.gpuFrames.clear();
+  out.readbacks.clear();
+  out.timelines.clear();
+  std::lock_guard<std::mutex> lock(reportMutex);
+  report.MoveInto(out);
+}
+
+void RenderThread::SampleLoad() {
+  Clock::time_point now = Clock::now();
+  double wallMs = std::chrono::duration<double, std::milli>(now - windowStart).count();
+  if (wallMs < 500.0)
+    return;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  uint64_t frames = drawn - windowFrames;
+  if (frames == 0)
+    return;
+
+  load.frameMs = wallMs / frames;
+  load.renderBusyMs = (renderBusyNs - windowRenderBusyNs) / 1.0e6 / frames;
+  load.renderIdleMs = std::max(load.frameMs - load.renderBusyMs, 0.0);
+  load.mainIdleMs = (mainIdleNs - windowMainIdleNs) / 1.0e6 / frames;
+  // Unthreaded, the drawing runs on the main thread but counts as render work
+  load.mainBusyMs = std::max(
+      load.frameMs - load.mainIdleMs - (threaded ? 0.0 : load.renderBusyMs), 0.0);
+  load.overlapMs =
+      std::max(load.mainBusyMs + load.renderBusyMs - load.frameMs, 0.0);
+
+  windowStart = now;
+  windowFrames = drawn;
+  windowMainIdleNs = mainIdleNs;
+  windowRenderBusyNs = renderBusyNs;
+}
+
+void RenderThread::Run() {
+  PROFILE_THREAD("Render");
+  glfwMakeContextCurrent(window);
+  pacer.Init();
+  for (;;) {
+    FrameSnapshot *snapshot;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [&] { return stopping || drawn < submitted; });
+      if (drawn == submitted)
+        break;
+      snapshot = slots[drawn % slots.size()].get();
+    }
+
+    Draw(*snapshot);
+    Present(*snapshot);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      drawn++;
+    }
+    progress.notify_all();
+  }
+  pacer.Shutdown();
+  glfwMakeContextCurrent(nullptr);
+}
+
+void RenderThread::Draw(FrameSnapshot &snapshot) {
+  PROFILE_SCOPE("Render Frame");
+  uint64_t waitNs;
+  {
+    PROFILE_SCOPE("Wait GPU");
+    waitNs = pacer.Throttle(snapshot.settings.framesInFlight, pending.timelines);
+  }
+  pending.gpuWaitMs = waitNs / 1.0e6;
+
+  uint64_t start = Profiler::Now();
+  snapshot.timeline.submitBeginNs = start;
+  draw(snapshot, pending);
+  // In case the draw function never let go of the scene
+  ReleaseScene();
+  snapshot.timeline.submitEndNs = Profiler::Now();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  renderBusyNs += snapshot.timeline.submitEndNs - start;
+  // Inline, waiting on the GPU is the main thread's idle time
+  if (!threaded)
+    mainIdleNs += waitNs;
+}
+
+void RenderThread::Present(FrameSnapshot &snapshot) {
+  uint64_t start = Profiler::Now();
+  {
+    PROFILE_SCOPE("SwapBuffers");
+    glfwSwapBuffers(window);
+  }
+  snapshot.timeline.swapNs = Profiler::Now();
+  pacer.Fence(snapshot.timeline);
+
+  uint64_t waitNs = 0;
+  if (snapshot.settings.lowLatency) {
+    PROFILE_SCOPE("Wait GPU");
+    waitNs = pacer.Drain(pending.timelines);
+  } else {
+    pacer.Poll(pending.timelines);
+  }
+  pending.gpuFramesInFlight = pacer.InFlight();
+
+  {
+    std::lock_guard<std::mutex> lock(reportMutex);
+    pending.MoveInto(report);
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  renderBusyNs += Profiler::Now() - start - waitNs;
+  if (!threaded)
+    mainIdleNs += waitNs;
+}
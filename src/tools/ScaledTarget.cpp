@@ -0,0 +1,71 @@
+#include "tools/ScaledTarget.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+int ScaledTarget::ScaledSize(int size, float scale) {
+  return std::max(1, static_cast<int>(std::lround(size * scale)));
+}
+
+void ScaledTarget::Init() {
+  framebuffer.Create("ScaledTarget");
+  color.Create("ScaledTarget");
+  depthStencil.Create("ScaledTarget");
+  width = 0;
+  height = 0;
+}
+
+void ScaledTarget::Shutdown() {
+  framebuffer.Reset();
+  color.Reset();
+  depthStencil.Reset();
+  width = 0;
+  height = 0;
+}
+
+void ScaledTarget::Resize(int newWidth, int newHeight) {
+  width = newWidth;
+  height = newHeight;
+
+  glBindTexture(GL_TEXTURE_2D, color);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  color.SetBytes(size_t(width) * height * 4);
+
+  // Stencil too: the overdraw heatmap counts layers in it
+  glBindTexture(GL_TEXTURE_2D, depthStencil);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0,
+               GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  depthStencil.SetBytes(size_t(width) * height * 4);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         color, 0);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                         GL_TEXTURE_2D, depthStencil, 0);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    std::cerr << "ERROR::SCALED_TARGET::INCOMPLETE::" << width << "x" << height
+              << std::endl;
+}
+
+void ScaledTarget::Begin(int newWidth, int newHeight) {
+  if (newWidth != width || newHeight != height)
+    Resize(newWidth, newHeight);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glViewport(0, 0, width, height);
+}
+
+void ScaledTarget::Resolve(int windowWidth, int windowHeight) {
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBlitFramebuffer(0, 0, width, height, 0, 0, windowWidth, windowHeight,
+                    GL_COLOR_BUFFER_BIT, GL_LINEAR);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(0, 0, windowWidth, windowHeight);
+}
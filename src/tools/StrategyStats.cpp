@@ -0,0 +1,125 @@
+#include "tools/StrategyStats.h"
+
+#include <imgui.h>
+
+#include <ostream>
+
+namespace {
+
+struct Row {
+  const char *label;
+  const char *key; // JSON
+  double StrategyAverages::*value;
+  const char *format;
+};
+
+const Row Rows[] = {
+    {"Draw calls", "drawCalls", &StrategyAverages::drawCalls, "%.0f"},
+    {"Instances", "instances", &StrategyAverages::instances, "%.0f"},
+    {"Triangles", "triangles", &StrategyAverages::triangles, "%.0f"},
+    {"Vertices", "vertices", &StrategyAverages::vertices, "%.0f"},
+    {"State changes", "stateChanges", &StrategyAverages::stateChanges, "%.0f"},
+    {"Texture binds", "textureBinds", &StrategyAverages::textureBinds, "%.0f"},
+    {"Uploaded (KB)", "uploadBytes", &StrategyAverages::uploadBytes, "%.1f"},
+    {"Submit CPU (ms)", "submitMs", &StrategyAverages::submitMs, "%.3f"},
+    {"Scene GPU (ms)", "gpuMs", &StrategyAverages::gpuMs, "%.3f"},
+    {"Frame (ms)", "frameMs", &StrategyAverages::frameMs, "%.3f"},
+};
+
+} // namespace
+
+StrategyStats::StrategyStats(const char *const *names, int count)
+    : averages(count), pending(count) {
+  for (int i = 0; i < count; i++)
+    averages[i].strategy = names[i];
+}
+
+void StrategyStats::Add(int strategy, const RenderCounters &counters,
+                        float frameMs, float gpuMs) {
+  if (strategy < 0 || strategy >= static_cast<int>(averages.size()))
+    return;
+  size_t index = static_cast<size_t>(strategy);
+
+  Accumulator &acc = pending[index];
+  acc.sum.drawCalls += counters.drawCalls;
+  acc.sum.instances += counters.instances;
+  acc.sum.triangles += counters.triangles;
+  acc.sum.vertices += counters.vertices;
+  acc.sum.stateChanges += counters.stateChanges;
+  acc.sum.textureBinds += counters.textureBinds;
+  acc.sum.uploadBytes += counters.uploadBytes;
+  acc.sum.submitMs += counters.submitMs;
+  acc.frameMs += frameMs;
+  acc.gpuMs += gpuMs;
+  if (++acc.frames < Window)
+    return;
+
+  StrategyAverages &avg = averages[index];
+  double n = acc.frames;
+  avg.frames = acc.frames;
+  avg.drawCalls = acc.sum.drawCalls / n;
+  avg.instances = acc.sum.instances / n;
+  avg.triangles = acc.sum.triangles / n;
+  avg.vertices = acc.sum.vertices / n;
+  avg.stateChanges = acc.sum.stateChanges / n;
+  avg.textureBinds = acc.sum.textureBinds / n;
+  avg.uploadBytes = acc.sum.uploadBytes / n;
+  avg.submitMs = acc.sum.submitMs / n;
+  avg.frameMs = acc.frameMs / n;
+  avg.gpuMs = acc.gpuMs / n;
+  acc = Accumulator{};
+}
+
+void StrategyStats::Reset() {
+  for (size_t i = 0; i < averages.size(); i++) {
+    std::string name = std::move(averages[i].strategy);
+    averages[i] = StrategyAverages{};
+    averages[i].strategy = std::move(name);
+    pending[i] = Accumulator{};
+  }
+}
+
+void StrategyStats::DrawImGui() const {
+  int columns = static_cast<int>(averages.size()) + 1;
+  if (!ImGui::BeginTable("##strategies", columns,
+                         ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit))
+    return;
+  ImGui::TableSetupColumn("Per frame");
+  for (const StrategyAverages &avg : averages)
+    ImGui::TableSetupColumn(avg.strategy.c_str());
+  ImGui::TableHeadersRow();
+
+  for (const Row &row : Rows) {
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(row.label);
+    for (const StrategyAverages &avg : averages) {
+      ImGui::TableNextColumn();
+      if (avg.frames == 0) {
+        ImGui::TextDisabled("-");
+        continue;
+      }
+      double value = avg.*row.value;
+      if (row.value == &StrategyAverages::uploadBytes)
+        value /= 1024.0;
+      ImGui::Text(row.format, value);
+    }
+  }
+  ImGui::EndTable();
+}
+
+void StrategyStats::WriteJson(std::ostream &os) const {
+  os << "[";
+  bool first = true;
+  for (const StrategyAverages &avg : averages) {
+    if (avg.frames == 0)
+      continue;
+    os << (first ? "" : ",") << "\n    {\"strategy\": \"" << avg.strategy
+       << "\", \"frames\": " << avg.frames;
+    for (const Row &row : Rows)
+      os << ", \"" << row.key << "\": " << avg.*row.value;
+    os << "}";
+    first = false;
+  }
+  os << (first ? "]" : "\n  ]");
+}
@@ -0,0 +1,269 @@
+#include "tools/TextureBatcher.h"
+#include "tools/Profiler.h"
+#include "tools/filemanager.h"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+uint32_t TextureBatcher::Add(int width, int height, const unsigned char *rgba) {
+  Source source;
+  source.width = width;
+  source.height = height;
+  source.pixels.assign(rgba, rgba + size_t(width) * height * 4);
+  sources.push_back(std::move(source));
+  regions.emplace_back();
+  return static_cast<uint32_t>(sources.size() - 1);
+}
+
+uint32_t TextureBatcher::AddFile(const std::string &path, bool flip) {
+  PROFILE_SCOPE("Texture Load");
+  stbi_set_flip_vertically_on_load(flip);
+
+  // Decodes straight from the archive or the mapped file
+  AssetData file;
+  unsigned char *data = nullptr;
+  int width, height, nrChannels;
+  if (VirtualFileSystem::shared().open(path, file))
+    data = stbi_load_from_memory(file.Data(), static_cast<int>(file.Size()),
+                                 &width, &height, &nrChannels, 4);
+  if (!data) {
+    std::cerr << "Failed to load texture: " << path << "\n";
+    // Keep the slot valid with a 1x1 magenta placeholder
+    const unsigned char missing[4] = {255, 0, 255, 255};
+    return Add(1, 1, missing);
+  }
+
+  uint32_t slot = Add(width, height, data);
+  stbi_image_free(data);
+  return slot;
+}
+
+// Size a texture ends up at once it fits a layer
+static void fitSize(int maxSize, int &width, int &height) {
+  if (width <= maxSize && height <= maxSize)
+    return;
+  float scale = static_cast<float>(maxSize) / std::max(width, height);
+  width = std::max(1, static_cast<int>(width * scale));
+  height = std::max(1, static_cast<int>(height * scale));
+}
+
+// Nearest-neighbour downscale for textures bigger than a layer
+static void shrinkToFit(int maxSize, int &width, int &height,
+                        std::vector<unsigned char> &pixels) {
+  int newWidth = width, newHeight = height;
+  fitSize(maxSize, newWidth, newHeight);
+  if (newWidth == width && newHeight == height)
+    return;
+
+  std::vector<unsigned char> out(size_t(newWidth) * newHeight * 4);
+  for (int y = 0; y < newHeight; y++) {
+    int sy = y * height / newHeight;
+    for (int x = 0; x < newWidth; x++) {
+      int sx = x * width / newWidth;
+      std::copy_n(&pixels[(size_t(sy) * width + sx) * 4], 4,
+                  &out[(size_t(y) * newWidth + x) * 4]);
+    }
+  }
+
+  width = newWidth;
+  height = newHeight;
+  pixels = std::move(out);
+}
+
+bool TextureBatcher::Build(int requestedLayerSize) {
+  PROFILE_SCOPE("TextureBatcher Build");
+  if (sources.empty())
+    return false;
+
+  // Pick the layer size
+  int largest = 1;
+  for (const Source &s : sources)
+    largest = std::max({largest, s.width, s.height});
+  int size = requestedLayerSize;
+  if (size <= 0) {
+    size = 16;
+    while (size < largest && size < MaxLayerSize)
+      size *= 2;
+  }
+  size = std::min(size, MaxLayerSize);
+
+  // Packing works on the fitted sizes; nothing is changed until it succeeds,
+  // so a failed Build leaves the previous one intact
+  std::vector<glm::ivec2> sizes(sources.size());
+  for (size_t i = 0; i < sources.size(); i++) {
+    sizes[i] = glm::ivec2(sources[i].width, sources[i].height);
+    fitSize(size, sizes[i].x, sizes[i].y);
+  }
+
+  // Tallest first keeps the shelves tight
+  std::vector<uint32_t> order(sources.size());
+  std::iota(order.begin(), order.end(), 0u);
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    if (sizes[a].y != sizes[b].y)
+      return sizes[a].y > sizes[b].y;
+    return sizes[a].x > sizes[b].x;
+  });
+
+  struct Shelf {
+    int y, height, x;
+  };
+  struct AtlasLayer {
+    uint32_t layer;
+    int nextY = 0;
+    std::vector<Shelf> shelves;
+  };
+  struct Placement {
+    uint32_t layer;
+    int x, y;
+  };
+
+  std::vector<AtlasLayer> atlases;
+  std::vector<Placement> placements(sources.size());
+  std::vector<TextureRegion> built(sources.size());
+  size_t layers = 0;
+  size_t packed = 0;
+
+  const float inv = 1.0f / static_cast<float>(size);
+  for (uint32_t index : order) {
+    const glm::ivec2 fitted = sizes[index];
+    Placement p{};
+
+    if (fitted.x > size / 2 || fitted.y > size / 2) {
+      // Layer-sized texture: gets a layer to itself
+      p = {static_cast<uint32_t>(layers++), 0, 0};
+    } else {
+      int w = fitted.x + 2 * Gutter;
+      int h = fitted.y + 2 * Gutter;
+      bool placed = false;
+
+      for (AtlasLayer &atlas : atlases) {
+        for (Shelf &shelf : atlas.shelves) {
+          if (shelf.height >= h && shelf.x + w <= size) {
+            p = {atlas.layer, shelf.x + Gutter, shelf.y + Gutter};
+            shelf.x += w;
+            placed = true;
+            break;
+          }
+        }
+        if (!placed && atlas.nextY + h <= size) {
+          atlas.shelves.push_back({atlas.nextY, h, w});
+          p = {atlas.layer, Gutter, atlas.nextY + Gutter};
+          atlas.nextY += h;
+          placed = true;
+        }
+        if (placed)
+          break;
+      }
+
+      if (!placed) {
+        AtlasLayer atlas;
+        atlas.layer = static_cast<uint32_t>(layers++);
+        atlas.shelves.push_back({0, h, w});
+        atlas.nextY = h;
+        atlases.push_back(std::move(atlas));
+        p = {atlases.back().layer, Gutter, Gutter};
+      }
+      packed++;
+    }
+
+    placements[index] = p;
+    built[index].layer = p.layer;
+    built[index].uvRect = glm::vec4(p.x * inv, p.y * inv, fitted.x * inv,
+                                    fitted.y * inv);
+  }
+
+  GLint maxLayers = 0;
+  glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+  if (static_cast<GLint>(layers) > maxLayers) {
+    std::cerr << "Texture array needs " << layers << " layers, driver allows "
+              << maxLayers << "\n";
+    return false;
+  }
+
+  // Commit
+  layerSize = size;
+  layerCount = layers;
+  atlasPacked = packed;
+  regions = std::move(built);
+  for (Source &s : sources)
+    shrinkToFit(layerSize, s.width, s.height, s.pixels);
+
+  // Compose all layers on the CPU, extending each texture's edge pixels into
+  // its gutter so filtering and the first mip levels never bleed.
+  size_t layerBytes = size_t(layerSize) * layerSize * 4;
+  std::vector<unsigned char> pixels(layerBytes * layerCount, 0);
+  for (size_t i = 0; i < sources.size(); i++) {
+    const Source &s = sources[i];
+    const Placement &p = placements[i];
+    unsigned char *layer = pixels.data() + layerBytes * p.layer;
+
+    int y0 = std::max(p.y - Gutter, 0), y1 = std::min(p.y + s.height + Gutter, layerSize);
+    int x0 = std::max(p.x - Gutter, 0), x1 = std::min(p.x + s.width + Gutter, layerSize);
+    for (int y = y0; y < y1; y++) {
+      int sy = std::clamp(y - p.y, 0, s.height - 1);
+      for (int x = x0; x < x1; x++) {
+        int sx = std::clamp(x - p.x, 0, s.width - 1);
+        std::copy_n(&s.pixels[(size_t(sy) * s.width + sx) * 4], 4,
+                    &layer[(size_t(y) * layerSize + x) * 4]);
+      }
+    }
+  }
+
+  if (!arrayTexture)
+    arrayTexture.Create("Textures");
+  glBindTexture(GL_TEXTURE_2D_ARRAY, arrayTexture);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, layerSize, layerSize,
+               static_cast<GLsizei>(layerCount), 0, GL_RGBA, GL_UNSIGNED_BYTE,
+               pixels.data());
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                  GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  // Past log2(Gutter) mips neighbouring atlas entries start to mix
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 3);
+  glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+  // Slot table: two RGBA32F texels per slot (uvRect, layer)
+  std::vector<glm::vec4> table;
+  table.reserve(regions.size() * 2);
+  for (const TextureRegion &r : regions) {
+    table.push_back(r.uvRect);
+    table.push_back(glm::vec4(static_cast<float>(r.layer), 0.0f, 0.0f, 0.0f));
+  }
+
+  if (!slotBuffer)
+    slotBuffer.Create("Textures");
+  glBindBuffer(GL_TEXTURE_BUFFER, slotBuffer);
+  glBufferData(GL_TEXTURE_BUFFER, table.size() * sizeof(glm::vec4), table.data(),
+               GL_STATIC_DRAW);
+  if (!slotTexture)
+    slotTexture.Create("Textures");
+  glBindTexture(GL_TEXTURE_BUFFER, slotTexture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, slotBuffer);
+
+  // Mip chain adds roughly a third on top of level 0
+  arrayTexture.SetBytes(pixels.size() * 4 / 3);
+  slotBuffer.SetBytes(table.size() * sizeof(glm::vec4));
+  gpuBytes = pixels.size() * 4 / 3 + table.size() * sizeof(glm::vec4);
+
+  std::cout << "SUCCESS::TEXTUREBATCHER::BUILT::" << sources.size()
+            << " textures in " << layerCount << " layers of " << layerSize
+            << "px (" << atlasPacked << " atlas packed)" << std::endl;
+  return true;
+}
+
+void TextureBatcher::Release() {
+  arrayTexture.Reset();
+  slotTexture.Reset();
+  slotBuffer.Reset();
+
+  sources.clear();
+  regions.clear();
+  layerCount = 0;
+  atlasPacked = 0;
+  gpuBytes = 0;
+}
@@ -1,5 +1,6 @@
 #include "tools/TextureManager.h"
 #include "tools/EngineConfig.h"
+#include "tools/filemanager.h"
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -20,39 +21,51 @@ static GLenum detectFormat(int nrChannels) {
   return 0; // unsupported
 }
 
-GLuint TextureLoader::loadTexture(const std::string &path, bool flip) {
+// Decodes an image from the VFS without copying the file first
+static unsigned char *loadImage(const std::string &path, int &width, int &height,
+                                int &nrChannels) {
+  AssetData file;
+  if (!VirtualFileSystem::shared().open(path, file))
+    return nullptr;
+  return stbi_load_from_memory(file.Data(), static_cast<int>(file.Size()), &width,
+                               &height, &nrChannels, 0);
+}
+
+GlTexture TextureLoader::loadTexture(const std::string &path, bool flip) {
   return loadTextureAdvanced(path, GL_REPEAT, GL_REPEAT,
                              GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, flip);
 }
 
-GLuint TextureLoader::loadTextureAdvanced(const std::string &path, GLint wrapS,
+GlTexture TextureLoader::loadTextureAdvanced(const std::string &path, GLint wrapS,
                                           GLint wrapT, GLint minFilter,
                                           GLint magFilter, bool flip) {
   stbi_set_flip_vertically_on_load(flip);
 
   int width, height, nrChannels;
-  unsigned char *data =
-      stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
+  unsigned char *data = loadImage(path, width, height, nrChannels);
 
   if (!data) {
     std::cerr << "Failed to load texture: " << path << "\n";
-    return 0;
+    return {};
   }
 
   GLenum format = detectFormat(nrChannels);
   if (format == 0) {
     std::cerr << "Unsupported channel count: " << nrChannels << "\n";
     stbi_image_free(data);
-    return 0;
+    return {};
   }
 
-  GLuint texture;
-  glGenTextures(1, &texture);
+  GlTexture texture;
+  texture.Create("TextureLoader");
   glBindTexture(GL_TEXTURE_2D, texture);
 
   glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
                GL_UNSIGNED_BYTE, data);
   glGenerateMipmap(GL_TEXTURE_2D);
+  // Base level plus roughly a third for the mip chain
+  size_t baseBytes = static_cast<size_t>(width) * height * nrChannels;
+  texture.SetBytes(baseBytes + baseBytes / 3);
 
   // Custom parameters
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapS);
@@ -64,22 +77,23 @@ GLuint TextureLoader::loadTextureAdvanced(const std::string &path, GLint wrapS,
   return texture;
 }
 
-GLuint TextureLoader::loadCubemap(const std::vector<std::string> &faces,
+GlTexture TextureLoader::loadCubemap(const std::vector<std::string> &faces,
                                   bool flip) {
   stbi_set_flip_vertically_on_load(flip);
 
-  GLuint textureID;
-  glGenTextures(1, &textureID);
+  GlTexture textureID;
+  textureID.Create("TextureLoader");
   glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
   int width, height, nrChannels;
+  size_t bytes = 0;
   for (unsigned int i = 0; i < faces.size(); i++) {
-    unsigned char *data =
-        stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
+    unsigned char *data = loadImage(faces[i], width, height, nrChannels);
     if (data) {
       GLenum format = detectFormat(nrChannels);
       glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format, width, height,
                    0, format, GL_UNSIGNED_BYTE, data);
+      bytes += static_cast<size_t>(width) * height * nrChannels;
       stbi_image_free(data);
     } else {
       std::cerr << "Cubemap failed to load: " << faces[i] << "\n";
@@ -94,5 +108,6 @@ GLuint TextureLoader::loadCubemap(const std::vector<std::string> &faces,
   glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
+  textureID.SetBytes(bytes);
   return textureID;
 }
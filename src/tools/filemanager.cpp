@@ -1,32 +1,97 @@
+#include <algorithm>
 #include <iostream>
-#include <fstream>
 #include <stdexcept>
 #include "tools/filemanager.h"
 
-VirtualFileSystem::VirtualFileSystem(const std::string& basePath) : baseDir(basePath) {
-    if (!fs::exists(baseDir)) {
-        std::cerr << "Base directory does not exist: " << fs::absolute(baseDir) << std::endl;
-        throw std::runtime_error("Base directory does not exist: " + baseDir);
-    }
-    std::cout << "BASE-DIRECTORY-FOUND::" << fs::absolute(baseDir) << std::endl;
+void AssetData::Prefetch(size_t offset, size_t length) const {
+    if (mapping)
+        mapping->Prefetch(mappingOffset + offset, std::min(length, size - std::min(offset, size)));
 }
 
+void AssetData::Close() {
+    loose.Close();
+    owned.clear();
+    data = nullptr;
+    size = 0;
+    mapping = nullptr;
+    mappingOffset = 0;
+}
 
-std::string VirtualFileSystem::getFullPath(const std::string& relativePath) const {
-    fs::path fullPath = fs::path(baseDir) / relativePath;
-    if (!fs::exists(fullPath)) {
-        throw std::runtime_error("File not found: " + fullPath.string());
+VirtualFileSystem::VirtualFileSystem(const std::string& basePath,
+                                     const std::string& archivePath) : baseDir(basePath) {
+    // An archive can stand in for the directory, so a missing root is not fatal
+    std::error_code ec;
+    if (!archivePath.empty() && fs::is_regular_file(archivePath, ec))
+        mountArchive(archivePath);
+    else if (!fs::is_directory(baseDir, ec))
+        std::cerr << "WARNING::VFS::BASE_DIRECTORY_MISSING::" << baseDir << std::endl;
+}
+
+VirtualFileSystem& VirtualFileSystem::shared() {
+    static VirtualFileSystem vfs("../assets", "../assets.rbpak");
+    return vfs;
+}
+
+bool VirtualFileSystem::mountArchive(const std::string& archivePath) {
+    return archive.Open(archivePath);
+}
+
+bool VirtualFileSystem::open(const std::string& relativePath, AssetData& out) const {
+    out.Close();
+
+    if (const AssetArchive::Entry* entry = archive.Find(relativePath)) {
+        const uint8_t* blob = archive.File().Data() + entry->offset;
+        if (entry->flags & AssetArchive::Compressed) {
+            out.owned.resize(entry->size);
+            if (!AssetArchive::Lz4Decompress(blob, entry->storedSize, out.owned.data(),
+                                             out.owned.size())) {
+                std::cerr << "ERROR::VFS::CORRUPT_ENTRY::" << relativePath << std::endl;
+                out.owned.clear();
+                return false;
+            }
+            out.data = out.owned.data();
+        } else {
+            out.data = blob;
+            out.mapping = &archive.File();
+            out.mappingOffset = entry->offset;
+        }
+        out.size = entry->size;
+        return true;
+    }
+
+    // Loose files: under the root first, then the path as given
+    for (const fs::path& candidate : {fs::path(baseDir) / relativePath, fs::path(relativePath)}) {
+        std::error_code ec;
+        if (!fs::is_regular_file(candidate, ec))
+            continue;
+        if (!out.loose.Open(candidate.string()))
+            return false;
+        out.data = out.loose.Data();
+        out.size = out.loose.Size();
+        out.mapping = &out.loose;
+        return true;
     }
-    // Return the absolute path instead of a relative one.
-    return fs::absolute(fullPath).string();
+
+    std::cerr << "ERROR::VFS::NOT_FOUND::" << relativePath << std::endl;
+    return false;
 }
 
+bool VirtualFileSystem::exists(const std::string& relativePath) const {
+    if (archive.Find(relativePath))
+        return true;
+    std::error_code ec;
+    return fs::is_regular_file(fs::path(baseDir) / relativePath, ec) ||
+           fs::is_regular_file(relativePath, ec);
+}
+
+std::string VirtualFileSystem::getFullPath(const std::string& relativePath) const {
+    return (fs::path(baseDir) / relativePath).string();
+}
 
 std::string VirtualFileSystem::readFile(const std::string& relativePath) {
-    std::string fullPath = getFullPath(relativePath);
-    std::ifstream file(fullPath);
-    if (!file.is_open()) {
-        throw std::runtime_error("Could not open file: " + fullPath);
+    AssetData asset;
+    if (!open(relativePath, asset)) {
+        throw std::runtime_error("Could not open file: " + relativePath);
     }
-    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return std::string(asset.Text());
 }